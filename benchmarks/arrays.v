@@ -0,0 +1,12 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+sum = 0;
+i = 0;
+while i < 20000
+{
+    a = [i, i + 1, i + 2, [i, i * 2], "x", 7];
+    sum = sum + a[0] + a[2] + a[3][1] + a.length;
+    i = i + 1;
+}
+
+puts("sum = " ~ sum.string);
@@ -0,0 +1,659 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// Front-end throughput benchmark. Generates deterministic synthetic sources
+// and measures scanning, tokenizing, parsing and AST teardown separately.
+// Peak RSS is measured per stage, each stage running once in a child forked
+// before any workload ran, which generates its own copy of the source;
+// "baseline" is a child that only generates it.
+//
+// Usage: vanilla_bench_frontend [--size-mb=N] [--iterations=N] [--seed=N]
+//                               [--output=FILE]
+
+// C++ Standard Library:
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+
+// System:
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Vanilla:
+#include <vanilla/parsing.hpp>
+#include <vanilla/scanner.hpp>
+
+namespace
+{
+    ///////////////////////////////////////////////////////////////////////
+    // Source generation.
+    ///////////////////////////////////////////////////////////////////////
+    
+    // xorshift64*, so that sources are identical on every platform.
+    class random_source
+    {
+    private:
+        std::uint64_t _state;
+        
+    public:
+        explicit random_source(std::uint64_t seed)
+            : _state(seed ? seed : 0x9E3779B97F4A7C15ULL)
+        { }
+        
+        std::uint64_t next()
+        {
+            _state ^= _state >> 12;
+            _state ^= _state << 25;
+            _state ^= _state >> 27;
+            return _state * 0x2545F4914F6CDD1DULL;
+        }
+        
+        unsigned below(unsigned n)
+        {
+            return next() % n;
+        }
+    };
+    
+    std::string identifier(random_source& r, unsigned min_length, unsigned max_length)
+    {
+        static char const first[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
+        static char const rest[] = "abcdefghijklmnopqrstuvwxyz0123456789_";
+        
+        unsigned length = min_length + r.below(max_length - min_length + 1);
+        std::string result(1, first[r.below(sizeof(first) - 1)]);
+        for(unsigned i = 1; i < length; ++i)
+            result += rest[r.below(sizeof(rest) - 1)];
+        
+        // Keep clear of keywords.
+        result += '_';
+        return result;
+    }
+    
+    std::string literal(random_source& r)
+    {
+        switch(r.below(6))
+        {
+            case 0: return std::to_string(r.next() % 1000000);
+            case 1: return "0x" + std::to_string(r.below(9) + 1) + "fA3";
+            case 2: return "0b1011" + std::to_string(r.below(2));
+            case 3: return std::to_string(r.below(1000)) + '.' + std::to_string(r.below(1000));
+            case 4: return "\"str" + std::to_string(r.below(100)) + "\\n\"";
+            default: return r.below(2) ? "true" : "false";
+        }
+    }
+    
+    // Long identifiers in assignments, calls and element selections.
+    void generate_identifier_heavy(std::string& o, random_source& r)
+    {
+        std::string target = identifier(r, 8, 24);
+        std::string callee = identifier(r, 8, 24);
+        o += target + " = " + callee + '(' + identifier(r, 4, 16) + ", "
+            + identifier(r, 4, 16) + '.' + identifier(r, 4, 12) + ", "
+            + identifier(r, 4, 16) + '[' + identifier(r, 4, 8) + "]);\n";
+    }
+    
+    void generate_literal_heavy(std::string& o, random_source& r)
+    {
+        o += identifier(r, 2, 4) + " = [";
+        unsigned count = 8 + r.below(24);
+        for(unsigned i = 0; i < count; ++i)
+        {
+            if(i != 0)
+                o += ", ";
+            o += literal(r);
+        }
+        o += "];\n";
+    }
+    
+    void generate_nested_expression(std::string& o, random_source& r, unsigned depth)
+    {
+        if(depth == 0)
+        {
+            o += literal(r);
+            return;
+        }
+        
+        switch(r.below(4))
+        {
+            case 0:
+                o += '(';
+                generate_nested_expression(o, r, depth - 1);
+                o += " + 1)";
+                break;
+            case 1:
+                o += '[';
+                generate_nested_expression(o, r, depth - 1);
+                o += ']';
+                break;
+            case 2:
+                o += "f_(";
+                generate_nested_expression(o, r, depth - 1);
+                o += ')';
+                break;
+            default:
+                o += "(a_ < b_ ? ";
+                generate_nested_expression(o, r, depth - 1);
+                o += " : 0)";
+                break;
+        }
+    }
+    
+    void generate_nested_statement(std::string& o, random_source& r, unsigned depth)
+    {
+        if(depth == 0)
+        {
+            o += "x_ = ";
+            generate_nested_expression(o, r, 32);
+            o += ";\n";
+            return;
+        }
+        
+        switch(r.below(3))
+        {
+            case 0:
+                o += "if x_ < " + std::to_string(depth) + " {\n";
+                generate_nested_statement(o, r, depth - 1);
+                o += "} else {\n";
+                generate_nested_statement(o, r, depth - 1);
+                o += "}\n";
+                break;
+            case 1:
+                o += "while x_ > 0 {\n";
+                generate_nested_statement(o, r, depth - 1);
+                o += "}\n";
+                break;
+            default:
+                o += "function " + identifier(r, 4, 8) + "(a_, b_ = 2) {\n";
+                generate_nested_statement(o, r, depth - 1);
+                o += "return a_;\n}\n";
+                break;
+        }
+    }
+    
+    void generate_deeply_nested(std::string& o, random_source& r)
+    {
+        generate_nested_statement(o, r, 8);
+    }
+    
+    void generate_expression_chain(std::string& o, random_source& r)
+    {
+        static char const* const ops[] = { " + ", " - ", " * ", " / ", " ~ ", " < ", " == " };
+        
+        o += identifier(r, 2, 6) + " = ";
+        unsigned terms = 200 + r.below(300);
+        for(unsigned i = 0; i < terms; ++i)
+        {
+            if(i != 0)
+                o += ops[r.below(sizeof(ops) / sizeof(*ops))];
+            o += r.below(2) ? identifier(r, 1, 6) : literal(r);
+        }
+        o += ";\n";
+    }
+    
+    void generate_large_string(std::string& o, random_source& r)
+    {
+        static char const text[] = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ 0123456789.,;:-+";
+        
+        o += identifier(r, 2, 6) + " = \"";
+        unsigned length = 16 * 1024 + r.below(48 * 1024);
+        for(unsigned i = 0; i < length; ++i)
+        {
+            unsigned c = r.below(64);
+            if(c == 0)
+                o += "\\t";
+            else if(c == 1)
+                o += "\\\"";
+            else
+                o += text[r.below(sizeof(text) - 1)];
+        }
+        o += "\";\n";
+    }
+    
+    struct workload
+    {
+        char const* name;
+        void (*generate_chunk)(std::string&, random_source&);
+    };
+    
+    workload const workloads[] =
+    {
+        { "identifier_heavy", generate_identifier_heavy },
+        { "literal_heavy", generate_literal_heavy },
+        { "deeply_nested", generate_deeply_nested },
+        { "expression_chains", generate_expression_chain },
+        { "large_strings", generate_large_string }
+    };
+    
+    std::string generate(workload const& w, std::size_t size, std::uint64_t seed)
+    {
+        random_source r(seed);
+        std::string result;
+        result.reserve(size + 64 * 1024);
+        while(result.size() < size)
+            w.generate_chunk(result, r);
+        return result;
+    }
+    
+    ///////////////////////////////////////////////////////////////////////
+    // Measurement.
+    ///////////////////////////////////////////////////////////////////////
+    
+    class node_counter : public vanilla::ast_visitor
+    {
+    private:
+        std::size_t _count;
+        
+        void count(vanilla::binary_expression_node* n)
+        {
+            ++_count;
+            n->get_left()->accept(this);
+            n->get_right()->accept(this);
+        }
+        
+        void count(std::vector<std::pair<std::string, vanilla::expression_node::ptr>> const& args)
+        {
+            for(auto const& cur : args)
+            {
+                if(cur.second)
+                    cur.second->accept(this);
+            }
+        }
+        
+    public:
+        node_counter()
+            : _count(0)
+        { }
+        
+        std::size_t get() const
+        {
+            return _count;
+        }
+        
+        // Nullary expressions.
+        virtual void visit(vanilla::variable_expression_node*) override { ++_count; }
+        virtual void visit(vanilla::int_expression_node*) override { ++_count; }
+        virtual void visit(vanilla::float_expression_node*) override { ++_count; }
+        virtual void visit(vanilla::string_expression_node*) override { ++_count; }
+        virtual void visit(vanilla::bool_expression_node*) override { ++_count; }
+        
+        virtual void visit(vanilla::array_expression_node* n) override
+        {
+            ++_count;
+            for(auto& cur : n->values())
+                cur->accept(this);
+        }
+        
+        virtual void visit(vanilla::dict_expression_node* n) override
+        {
+            ++_count;
+            for(auto& cur : n->keys())
+                cur->accept(this);
+            for(auto& cur : n->values())
+                cur->accept(this);
+        }
+        
+        // Unary expressions.
+        virtual void visit(vanilla::negation_expression_node* n) override
+        {
+            ++_count;
+            n->get_child()->accept(this);
+        }
+        
+        virtual void visit(vanilla::abs_expression_node* n) override
+        {
+            ++_count;
+            n->get_child()->accept(this);
+        }
+        
+        // Binary expressions.
+        virtual void visit(vanilla::addition_expression_node* n) override { count(n); }
+        virtual void visit(vanilla::subtraction_expression_node* n) override { count(n); }
+        virtual void visit(vanilla::multiplication_expression_node* n) override { count(n); }
+        virtual void visit(vanilla::division_expression_node* n) override { count(n); }
+        virtual void visit(vanilla::concatenation_expression_node* n) override { count(n); }
+        virtual void visit(vanilla::lessthan_expression_node* n) override { count(n); }
+        virtual void visit(vanilla::lessequal_expression_node* n) override { count(n); }
+        virtual void visit(vanilla::greaterthan_expression_node* n) override { count(n); }
+        virtual void visit(vanilla::greaterequal_expression_node* n) override { count(n); }
+        virtual void visit(vanilla::equality_expression_node* n) override { count(n); }
+        virtual void visit(vanilla::inequality_expression_node* n) override { count(n); }
+        
+        // Function expressions.
+        virtual void visit(vanilla::function_call_expression_node* n) override
+        {
+            ++_count;
+            n->get_function()->accept(this);
+            for(auto& cur : n->get_args())
+                cur->accept(this);
+        }
+        
+        virtual void visit(vanilla::function_definition_expression_node* n) override
+        {
+            ++_count;
+            count(n->get_arguments());
+            n->get_body()->accept(this);
+        }
+        
+        virtual void visit(vanilla::native_function_definition_expression_node*) override
+        {
+            ++_count;
+        }
+        
+        // Other expressions.
+        virtual void visit(vanilla::conditional_expression_node* n) override
+        {
+            ++_count;
+            n->get_condition()->accept(this);
+            n->get_expression()->accept(this);
+            n->get_else()->accept(this);
+        }
+        
+        virtual void visit(vanilla::subscript_expression_node* n) override
+        {
+            ++_count;
+            n->get_expression()->accept(this);
+            n->get_subscript()->accept(this);
+        }
+        
+        virtual void visit(vanilla::element_selection_expression_node* n) override
+        {
+            ++_count;
+            n->get_left()->accept(this);
+        }
+    
+        // Statements.
+        virtual void visit(vanilla::return_statement_node* n) override
+        {
+            ++_count;
+            n->get_expression()->accept(this);
+        }
+        
+        virtual void visit(vanilla::statement_sequence_node* n) override
+        {
+            ++_count;
+            for(auto& cur : n->get_code())
+                cur->accept(this);
+        }
+        
+        virtual void visit(vanilla::if_statement_node* n) override
+        {
+            ++_count;
+            for(auto const& cur : n->get_ifs())
+            {
+                cur.first->accept(this);
+                cur.second->accept(this);
+            }
+            if(n->get_else())
+                n->get_else()->accept(this);
+        }
+        
+        virtual void visit(vanilla::while_statement_node* n) override
+        {
+            ++_count;
+            n->get_condition()->accept(this);
+            n->get_code()->accept(this);
+        }
+        
+        virtual void visit(vanilla::function_definition_statement_node* n) override
+        {
+            ++_count;
+            count(n->get_arguments());
+            n->get_body()->accept(this);
+        }
+        
+        virtual void visit(vanilla::assignment_statement_node* n) override
+        {
+            ++_count;
+            n->get_left()->accept(this);
+            n->get_right()->accept(this);
+        }
+    };
+    
+    typedef std::chrono::steady_clock bench_clock;
+    
+    double seconds_since(bench_clock::time_point start)
+    {
+        return std::chrono::duration<double>(bench_clock::now() - start).count();
+    }
+    
+    // Runs f in a forked child and returns the child's peak RSS, or -1 if it
+    // didn't run to completion. getrusage(RUSAGE_SELF) would only give the
+    // peak of the whole process so far.
+    template<typename F>
+    long peak_rss_kb(F f)
+    {
+        pid_t pid = fork();
+        if(pid == -1)
+            return -1;
+        
+        if(pid == 0)
+        {
+            try
+            {
+                f();
+            }
+            catch(...)
+            {
+                _exit(1);
+            }
+            _exit(0);
+        }
+        
+        int status;
+        struct rusage usage;
+        if(wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            return -1;
+        return usage.ru_maxrss;
+    }
+    
+    struct peak_rss
+    {
+        long baseline;
+        long scan;
+        long tokenize;
+        long parse;
+        long parse_lazy;
+    };
+    
+    peak_rss measure_peak_rss(workload const& w, std::size_t size, std::uint64_t seed)
+    {
+        peak_rss res;
+        res.baseline = peak_rss_kb([&]()
+        {
+            generate(w, size, seed);
+        });
+        res.scan = peak_rss_kb([&]()
+        {
+            std::string text = generate(w, size, seed);
+            vanilla::scanner scan(vanilla::cstr_range(text.data(), text.data() + text.size()));
+            while(scan.get_token().type != vanilla::ttype::eof)
+                ;
+        });
+        res.tokenize = peak_rss_kb([&]()
+        {
+            std::string text = generate(w, size, seed);
+            vanilla::detail::tokenize_source(text);
+        });
+        res.parse = peak_rss_kb([&]()
+        {
+            std::string text = generate(w, size, seed);
+            vanilla::parse_string(text.c_str(), false);
+        });
+        res.parse_lazy = peak_rss_kb([&]()
+        {
+            std::string text = generate(w, size, seed);
+            vanilla::parse_string(text.c_str(), true);
+        });
+        return res;
+    }
+    
+    // Best of all iterations, which is the least noisy on a busy machine.
+    struct result
+    {
+        std::size_t bytes;
+        std::size_t tokens;
+        std::size_t nodes;
+        double scan;
+        double tokenize;
+        double parse;
+        double parse_lazy;
+        double teardown;
+    };
+    
+    result run(std::string const& text, unsigned iterations)
+    {
+        result res = { text.size(), 0, 0, 1e30, 1e30, 1e30, 1e30, 1e30 };
+        
+        for(unsigned i = 0; i < iterations; ++i)
+        {
+            bench_clock::time_point start = bench_clock::now();
+            vanilla::scanner scan(vanilla::cstr_range(text.data(), text.data() + text.size()));
+            std::size_t tokens = 1;
+            while(scan.get_token().type != vanilla::ttype::eof)
+                ++tokens;
+            res.scan = std::min(res.scan, seconds_since(start));
+            res.tokens = tokens;
+            
+            start = bench_clock::now();
+            auto source = vanilla::detail::tokenize_source(text);
+            res.tokenize = std::min(res.tokenize, seconds_since(start));
+            source.reset();
+            
+            start = bench_clock::now();
+            vanilla::statement_node::ptr program = vanilla::parse_string(text.c_str(), false);
+            res.parse = std::min(res.parse, seconds_since(start));
+            
+            node_counter counter;
+            program->accept(&counter);
+            res.nodes = counter.get();
+            
+            start = bench_clock::now();
+            program.reset();
+            res.teardown = std::min(res.teardown, seconds_since(start));
+            
+            start = bench_clock::now();
+            program = vanilla::parse_string(text.c_str(), true);
+            res.parse_lazy = std::min(res.parse_lazy, seconds_since(start));
+        }
+        
+        return res;
+    }
+    
+    void print_rates(std::ostream& o, char const* name, double seconds, result const& res,
+        bool tokens, bool nodes)
+    {
+        o << "      \"" << name << "\": { \"seconds\": " << seconds
+          << ", \"mb_per_s\": " << res.bytes / seconds / (1024.0 * 1024.0);
+        if(tokens)
+            o << ", \"tokens_per_s\": " << res.tokens / seconds;
+        if(nodes)
+            o << ", \"nodes_per_s\": " << res.nodes / seconds;
+        o << " }";
+    }
+    
+    bool parse_option(char const* arg, char const* name, char const*& value)
+    {
+        std::size_t length = std::strlen(name);
+        if(std::strncmp(arg, name, length) != 0 || arg[length] != '=')
+            return false;
+        value = arg + length + 1;
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t size_mb = 4;
+    unsigned iterations = 5;
+    std::uint64_t seed = 42;
+    std::string output;
+    
+    for(int i = 1; i < argc; ++i)
+    {
+        char const* value;
+        if(parse_option(argv[i], "--size-mb", value))
+            size_mb = std::strtoul(value, nullptr, 10);
+        else if(parse_option(argv[i], "--iterations", value))
+            iterations = std::max(1ul, std::strtoul(value, nullptr, 10));
+        else if(parse_option(argv[i], "--seed", value))
+            seed = std::strtoull(value, nullptr, 10);
+        else if(parse_option(argv[i], "--output", value))
+            output = value;
+        else
+        {
+            std::cerr   << "Usage: " << argv[0]
+                        << " [--size-mb=N] [--iterations=N] [--seed=N] [--output=FILE]\n";
+            return -1;
+        }
+    }
+    
+    std::ofstream file;
+    if(!output.empty())
+        file.open(output);
+    std::ostream& o = output.empty() ? std::cout : file;
+    
+    o << "{\n  \"size_mb\": " << size_mb << ",\n  \"iterations\": " << iterations
+      << ",\n  \"seed\": " << seed << ",\n  \"workloads\": {\n";
+    
+    // Forked before the timing runs, so that the children don't start out
+    // with their memory.
+    std::size_t count = sizeof(workloads) / sizeof(*workloads);
+    std::vector<peak_rss> rss;
+    for(std::size_t i = 0; i < count; ++i)
+        rss.push_back(measure_peak_rss(workloads[i], size_mb * 1024 * 1024, seed));
+    
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        std::string text = generate(workloads[i], size_mb * 1024 * 1024, seed);
+        result res = run(text, iterations);
+        
+        o << "    \"" << workloads[i].name << "\": {\n"
+          << "      \"bytes\": " << res.bytes << ",\n"
+          << "      \"tokens\": " << res.tokens << ",\n"
+          << "      \"nodes\": " << res.nodes << ",\n";
+        print_rates(o, "scanner", res.scan, res, true, false);
+        o << ",\n";
+        print_rates(o, "token_buffer", res.tokenize, res, true, false);
+        o << ",\n";
+        print_rates(o, "parse_string", res.parse, res, true, true);
+        o << ",\n";
+        print_rates(o, "parse_string_lazy", res.parse_lazy, res, true, false);
+        o << ",\n";
+        print_rates(o, "teardown", res.teardown, res, false, true);
+        o << ",\n      \"peak_rss_kb\": { \"baseline\": " << rss[i].baseline
+          << ", \"scanner\": " << rss[i].scan
+          << ", \"token_buffer\": " << rss[i].tokenize
+          << ", \"parse_string\": " << rss[i].parse
+          << ", \"parse_string_lazy\": " << rss[i].parse_lazy << " }\n    }"
+          << (i + 1 != count ? ",\n" : "\n");
+    }
+    
+    o << "  }\n}\n";
+}
@@ -0,0 +1,284 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// Runs the benchmark scripts under the vanilla interpreter and records wall
+// time, user/sys time and peak RSS as JSON. With a baseline from an earlier
+// run, scripts which got slower or bigger than the threshold are reported
+// and the exit code is 1.
+//
+// Usage: vanilla_bench_runner --vanilla=PATH [--runs=N] [--output=FILE]
+//                             [--baseline=FILE] [--threshold=FRACTION]
+//                             SCRIPT...
+
+// C++ Standard Library:
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+
+// System:
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    struct sample
+    {
+        double wall;
+        double user;
+        double sys;
+        long peak_rss_kb;
+    };
+    
+    struct summary
+    {
+        std::string name;
+        bool ok;
+        double wall;
+        double wall_min;
+        double user;
+        double sys;
+        long peak_rss_kb;
+        bool regression;
+    };
+    
+    struct baseline_entry
+    {
+        double wall;
+        long peak_rss_kb;
+    };
+    
+    double seconds(timeval const& tv)
+    {
+        return tv.tv_sec + tv.tv_usec / 1e6;
+    }
+    
+    // Runs the interpreter once with the output discarded. Returns false if
+    // it could not be started or didn't exit successfully.
+    bool run_once(std::string const& vanilla, std::string const& script, sample& s)
+    {
+        auto start = std::chrono::steady_clock::now();
+        
+        pid_t pid = fork();
+        if(pid == -1)
+            return false;
+        
+        if(pid == 0)
+        {
+            int null = open("/dev/null", O_WRONLY);
+            if(null != -1)
+                dup2(null, STDOUT_FILENO);
+            
+            // The cache would hide parse time, which is part of the workload.
+            char const* args[] = { vanilla.c_str(), "--no-cache", script.c_str(), nullptr };
+            execv(vanilla.c_str(), const_cast<char**>(args));
+            _exit(127);
+        }
+        
+        int status;
+        struct rusage usage;
+        if(wait4(pid, &status, 0, &usage) != pid)
+            return false;
+        
+        s.wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        s.user = seconds(usage.ru_utime);
+        s.sys = seconds(usage.ru_stime);
+        s.peak_rss_kb = usage.ru_maxrss;
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    
+    double median(std::vector<double> v)
+    {
+        std::sort(v.begin(), v.end());
+        std::size_t mid = v.size() / 2;
+        return v.size() % 2 ? v[mid] : (v[mid - 1] + v[mid]) / 2;
+    }
+    
+    std::string script_name(std::string const& path)
+    {
+        std::size_t begin = path.find_last_of('/');
+        begin = begin == std::string::npos ? 0 : begin + 1;
+        std::size_t end = path.rfind(".v");
+        if(end == std::string::npos || end < begin)
+            end = path.size();
+        return path.substr(begin, end - begin);
+    }
+    
+    // Reads the output of an earlier run. Every script is on a line of its
+    // own, so this doesn't need a full JSON parser.
+    std::map<std::string, baseline_entry> read_baseline(std::string const& filename)
+    {
+        std::map<std::string, baseline_entry> result;
+        std::ifstream in(filename);
+        for(std::string line; std::getline(in, line); )
+        {
+            std::size_t open = line.find('"');
+            std::size_t close = line.find('"', open + 1);
+            std::size_t wall = line.find("\"wall\": ");
+            std::size_t rss = line.find("\"peak_rss_kb\": ");
+            if(open == std::string::npos || close == std::string::npos
+                || wall == std::string::npos || rss == std::string::npos)
+                continue;
+            
+            baseline_entry entry;
+            entry.wall = std::atof(line.c_str() + wall + std::strlen("\"wall\": "));
+            entry.peak_rss_kb = std::atol(line.c_str() + rss + std::strlen("\"peak_rss_kb\": "));
+            result[line.substr(open + 1, close - open - 1)] = entry;
+        }
+        
+        return result;
+    }
+    
+    bool parse_option(char const* arg, char const* name, char const*& value)
+    {
+        std::size_t length = std::strlen(name);
+        if(std::strncmp(arg, name, length) != 0 || arg[length] != '=')
+            return false;
+        value = arg + length + 1;
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string vanilla;
+    unsigned runs = 5;
+    std::string output;
+    std::string baseline;
+    double threshold = 0.1;
+    std::vector<std::string> scripts;
+    
+    for(int i = 1; i < argc; ++i)
+    {
+        char const* value;
+        if(parse_option(argv[i], "--vanilla", value))
+            vanilla = value;
+        else if(parse_option(argv[i], "--runs", value))
+            runs = std::max(1ul, std::strtoul(value, nullptr, 10));
+        else if(parse_option(argv[i], "--output", value))
+            output = value;
+        else if(parse_option(argv[i], "--baseline", value))
+            baseline = value;
+        else if(parse_option(argv[i], "--threshold", value))
+            threshold = std::atof(value);
+        else if(std::strncmp(argv[i], "--", 2) != 0)
+            scripts.push_back(argv[i]);
+        else
+            vanilla.clear(), scripts.clear(), i = argc;
+    }
+    
+    if(vanilla.empty() || scripts.empty())
+    {
+        std::cerr   << "Usage: " << argv[0] << " --vanilla=PATH [--runs=N] [--output=FILE]"
+                    << " [--baseline=FILE] [--threshold=FRACTION] SCRIPT...\n";
+        return -1;
+    }
+    
+    std::map<std::string, baseline_entry> base;
+    if(!baseline.empty())
+    {
+        base = read_baseline(baseline);
+        if(base.empty())
+            std::cerr << "No baseline in '" << baseline << "', nothing to compare against\n";
+    }
+    
+    std::vector<summary> results;
+    bool failed = false;
+    for(std::string const& script : scripts)
+    {
+        summary sum = { script_name(script), true, 0, 0, 0, 0, 0, false };
+        std::vector<double> wall, user, sys;
+        for(unsigned i = 0; i < runs && sum.ok; ++i)
+        {
+            sample s;
+            sum.ok = run_once(vanilla, script, s);
+            wall.push_back(s.wall);
+            user.push_back(s.user);
+            sys.push_back(s.sys);
+            sum.peak_rss_kb = std::max(sum.peak_rss_kb, s.peak_rss_kb);
+        }
+        
+        if(!sum.ok)
+        {
+            std::cerr << sum.name << ": FAILED\n";
+            failed = true;
+            results.push_back(sum);
+            continue;
+        }
+        
+        sum.wall = median(wall);
+        sum.wall_min = *std::min_element(wall.begin(), wall.end());
+        sum.user = median(user);
+        sum.sys = median(sys);
+        
+        std::fprintf(stderr, "%-20s wall %8.4fs  user %8.4fs  sys %8.4fs  rss %8ld KiB",
+            sum.name.c_str(), sum.wall, sum.user, sum.sys, sum.peak_rss_kb);
+        
+        auto iter = base.find(sum.name);
+        if(iter != base.end())
+        {
+            double wall_change = sum.wall / iter->second.wall - 1;
+            double rss_change = double(sum.peak_rss_kb) / iter->second.peak_rss_kb - 1;
+            std::fprintf(stderr, "  (wall %+.1f%%, rss %+.1f%%)", wall_change * 100, rss_change * 100);
+            
+            if(wall_change > threshold || rss_change > threshold)
+            {
+                sum.regression = true;
+                std::fprintf(stderr, "  REGRESSION");
+            }
+        }
+        
+        std::fprintf(stderr, "\n");
+        results.push_back(sum);
+    }
+    
+    std::ofstream file;
+    if(!output.empty())
+        file.open(output);
+    std::ostream& o = output.empty() ? std::cout : file;
+    
+    o << "{\n  \"runs\": " << runs << ",\n  \"scripts\": {\n";
+    for(std::size_t i = 0; i < results.size(); ++i)
+    {
+        summary const& sum = results[i];
+        o << "    \"" << sum.name << "\": { \"ok\": " << (sum.ok ? "true" : "false")
+          << ", \"wall\": " << sum.wall << ", \"wall_min\": " << sum.wall_min
+          << ", \"user\": " << sum.user << ", \"sys\": " << sum.sys
+          << ", \"peak_rss_kb\": " << sum.peak_rss_kb
+          << ", \"regression\": " << (sum.regression ? "true" : "false") << " }"
+          << (i + 1 != results.size() ? ",\n" : "\n");
+    }
+    o << "  }\n}\n";
+    
+    bool regressed = std::any_of(results.begin(), results.end(),
+        [](summary const& s) { return s.regression; });
+    return failed || regressed ? 1 : 0;
+}
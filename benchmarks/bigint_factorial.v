@@ -0,0 +1,21 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+function factorial(n)
+{
+    result = 1;
+    while n > 1
+    {
+        result = result * n;
+        n = n - 1;
+    }
+    return result;
+}
+
+i = 0;
+while i < 20
+{
+    f = factorial(2000);
+    i = i + 1;
+}
+
+puts("2000! = " ~ f.string);
@@ -0,0 +1,17 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+function depth(n)
+{
+    if n == 0 { return 0; }
+    return depth(n - 1) + 1;
+}
+
+i = 0;
+total = 0;
+while i < 50
+{
+    total = total + depth(1000);
+    i = i + 1;
+}
+
+puts("total = " ~ total.string);
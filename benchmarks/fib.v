@@ -0,0 +1,9 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+function fib(n)
+{
+    if n < 2 { return n; }
+    return fib(n - 1) + fib(n - 2);
+}
+
+puts("fib(22) = " ~ fib(22).string);
@@ -0,0 +1,11 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+sum = 0;
+i = 0;
+while i < 200000
+{
+    sum = sum + i * 3 - i;
+    i = i + 1;
+}
+
+puts("sum = " ~ sum.string);
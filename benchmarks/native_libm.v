@@ -0,0 +1,13 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+sqrt = native "sqrt" from "libm.so.6" declared "double" ("double");
+lround = native "lround" from "libm.so.6" declared "long" ("double");
+
+i = 0;
+count = 0;
+while i < 50000
+{
+    count = count + lround(sqrt(i));
+    i = i + 1;
+}
+
+puts("count = " ~ count.string);
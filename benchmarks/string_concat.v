@@ -0,0 +1,11 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+s = "";
+i = 0;
+while i < 20000
+{
+    s = s ~ "line " ~ i.string ~ "\n";
+    i = i + 1;
+}
+
+puts(s);
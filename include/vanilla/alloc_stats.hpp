@@ -0,0 +1,74 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_5EE497010EB849BCB1DEC84F3AE4EF85
+#define HEADER_UUID_5EE497010EB849BCB1DEC84F3AE4EF85
+
+// C++ Standard Library:
+#include <cstddef>
+#include <ostream>
+
+namespace vanilla
+{
+    class object;
+    class object_ptr;
+    
+    // Allocation accounting. While enabled, allocate_object reports the size
+    // of every object by type and optionally by the statement that was
+    // executing, and flags the object so its release is reported as well.
+    // Disabled, allocate_object only tests detail::active.
+    //
+    // Accounting is meant for the evaluator thread; enable it after parsing.
+    namespace alloc_stats
+    {
+        enum class mode
+        {
+            off,
+            types,  // Per object_type_id.
+            sites   // Also per allocating statement (line/pos).
+        };
+        
+        namespace detail
+        {
+            extern bool active;
+            
+            void allocated(object& obj, std::size_t bytes);
+            void deallocated(object const& obj);
+        }
+        
+        // Resets all counters.
+        void enable(mode m);
+        
+        mode current_mode();
+        
+        // Human readable tables, sorted by live bytes.
+        void write_report(std::ostream& o);
+        
+        // An array holding [type, live, total, live bytes, total bytes] per
+        // type. Empty while accounting is off.
+        object_ptr snapshot();
+        
+        // The builtin exposing snapshot() to scripts.
+        object_ptr make_snapshot_function();
+    }
+}
+
+#endif // HEADER_UUID_5EE497010EB849BCB1DEC84F3AE4EF85
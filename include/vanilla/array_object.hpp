@@ -23,6 +23,8 @@
 #define HEADER_UUID_E9DE315493894E35B07193390513AD78
 
 // C++ Standard Library:
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 // Vanilla:
@@ -30,18 +32,81 @@
 
 namespace vanilla
 {
+    // The element slots are stored right after the object, see
+    // object_size<array_object>. append moves them to a heap buffer once
+    // they don't fit anymore.
+    //
+    // Shallow copies are copy-on-write: a copy borrows the slots of the
+    // array that owns them (its store) and only gets slots of its own when
+    // it is changed. The owner lends its current slots and can't change
+    // them anymore while they're borrowed, it moves to new slots instead.
     class array_object : public object
     {
     public:
         typedef std::vector<object::ptr> array_type;
         
+        struct borrow_tag { };
+        
     private:
-        array_type _v;
+        std::size_t _size;
+        std::size_t _capacity;  // 0 while borrowing.
+        object::ptr* _slots;
+        
+        // The array whose slots are borrowed, or null.
+        object::ptr _store;
+        
+        // The slots lent to copies, or null. Released once the owner
+        // notices that they're not borrowed anymore.
+        mutable object::ptr* _lent;
+        mutable std::size_t _lent_size;
+        mutable std::atomic<std::uint32_t> _borrowers;
+        
+        object::ptr* inline_slots() const
+        {
+            return reinterpret_cast<object::ptr*>(
+                reinterpret_cast<char*>(const_cast<array_object*>(this)) + sizeof(array_object));
+        }
+        
+        void grow();
+        
+        // Gives the array slots of its own that it may change.
+        void make_writable();
+        
+        void return_slots();
+        void release_lent() const;
         
     public:
+        // Empty slots, to be set before the array is used.
+        explicit array_object(std::size_t size);
         explicit array_object(array_type v);
         
-        array_type const& value() const;
+        // Borrows the slots of store, see copy.
+        array_object(borrow_tag, array_object const& store);
+        
+        ~array_object();
+        
+        std::size_t size() const
+        {
+            return _size;
+        }
+        
+        object::ptr const* begin() const
+        {
+            return _slots;
+        }
+        
+        object::ptr const* end() const
+        {
+            return _slots + _size;
+        }
+        
+        // Unchecked, for filling a new array.
+        void set(std::size_t index, ptr value)
+        {
+            _slots[index] = std::move(value);
+        }
+        
+        void append(ptr value);
         
         virtual object_type_id type_id() const override;
         virtual ptr type_name() const override;
@@ -55,6 +120,30 @@ namespace vanilla
         // Element selection.
         virtual ptr eget(std::string const& name);
         virtual void eset(std::string const& name, ptr value);
+        
+        virtual bool is_container() const override;
+        virtual void traverse(object_visitor& v) const override;
+        virtual void release_references() override;
+        virtual std::size_t memory_size() const override;
+    };
+    
+    template<>
+    struct object_size<array_object>
+    {
+        static std::size_t get(std::size_t size)
+        {
+            return sizeof(array_object) + size * sizeof(object::ptr);
+        }
+        
+        static std::size_t get(array_object::array_type const& v)
+        {
+            return get(v.size());
+        }
+        
+        static std::size_t get(array_object::borrow_tag, array_object const&)
+        {
+            return sizeof(array_object);
+        }
     };
 }
 
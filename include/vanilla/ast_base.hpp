@@ -31,6 +31,7 @@ namespace vanilla
     class string_expression_node;
     class bool_expression_node;
     class array_expression_node;
+    class dict_expression_node;
     
     // Unary expression forwarding.
     class negation_expression_node;
@@ -79,6 +80,7 @@ namespace vanilla
         virtual void visit(string_expression_node*) = 0;
         virtual void visit(bool_expression_node*) = 0;
         virtual void visit(array_expression_node*) = 0;
+        virtual void visit(dict_expression_node*) = 0;
         
         // Unary expressions.
         virtual void visit(negation_expression_node*) = 0;
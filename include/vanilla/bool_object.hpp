@@ -51,6 +51,9 @@ namespace vanilla
         virtual ptr to_bool() const override;
         
         bool_type value() const;
+        
+        virtual std::size_t hash() const override;
+        virtual bool equals(object const& other) const override;
     };
     
     bool_object::bool_type bool_object_to_cpp_bool(object::ptr const& obj);
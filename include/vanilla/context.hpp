@@ -59,6 +59,11 @@ namespace vanilla
         void set_global_value(std::string name, object::ptr v);
         void set_local_value(std::string name, object::ptr v);
         
+        // Drops the reference to v of the variable set_value would assign,
+        // if it still refers to v. Returns whether it did; the variable has
+        // to be assigned again before it is read.
+        bool release_value(std::string const& name, object::ptr const& v);
+        
         void begin_stackframe();
         void end_stackframe();
     };
@@ -0,0 +1,97 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_4262C8C298AA4C6C989647A50F3CEED9
+#define HEADER_UUID_4262C8C298AA4C6C989647A50F3CEED9
+
+// C++ Standard Library:
+#include <cstddef>
+#include <cstdint>
+
+namespace vanilla
+{
+    class object;
+    
+    // Reclaims reference cycles between containers by trial deletion, in the
+    // style of Bacon and Rajan. Containers that might have closed a cycle
+    // are buffered as candidate roots; once the buffer is full, the next
+    // statement boundary runs a collection over the subgraph reachable from
+    // them. References from inside that subgraph are subtracted from each
+    // container's reference count, and whatever is left without external
+    // references (directly or through a live container) is garbage.
+    //
+    // Collections at statement boundaries are incremental: each one takes at
+    // most a step's worth of roots, and the remaining candidates are left
+    // for the following statements. A pause scans what a step's roots reach
+    // instead of what the whole buffer reaches. Every step is a complete
+    // scan of its own subgraph, nothing is traced concurrently with the
+    // mutator.
+    //
+    // The buffer doesn't own the candidates, so a candidate that dies
+    // through its reference count is freed right away and leaves the
+    // buffer; only containers that are still alive count toward the limit.
+    namespace cycle_collector
+    {
+        std::size_t const DEFAULT_CANDIDATE_LIMIT = 4096;
+        std::size_t const DEFAULT_STEP_SIZE = 512;
+        
+        namespace detail
+        {
+            extern bool pending;
+            
+            // Removes a dying candidate from the buffer.
+            void forget(object const* container);
+        }
+        
+        struct statistics
+        {
+            std::uint64_t collections;
+            std::uint64_t containers_scanned;
+            std::uint64_t containers_reclaimed;
+            std::uint64_t bytes_reclaimed;     // See object::memory_size.
+        };
+        
+        // Remembers a container that gained a reference to another one.
+        void add_candidate(object* container);
+        
+        // Collects over every candidate at once.
+        void collect();
+        
+        // Collects over at most the step size's worth of candidates, and
+        // stays pending while any are left.
+        void collect_step();
+        
+        // Runs a collection step if the candidate buffer filled up. Called at
+        // points where every live object is held by an object::ptr.
+        inline void safepoint()
+        {
+            if(detail::pending)
+                collect_step();
+        }
+        
+        void set_candidate_limit(std::size_t limit);
+        void set_step_size(std::size_t size);
+        
+        statistics get_statistics();
+    }
+}
+
+#endif // HEADER_UUID_4262C8C298AA4C6C989647A50F3CEED9
@@ -0,0 +1,121 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_42147EE77AE5460E9A40967335FE0A36
+#define HEADER_UUID_42147EE77AE5460E9A40967335FE0A36
+
+// C++ Standard Library:
+#include <cstddef>
+#include <cstdint>
+
+// Vanilla:
+#include <vanilla/object.hpp>
+
+namespace vanilla
+{
+    // Entries are stored in insertion order, removed ones leave a hole
+    // until the next rehash. The table maps slots to entries and has one
+    // control byte per slot: empty, deleted, or the top 7 bits of the
+    // key's hash. Lookups compare a group of GROUP_SIZE control bytes at
+    // once and only compare the keys whose bytes match.
+    //
+    // Slots are probed a group at a time, starting at the low bits of the
+    // hash. The first GROUP_SIZE control bytes are repeated after the last
+    // one so that groups can wrap around the end of the table.
+    class dict_object : public object
+    {
+    public:
+        static std::size_t const GROUP_SIZE = 16;
+        static std::size_t const MIN_CAPACITY = 16;
+        
+    private:
+        // Keys and values alternate, a removed entry is a null key.
+        object::ptr* _pairs;
+        std::size_t* _hashes;
+        std::size_t _entries;           // Including removed ones.
+        std::size_t _size;
+        
+        std::int8_t* _control;
+        std::uint32_t* _slots;
+        std::size_t _capacity;          // Slots, 0 until the first insertion.
+        std::size_t _growth_left;       // Empty slots that may still be used.
+        
+        // The slot whose entry has the key, or _capacity.
+        std::size_t find(object const& key, std::size_t hash) const;
+        
+        // Compacts the entries and moves them to a table with room for at
+        // least twice as many.
+        void rehash();
+        
+        void clear();
+        
+    public:
+        dict_object();
+        ~dict_object();
+        
+        std::size_t size() const
+        {
+            return _size;
+        }
+        
+        // The value of key, or null.
+        object::ptr lookup(object const& key) const;
+        
+        void insert(object::ptr key, object::ptr value);
+        
+        // Whether key was there.
+        bool remove(object const& key);
+        
+        // Arrays of the keys and values in insertion order, items are
+        // [key, value] arrays.
+        object::ptr keys() const;
+        object::ptr values() const;
+        object::ptr items() const;
+        
+        virtual object_type_id type_id() const override;
+        virtual ptr type_name() const override;
+        
+        virtual ptr copy(bool deep = false) const override;
+        
+        // Subscript.
+        virtual ptr sget(object::ptr const& subscript);
+        virtual void sset(object::ptr const& subscript, ptr value);
+        
+        // Element selection.
+        virtual ptr eget(std::string const& name);
+        virtual void eset(std::string const& name, ptr value);
+        
+        virtual bool is_container() const override;
+        virtual void traverse(object_visitor& v) const override;
+        virtual void release_references() override;
+        virtual std::size_t memory_size() const override;
+    };
+    
+    namespace error
+    {
+        struct key_not_found_error : invalid_index_error
+        { };
+        
+        VANILLA_MAKE_ERRINFO(object::ptr, missing_key)
+    }
+}
+
+#endif // HEADER_UUID_42147EE77AE5460E9A40967335FE0A36
@@ -53,6 +53,7 @@ namespace vanilla
         VANILLA_MAKE_ERRINFO(std::string, error_string)
         VANILLA_MAKE_ERRINFO(unsigned, line_info)
         VANILLA_MAKE_ERRINFO(unsigned, pos_info)
+        VANILLA_MAKE_ERRINFO(std::string, file_info)
     }
 }
 
@@ -36,6 +36,7 @@
 #include <vanilla/float_object.hpp>
 #include <vanilla/bool_object.hpp>
 #include <vanilla/string_object.hpp>
+#include <vanilla/instrumentation.hpp>
 
 namespace vanilla
 {
@@ -60,6 +61,34 @@ namespace vanilla
                                     unsigned pos );
     };
     
+    // Node class names of the literal nodes, for instrumentation.
+    template<typename VanillaType>
+    struct value_expression_node_name;
+    
+    template<>
+    struct value_expression_node_name<int_object>
+    {
+        static char const* get() { return "int_expression_node"; }
+    };
+    
+    template<>
+    struct value_expression_node_name<float_object>
+    {
+        static char const* get() { return "float_expression_node"; }
+    };
+    
+    template<>
+    struct value_expression_node_name<string_object>
+    {
+        static char const* get() { return "string_expression_node"; }
+    };
+    
+    template<>
+    struct value_expression_node_name<bool_object>
+    {
+        static char const* get() { return "bool_expression_node"; }
+    };
+    
     template<typename Type, typename VanillaType>
     class value_expression_node : public nullary_expression_node
     {
@@ -73,6 +102,8 @@ namespace vanilla
         
         virtual object::ptr eval(context&) override
         {
+            instrumentation::policy::node_evaluated(
+                value_expression_node_name<VanillaType>::get(), this);
             return allocate_object<VanillaType>(_v);
         }
         
@@ -112,6 +143,30 @@ namespace vanilla
         expression_node* get_right();
     };
     
+    // Binary operators an assignment can update its variable with, see
+    // eval_update.
+    class update_expression_node : public binary_expression_node
+    {
+    protected:
+        // The operator, applied to the evaluated operands.
+        virtual object::ptr apply(  object::ptr const& left,
+                                    object::ptr const& right ) = 0;
+        
+    public:
+        update_expression_node( unsigned line,
+                                unsigned pos,
+                                expression_node::ptr left,
+                                expression_node::ptr right );
+        
+        virtual object::ptr eval(context&) override;
+        
+        // Evaluates `name = name <op> right`, the left operand being the
+        // variable name. The variable's reference to its old value is
+        // dropped before the operator is applied, so that a value nobody
+        // else references can be updated in place.
+        object::ptr eval_update(context& c, std::string const& name);
+    };
+    
     ///////////////////////////////////////////////////////////////////////////
     /////////// NULLARY EXPRESSIONS 
     ///////////////////////////////////////////////////////////////////////////
@@ -155,13 +210,19 @@ namespace vanilla
         virtual void accept(ast_visitor* v) override;
     };
     
+    // Evaluates to the interned string, looked up on the first evaluation.
     class string_expression_node :
-        public value_expression_node<string_object::string_type, string_object>
+        public value_expression_node<std::string, string_object>
     {
+    private:
+        object::ptr _interned;
+        
     public:
         string_expression_node( unsigned line,
                                 unsigned pos,
-                                string_object::string_type v );
+                                std::string v );
+        
+        virtual object::ptr eval(context&) override;
         
         virtual void accept(ast_visitor* v) override;
     };
@@ -193,6 +254,27 @@ namespace vanilla
         
         std::vector<expression_node::ptr> const& values();
     };
+    
+    // {key: value, ...}, evaluated in that order.
+    class dict_expression_node :
+        public expression_node
+    {
+    private:
+        std::vector<expression_node::ptr> _keys;
+        std::vector<expression_node::ptr> _values;
+    public:
+        dict_expression_node(   unsigned line,
+                                unsigned pos,
+                                std::vector<expression_node::ptr> keys,
+                                std::vector<expression_node::ptr> values);
+        
+        virtual object::ptr eval(context&) override;
+        
+        virtual void accept(ast_visitor* v) override;
+        
+        std::vector<expression_node::ptr> const& keys();
+        std::vector<expression_node::ptr> const& values();
+    };
 
     
     ///////////////////////////////////////////////////////////////////////////
@@ -228,55 +310,63 @@ namespace vanilla
     ///////////////////////////////////////////////////////////////////////////
     
     // Arithmetic.
-    class addition_expression_node : public binary_expression_node
+    class addition_expression_node : public update_expression_node
     {
+    protected:
+        virtual object::ptr apply(  object::ptr const& left,
+                                    object::ptr const& right ) override;
+        
     public:
         addition_expression_node(   unsigned line,
                                     unsigned pos,
                                     expression_node::ptr left,
                                     expression_node::ptr right );
         
-        virtual object::ptr eval(context&) override;
-        
         virtual void accept(ast_visitor* v) override;
     };
     
-    class subtraction_expression_node : public binary_expression_node
+    class subtraction_expression_node : public update_expression_node
     {
+    protected:
+        virtual object::ptr apply(  object::ptr const& left,
+                                    object::ptr const& right ) override;
+        
     public:
         subtraction_expression_node(    unsigned line,
                                         unsigned pos,
                                         expression_node::ptr left,
                                         expression_node::ptr right );
         
-        virtual object::ptr eval(context&) override;
-        
         virtual void accept(ast_visitor* v) override;
     };
     
-    class multiplication_expression_node : public binary_expression_node
+    class multiplication_expression_node : public update_expression_node
     {
+    protected:
+        virtual object::ptr apply(  object::ptr const& left,
+                                    object::ptr const& right ) override;
+        
     public:
         multiplication_expression_node( unsigned line,
                                         unsigned pos,
                                         expression_node::ptr left,
                                         expression_node::ptr right );
         
-        virtual object::ptr eval(context&) override;
-        
         virtual void accept(ast_visitor* v) override;
     };
     
-    class division_expression_node : public binary_expression_node
+    class division_expression_node : public update_expression_node
     {
+    protected:
+        virtual object::ptr apply(  object::ptr const& left,
+                                    object::ptr const& right ) override;
+        
     public:
         division_expression_node(   unsigned line,
                                     unsigned pos,
                                     expression_node::ptr left,
                                     expression_node::ptr right );
         
-        virtual object::ptr eval(context&) override;
-        
         virtual void accept(ast_visitor* v) override;
     };
     
@@ -361,16 +451,18 @@ namespace vanilla
     };
     
     // Other.
-    class concatenation_expression_node : public binary_expression_node
+    class concatenation_expression_node : public update_expression_node
     {
+    protected:
+        virtual object::ptr apply(  object::ptr const& left,
+                                    object::ptr const& right ) override;
+        
     public:
         concatenation_expression_node(  unsigned line,
                                         unsigned pos,
                                         expression_node::ptr left,
                                         expression_node::ptr right );
         
-        virtual object::ptr eval(context&) override;
-        
         virtual void accept(ast_visitor* v) override;
     };
     
@@ -72,8 +72,22 @@ namespace vanilla
         virtual ptr copy(bool deep) const override;
         
         virtual ptr to_string() const override;
+        virtual ptr to_float() const override;
         
         float_type const& value() const;
+        
+        // Writes the decimal digits to out, which needs room for
+        // max_chars() characters. Returns the end, without a terminating
+        // zero.
+        std::size_t max_chars() const;
+        char* to_chars(char* out) const;
+        
+        // Equality operations.
+        virtual ptr eq(object::ptr const& other);
+        virtual ptr neq(object::ptr const& other);
+        
+        virtual std::size_t hash() const override;
+        virtual bool equals(object const& other) const override;
     };
     
     namespace error
@@ -23,8 +23,10 @@
 #define HEADER_UUID_B49970A649644885B6A6798FA8E7867A
 
 // C++ Standard Library:
+#include <atomic>
 #include <string>
 #include <functional>
+#include <vector>
 
 // Vanilla:
 #include <vanilla/object.hpp>
@@ -60,13 +62,26 @@ namespace vanilla
         bool _set_context;
         bool _variadic;
         unsigned _min_args;
+        object::ptr _bound;
+        
+        // Interned on the first traced or profiled call.
+        mutable std::atomic<char const*> _trace_name;
+        mutable std::atomic<char const*> _profile_name;
+        
+        char const* trace_name() const;
+        char const* profile_name() const;
         
     public:
+        // Variadic functions take more arguments than declared. f gets them
+        // after the declared ones, or only them if the declared ones are set
+        // in the context. bound is an object f uses, kept alive and
+        // traversed by the function.
         function_object(    std::string name,
                             std::vector<function_argument> arguments,
                             callable_type f,
                             bool set_context = true,
-                            bool variadic = false);
+                            bool variadic = false,
+                            object::ptr bound = object::ptr());
         
         virtual object_type_id type_id() const override;
         
@@ -77,8 +92,37 @@ namespace vanilla
         virtual ptr to_string() const override;
         
         virtual ptr call(context& c, ptr* argv, unsigned argc) override;
+        
+        // Default argument values and the bound object are references.
+        virtual bool is_container() const override;
+        virtual void traverse(object_visitor& v) const override;
+        virtual void release_references() override;
+        virtual std::size_t memory_size() const override;
     };
     
+    // An element function like s.slice(begin, end): calls f(obj, argv,
+    // argc) and keeps obj alive as the bound object, so a container that
+    // stores one of its own element functions is a cycle the collector
+    // sees.
+    template<typename T, typename F>
+    object::ptr make_element_function(  T* obj,
+                                        std::string name,
+                                        std::vector<function_argument> arguments,
+                                        F f,
+                                        bool variadic = false)
+    {
+        return allocate_object<function_object>(
+            std::move(name),
+            std::move(arguments),
+            [obj, f](context&, object::ptr* argv, unsigned argc)
+            {
+                return f(obj, argv, argc);
+            },
+            false,
+            variadic,
+            obj->shared_from_this());
+    }
+    
     namespace error
     {
         struct too_many_arguments_error : evaluation_error
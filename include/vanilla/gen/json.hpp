@@ -0,0 +1,108 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_FC8837BBC6D34C1E9C04FA0429C1C7DF
+#define HEADER_UUID_FC8837BBC6D34C1E9C04FA0429C1C7DF
+
+// C++ Standard Library:
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Vanilla:
+#include <vanilla/expression_ast.hpp>
+#include <vanilla/statement_ast.hpp>
+#include <vanilla/gen/output_buffer.hpp>
+
+namespace vanilla
+{
+    namespace gen
+    {
+        // Emits the AST as compact JSON. Every node is an object with
+        // "node", "line" and "pos" members plus its children.
+        class json_generator : public vanilla::ast_visitor
+        {
+        private:
+            output_buffer _o;
+            
+            void begin_node(char const* name, ast_node* n);
+            void end_node();
+            void key(char const* name);
+            void print_string(std::string const& s);
+            void print_child(char const* name, ast_node* n);
+            void print_list(char const* name, std::vector<expression_node::ptr> const& nodes);
+            void print_arguments(
+                std::vector<std::pair<std::string, expression_node::ptr>> const& arguments);
+            void print_binary(char const* name, binary_expression_node* n);
+            
+        public:
+            explicit json_generator(std::ostream& o);
+            
+            // Nullary expressions.
+            virtual void visit(variable_expression_node* n) override;
+            virtual void visit(int_expression_node* n) override;
+            virtual void visit(float_expression_node* n) override;
+            virtual void visit(string_expression_node* n) override;
+            virtual void visit(bool_expression_node* n) override;
+            virtual void visit(array_expression_node* n) override;
+            virtual void visit(dict_expression_node* n) override;
+            
+            // Unary expressions.
+            virtual void visit(negation_expression_node* n) override;
+            virtual void visit(abs_expression_node* n) override;
+            
+            // Binary expressions.
+            virtual void visit(addition_expression_node* n) override;
+            virtual void visit(subtraction_expression_node* n) override;
+            virtual void visit(multiplication_expression_node* n) override;
+            virtual void visit(division_expression_node* n) override;
+            virtual void visit(concatenation_expression_node* n) override;
+            virtual void visit(lessthan_expression_node* n) override;
+            virtual void visit(lessequal_expression_node* n) override;
+            virtual void visit(greaterthan_expression_node* n) override;
+            virtual void visit(greaterequal_expression_node* n) override;
+            virtual void visit(equality_expression_node* n) override;
+            virtual void visit(inequality_expression_node* n) override;
+            
+            // Function expressions.
+            virtual void visit(function_call_expression_node* n) override;
+            virtual void visit(function_definition_expression_node* n) override;
+            virtual void visit(native_function_definition_expression_node* n) override;
+            
+            // Other expressions.
+            virtual void visit(conditional_expression_node* n) override;
+            virtual void visit(subscript_expression_node* n) override;
+            virtual void visit(element_selection_expression_node* n) override;
+        
+            // Statements.
+            virtual void visit(return_statement_node* n) override;
+            virtual void visit(statement_sequence_node* n) override;
+            virtual void visit(if_statement_node* n) override;
+            virtual void visit(while_statement_node* n) override;
+            virtual void visit(function_definition_statement_node* n) override;
+            virtual void visit(assignment_statement_node* n) override;
+        };
+        
+        void emit_json(ast_node* ast, std::ostream& o);
+    }
+}
+
+#endif // HEADER_UUID_FC8837BBC6D34C1E9C04FA0429C1C7DF
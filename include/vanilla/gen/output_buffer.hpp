@@ -0,0 +1,81 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_E52480E91BBE4365AD6FB8175244EBAC
+#define HEADER_UUID_E52480E91BBE4365AD6FB8175244EBAC
+
+// C++ Standard Library:
+#include <cstddef>
+#include <string>
+#include <ostream>
+#include <memory>
+
+// GMP:
+#include <gmp.h>
+
+namespace vanilla
+{
+    namespace gen
+    {
+        // Collects generated output in a large block and hands it to the
+        // stream in few big writes instead of one call per fragment.
+        class output_buffer
+        {
+        private:
+            std::ostream& _o;
+            std::unique_ptr<char[]> _buffer;
+            std::size_t _capacity;
+            std::size_t _size;
+            
+        public:
+            explicit output_buffer(std::ostream& o, std::size_t capacity = 64 * 1024);
+            output_buffer(output_buffer const&) = delete;
+            output_buffer& operator=(output_buffer const&) = delete;
+            ~output_buffer();
+            
+            void flush();
+            
+            // Returns a pointer to at least n free bytes. Call commit() with
+            // the number of bytes actually used afterwards.
+            char* reserve(std::size_t n);
+            void commit(std::size_t n);
+            
+            void put(char c)
+            {
+                if(_size == _capacity)
+                    flush();
+                _buffer[_size++] = c;
+            }
+            
+            void put(char const* s, std::size_t n);
+            void put(char const* s);
+            void put(std::string const& s);
+            void put_repeated(char c, std::size_t n);
+            void put_unsigned(unsigned long v);
+            
+            // Literal values, formatted without creating objects.
+            void put_mpz(mpz_t const v);
+            void put_mpf(mpf_t const v);
+        };
+    }
+}
+
+#endif // HEADER_UUID_E52480E91BBE4365AD6FB8175244EBAC
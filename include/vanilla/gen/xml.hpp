@@ -24,8 +24,10 @@
 
 // C++ Standard Library:
 #include <ostream>
+#include <string>
 
 // Vanilla:
+#include <vanilla/gen/output_buffer.hpp>
 #include <vanilla/expression_ast.hpp>
 #include <vanilla/statement_ast.hpp>
 
@@ -36,7 +38,7 @@ namespace vanilla
         class xml_generator : public vanilla::ast_visitor
         {
         private:
-            std::ostream& _o;
+            output_buffer _o;
             unsigned _indent_spaces;
             unsigned _indent_level;
             
@@ -44,6 +46,8 @@ namespace vanilla
             void increase_indent();
             void decrease_indent();
             void print_line(char const* s);
+            void print_escaped(std::string const& s);
+            void print_element(char const* tag, std::string const& text);
             
         public:
             xml_generator(std::ostream& o, unsigned indent_spaces = 4);
@@ -55,6 +59,7 @@ namespace vanilla
             virtual void visit(string_expression_node* n) override;
             virtual void visit(bool_expression_node* n) override;
             virtual void visit(array_expression_node* n) override;
+            virtual void visit(dict_expression_node* n) override;
             
             // Unary expressions.
             virtual void visit(negation_expression_node* n) override;
@@ -0,0 +1,71 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_A1851C4CE09E4247ABEF9D93DDE8874B
+#define HEADER_UUID_A1851C4CE09E4247ABEF9D93DDE8874B
+
+// C++ Standard Library:
+#include <ostream>
+
+// Vanilla:
+#include <vanilla/object.hpp>
+
+namespace vanilla
+{
+    class ast_node;
+    
+    // Evaluation counters. The evaluator reports to instrumentation::policy,
+    // which is selected at compile time: unless VANILLA_INSTRUMENTATION is
+    // defined it is disabled_policy and every call compiles to nothing.
+    namespace instrumentation
+    {
+        struct disabled_policy
+        {
+            static void node_evaluated(char const*, ast_node const*)
+            { }
+            
+            static void binary_operation(char const*, object const&, object const&)
+            { }
+        };
+        
+        // Counts evaluations per node class and per source line, and the
+        // operand types of every binary operator. The strings passed in
+        // must be literals, they are keyed by address.
+        struct counting_policy
+        {
+            static void node_evaluated(char const* node_class, ast_node const* n);
+            static void binary_operation(char const* op, object const& left, object const& right);
+        };
+        
+#ifdef VANILLA_INSTRUMENTATION
+        typedef counting_policy policy;
+#else
+        typedef disabled_policy policy;
+#endif
+        
+        // Whether this build counts.
+        bool enabled();
+        
+        void write_json(std::ostream& o);
+    }
+}
+
+#endif // HEADER_UUID_A1851C4CE09E4247ABEF9D93DDE8874B
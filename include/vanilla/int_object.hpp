@@ -77,6 +77,11 @@ namespace vanilla
         
         int_type const& value() const;
         
+        // Writes the digits to out, which needs room for max_chars(base)
+        // characters. Returns the end, without a terminating zero.
+        std::size_t max_chars(int base = 10) const;
+        char* to_chars(char* out, int base = 10) const;
+        
         // Unary operations.
         virtual ptr neg();
         virtual ptr abs();
@@ -100,6 +105,12 @@ namespace vanilla
         // Element selection.
         virtual ptr eget(std::string const& name);
         virtual void eset(std::string const& name, ptr value);
+        
+        virtual std::size_t hash() const override;
+        virtual bool equals(object const& other) const override;
+        
+        // Also the hash of a float with an integral value v.
+        static std::size_t hash_value(int_type const& v);
     };
     
     namespace error
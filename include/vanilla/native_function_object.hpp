@@ -23,9 +23,12 @@
 #define HEADER_UUID_A2E2D9BCF7634E7FA39CA9891C41BD53
 
 // C++ Standard Library:
+#include <atomic>
 #include <memory>
 #include <cstdint>
 #include <mutex>
+#include <vector>
+#include <string>
 
 // libffi:
 #include <ffi.h>
@@ -96,6 +99,13 @@ namespace vanilla
         std::mutex _lock;
         bool _requires_locking;
         
+        // Interned on the first traced or profiled call.
+        mutable std::atomic<char const*> _trace_name;
+        mutable std::atomic<char const*> _profile_name;
+        
+        char const* trace_name() const;
+        char const* profile_name() const;
+        
     public:
         native_function_object( std::string name,
                                 std::string library,
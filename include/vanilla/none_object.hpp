@@ -37,6 +37,9 @@ namespace vanilla
         virtual ptr copy(bool deep) const override;
         
         virtual ptr to_string() const override;
+        
+        virtual std::size_t hash() const override;
+        virtual bool equals(object const& other) const override;
     };
 }
 
@@ -23,17 +23,34 @@
 #define HEADER_UUID_3F8C2284A47547D1B07D56E764241868 
 
 // C++ Standard Library:
-#include <memory>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <new>
+#include <utility>
 
 // Vanilla:
 #include <vanilla/error.hpp>
+#include <vanilla/alloc_stats.hpp>
 
 namespace vanilla
 {
     typedef std::uint32_t object_type_id;
     
     struct context;
+    class object_visitor;
+    class object_ptr;
+    
+    namespace detail
+    {
+        // Whether reference counts are changed with atomic operations,
+        // see set_atomic_references.
+        extern bool atomic_references;
+    }
+    
+    // Reference counting is non-atomic by default. Must be enabled before
+    // objects are shared with another thread.
+    void set_atomic_references(bool enabled);
     
     object_type_id const OBJECT_ID_NONE = 0x0;
     object_type_id const OBJECT_ID_INT = 0x1;
@@ -48,16 +65,99 @@ namespace vanilla
     object_type_id const OBJECT_ID_NATIVE_FUNCTION = 0xA;
     object_type_id const OBJECT_ID_MEMBER_FUNCTION = 0xB;
     object_type_id const OBJECT_ID_CLASS = 0xC;
+    object_type_id const OBJECT_ID_STRING_BUILDER = 0xD;
+    object_type_id const OBJECT_ID_REGEX = 0xE;
     object_type_id const OBJECT_ID_CLASSFLAG = 1 << 31;
     
  
-    class object : public std::enable_shared_from_this<object>
+    class object
     {
     public:
-        typedef std::shared_ptr<object> ptr;
+        typedef object_ptr ptr;
+        
+        // Set by allocate_object and the collectors.
+        enum flag : std::uint8_t
+        {
+            FLAG_ACCOUNTED = 1 << 0,        // Counted by alloc_stats.
+            FLAG_CYCLE_CANDIDATE = 1 << 1   // Buffered by the cycle collector.
+        };
+        
+    private:
+        mutable std::atomic<std::uint32_t> _references;
+        std::uint8_t _flags;
+        
+        void destroy() const;
+        
+    public:
+        object();
+        object(object const&) = delete;
+        object& operator=(object const&) = delete;
         
         virtual ~object();
         
+        // Frees the memory of any object. allocate_object allocates more
+        // than sizeof for some types, so the size isn't passed on.
+        static void operator delete(void* p);
+        
+        void add_reference() const
+        {
+            if(detail::atomic_references)
+                _references.fetch_add(1, std::memory_order_relaxed);
+            else
+                _references.store(_references.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        
+        void release() const
+        {
+            std::uint32_t left;
+            if(detail::atomic_references)
+                left = _references.fetch_sub(1, std::memory_order_acq_rel) - 1;
+            else
+            {
+                left = _references.load(std::memory_order_relaxed) - 1;
+                _references.store(left, std::memory_order_relaxed);
+            }
+            
+            if(left == 0)
+                destroy();
+        }
+        
+        std::uint32_t reference_count() const
+        {
+            return _references.load(std::memory_order_relaxed);
+        }
+        
+        // Adds a reference unless the object is already being destroyed,
+        // for holders that don't own one, like the cycle collector's buffer.
+        bool try_add_reference() const
+        {
+            std::uint32_t cur = _references.load(std::memory_order_relaxed);
+            do
+            {
+                if(cur == 0)
+                    return false;
+            } while(!_references.compare_exchange_weak(cur, cur + 1, std::memory_order_relaxed));
+            return true;
+        }
+        
+        std::uint8_t flags() const
+        {
+            return _flags;
+        }
+        
+        void set_flag(flag f)
+        {
+            _flags |= f;
+        }
+        
+        void clear_flag(flag f)
+        {
+            _flags &= ~f;
+        }
+        
+        ptr shared_from_this();
+        ptr shared_from_this() const;
+        
         virtual object_type_id type_id() const = 0;
         
         virtual ptr type_name() const = 0;
@@ -71,6 +171,11 @@ namespace vanilla
         
         virtual ptr call(context& c, ptr* argv, unsigned argc);
         
+        // The evaluator drops its reference to the operand right after an
+        // operation. An operand nobody else references (reference_count()
+        // is 1) may therefore be updated in place and returned as the
+        // result.
+        
         // Unary operations.
         virtual ptr neg();
         virtual ptr abs();
@@ -101,12 +206,199 @@ namespace vanilla
         // Element selection.
         virtual ptr eget(std::string const& name);
         virtual void eset(std::string const& name, ptr value);
+        
+        // Dictionary keys. Objects that are equal() have the same hash().
+        // Numbers are equal if == says so, whether int or float, anything
+        // else is only equal to its own type. Only values that can't change
+        // are hashable, hash() throws for the rest and equals() compares
+        // identity.
+        virtual std::size_t hash() const;
+        virtual bool equals(object const& other) const;
+        
+        // References to other objects, for the cycle collector. Objects that
+        // can be part of a reference cycle override all four; memory_size
+        // is the bytes a container holds itself, reported as reclaimed.
+        virtual bool is_container() const;
+        virtual void traverse(object_visitor& v) const;
+        virtual void release_references();
+        virtual std::size_t memory_size() const;
+    };
+    
+    // An owning reference; the count lives in the object itself.
+    class object_ptr
+    {
+    private:
+        object* _p;
+        
+        struct adopt_tag
+        { };
+        
+        // Takes over a reference that was already added.
+        object_ptr(object* p, adopt_tag) noexcept
+            : _p(p)
+        { }
+        
+    public:
+        object_ptr() noexcept
+            : _p(nullptr)
+        { }
+        
+        object_ptr(std::nullptr_t) noexcept
+            : _p(nullptr)
+        { }
+        
+        explicit object_ptr(object* p)
+            : _p(p)
+        {
+            if(_p)
+                _p->add_reference();
+        }
+        
+        object_ptr(object_ptr const& other)
+            : _p(other._p)
+        {
+            if(_p)
+                _p->add_reference();
+        }
+        
+        object_ptr(object_ptr&& other) noexcept
+            : _p(other._p)
+        {
+            other._p = nullptr;
+        }
+        
+        ~object_ptr()
+        {
+            if(_p)
+                _p->release();
+        }
+        
+        object_ptr& operator=(object_ptr const& other)
+        {
+            object_ptr(other).swap(*this);
+            return *this;
+        }
+        
+        object_ptr& operator=(object_ptr&& other) noexcept
+        {
+            object_ptr(std::move(other)).swap(*this);
+            return *this;
+        }
+        
+        // An owning reference to p, or an empty one if p is already being
+        // destroyed.
+        static object_ptr try_acquire(object* p)
+        {
+            return p->try_add_reference() ? object_ptr(p, adopt_tag()) : object_ptr();
+        }
+        
+        void reset()
+        {
+            object_ptr().swap(*this);
+        }
+        
+        void swap(object_ptr& other) noexcept
+        {
+            std::swap(_p, other._p);
+        }
+        
+        object* get() const
+        {
+            return _p;
+        }
+        
+        object& operator*() const
+        {
+            return *_p;
+        }
+        
+        object* operator->() const
+        {
+            return _p;
+        }
+        
+        explicit operator bool() const
+        {
+            return _p != nullptr;
+        }
+        
+        std::uint32_t use_count() const
+        {
+            return _p ? _p->reference_count() : 0;
+        }
+    };
+    
+    inline bool operator==(object_ptr const& a, object_ptr const& b)
+    {
+        return a.get() == b.get();
+    }
+    
+    inline bool operator!=(object_ptr const& a, object_ptr const& b)
+    {
+        return a.get() != b.get();
+    }
+    
+    inline object::ptr object::shared_from_this()
+    {
+        return ptr(this);
+    }
+    
+    inline object::ptr object::shared_from_this() const
+    {
+        return ptr(const_cast<object*>(this));
+    }
+    
+    // Spreads the bits of v over the whole hash, dictionaries take the
+    // probe position from the low bits and a tag from the high ones.
+    inline std::size_t mix_hash(std::uint64_t v)
+    {
+        v ^= v >> 33;
+        v *= 0xFF51AFD7ED558CCDull;
+        v ^= v >> 33;
+        v *= 0xC4CEB9FE1A85EC53ull;
+        v ^= v >> 33;
+        return std::size_t(v);
+    }
+    
+    class object_visitor
+    {
+    public:
+        virtual ~object_visitor();
+        virtual void visit(object::ptr const& o) = 0;
+    };
+    
+    // Bytes allocate_object allocates for a T constructed from the given
+    // arguments. Types storing data after the object specialize it.
+    template<typename T>
+    struct object_size
+    {
+        template<typename... Args>
+        static std::size_t get(Args const&...)
+        {
+            return sizeof(T);
+        }
     };
     
     template<typename T, typename... Args>
     object::ptr allocate_object(Args&&... args)
     {
-        return std::make_shared<T>(std::forward<Args>(args)...);
+        std::size_t bytes = object_size<T>::get(args...);
+        void* memory = ::operator new(bytes);
+        
+        T* result;
+        try
+        {
+            result = new(memory) T(std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            ::operator delete(memory);
+            throw;
+        }
+        
+        if(alloc_stats::detail::active)
+            alloc_stats::detail::allocated(*result, bytes);
+        return object::ptr(result);
     }
     
     namespace error
@@ -24,6 +24,9 @@
 
 // C++ Standard Library:
 #include <exception>
+#include <memory>
+#include <vector>
+#include <string>
 
 // Vanilla:
 #include <vanilla/expression_ast.hpp>
@@ -49,11 +52,73 @@ namespace vanilla
         VANILLA_MAKE_ERRINFO(std::string, escape_sequence);
     }
     
+    namespace detail
+    {
+        // The scanned tokens of a source text. Lazily parsed function bodies
+        // keep it alive since their tokens point into the text.
+        struct token_source
+        {
+            std::string text;
+            std::vector<token> tokens;
+        };
+        
+        // Scans the whole text, the first step of parse_source.
+        std::shared_ptr<token_source> tokenize_source(std::string text);
+    }
+    
+    // A function body which was only validated by the preparser. The body is
+    // parsed from its recorded token range the first time it is needed.
+    class lazy_statement_node : public statement_node
+    {
+    private:
+        std::shared_ptr<detail::token_source> _source;
+        std::size_t _begin;
+        std::size_t _end;
+        statement_node::ptr _body;
+        
+    public:
+        lazy_statement_node(    unsigned line,
+                                unsigned pos,
+                                std::shared_ptr<detail::token_source> source,
+                                std::size_t begin,
+                                std::size_t end );
+        
+        bool is_parsed() const;
+        
+        // The source text of the body, from its first to its last token.
+        // Only available until the body is parsed.
+        cstr_range get_text() const;
+        
+        statement_node* get_body();
+        
+        virtual void eval(context&) override;
+        
+        virtual void accept(ast_visitor* v) override;
+    };
+    
     expression_node::ptr parse_expr(char const* expr);
     
-    statement_node::ptr parse_string(char const* str);
+    // If lazy_functions is set, function bodies are only preparsed: they are
+    // checked for syntax errors but their AST is built on the first call.
+    statement_node::ptr parse_string(char const* str, bool lazy_functions = true);
+    
+    // Like parse_string, but takes over the text instead of copying it.
+    statement_node::ptr parse_source(std::string text, bool lazy_functions = true);
+    
+    // Parses a single statement, such as a lazy_statement_node's text,
+    // which starts at the given line and position of its file. Function
+    // bodies inside it are parsed lazily.
+    statement_node::ptr parse_body(std::string text, unsigned line, unsigned pos);
+    
+    statement_node::ptr parse_file(char const* filename, bool lazy_functions = true);
     
-    statement_node::ptr parse_file(char const* filename);
+    // Parses the files concurrently on up to the given number of threads (0
+    // meaning one per core) and concatenates their programs in the given
+    // order. If parsing fails, the error of the first failing file in list
+    // order is rethrown, tagged with a file_info.
+    statement_node::ptr parse_files(   std::vector<std::string> const& filenames,
+                                        unsigned threads = 0,
+                                        bool lazy_functions = true );
 }
 
 #endif // HEADER_UUID_67CAAE82DE464A2F8E679107C7725185
\ No newline at end of file
@@ -0,0 +1,126 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_FEAC5F4C301747EB9572595633E24E59
+#define HEADER_UUID_FEAC5F4C301747EB9572595633E24E59
+
+// C++ Standard Library:
+#include <cstddef>
+#include <string>
+#include <ostream>
+
+// Vanilla:
+#include <vanilla/error.hpp>
+
+namespace vanilla
+{
+    class ast_node;
+    
+    namespace error
+    {
+        struct profiler_error : base_error
+        { };
+    }
+    
+    // A statistical profiler driven by SIGPROF. The evaluator publishes the
+    // statement it executes and the stack of called functions; the signal
+    // handler copies both into a preallocated sample buffer.
+    namespace profiler
+    {
+        std::size_t const MAX_STACK_DEPTH = 256;
+        
+        namespace detail
+        {
+            struct frame
+            {
+                char const* name;
+                ast_node const* caller; // Statement executing in the frame below.
+            };
+            
+            // A frame is completely written before depth is increased, so
+            // the handler only ever sees complete frames.
+            struct published_state
+            {
+                ast_node const* volatile current;
+                std::size_t volatile depth;
+                frame stack[MAX_STACK_DEPTH];
+                bool active;
+            };
+            
+            extern published_state published;
+            
+            // Returns a pointer that stays valid for the rest of the process,
+            // so callers can intern a name once and keep it.
+            char const* intern(std::string const& name);
+        }
+        
+        // Called for every statement executed - a single store.
+        inline void set_current_node(ast_node const* n)
+        {
+            detail::published.current = n;
+        }
+        
+        // Pushes a function on the published call stack while the profiler
+        // is running, does nothing otherwise. The name comes from
+        // detail::intern; callers may pass null while the profiler isn't
+        // running, so that they only intern names that are needed.
+        class scoped_frame
+        {
+        private:
+            bool _pushed;
+            
+            void push(char const* name);
+            void pop();
+            
+        public:
+            explicit scoped_frame(char const* name)
+                : _pushed(detail::published.active && name)
+            {
+                if(_pushed)
+                    push(name);
+            }
+            
+            scoped_frame(scoped_frame const&) = delete;
+            scoped_frame& operator=(scoped_frame const&) = delete;
+            
+            ~scoped_frame()
+            {
+                if(_pushed)
+                    pop();
+            }
+        };
+        
+        // Starts sampling at the given frequency. Throws profiler_error if the
+        // timer can't be installed.
+        void start(unsigned frequency = 1000);
+        void stop();
+        bool is_running();
+        
+        // Flamegraph compatible "frame;frame;frame count" lines. Frames are
+        // named "function:line", the outermost one is "<toplevel>:line".
+        void write_folded_stacks(std::ostream& o);
+        
+        // Samples by source line of the executing statement.
+        void write_line_table(std::ostream& o);
+    }
+}
+
+#endif // HEADER_UUID_FEAC5F4C301747EB9572595633E24E59
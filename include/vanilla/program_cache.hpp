@@ -0,0 +1,138 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_5B0E3D7A9C2F4E1B8D6A40C3F1E7B925
+#define HEADER_UUID_5B0E3D7A9C2F4E1B8D6A40C3F1E7B925
+
+// C++ Standard Library:
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <memory>
+#include <ostream>
+
+// Vanilla:
+#include <vanilla/statement_ast.hpp>
+#include <vanilla/error.hpp>
+
+namespace vanilla
+{
+    namespace error
+    {
+        struct program_cache_error : base_error
+        { };
+    }
+    
+    // Bump whenever the binary layout or the AST changes.
+    std::uint32_t const PROGRAM_CACHE_VERSION = 4;
+    
+    namespace detail
+    {
+        // A read-only memory mapping of a whole file.
+        class mapped_file
+        {
+        private:
+            void* _data;
+            std::size_t _size;
+            
+        public:
+            explicit mapped_file(char const* filename);
+            mapped_file(mapped_file const&) = delete;
+            mapped_file& operator=(mapped_file const&) = delete;
+            ~mapped_file();
+            
+            char const* data() const;
+            std::size_t size() const;
+        };
+    }
+    
+    // A function body stored in a cache file. It is only deserialized and
+    // checked against its checksum the first time it is needed, so loading
+    // scales with the code that runs.
+    class cached_statement_node : public statement_node
+    {
+    private:
+        std::shared_ptr<detail::mapped_file> _file;
+        std::size_t _offset;
+        std::size_t _length;
+        std::uint64_t _checksum;
+        statement_node::ptr _body;
+        
+    public:
+        cached_statement_node(  unsigned line,
+                                unsigned pos,
+                                std::shared_ptr<detail::mapped_file> file,
+                                std::size_t offset,
+                                std::size_t length,
+                                std::uint64_t checksum );
+        
+        bool is_loaded() const;
+        
+        // The encoded body and its checksum, only available until it is
+        // loaded.
+        cstr_range get_data() const;
+        std::uint64_t get_checksum() const;
+        
+        statement_node* get_body();
+        
+        virtual void eval(context&) override;
+        
+        virtual void accept(ast_visitor* v) override;
+    };
+    
+    std::uint64_t hash_source(char const* data, std::size_t length);
+    
+    // Serializes a program. Function bodies that weren't parsed yet are
+    // stored as their source text and parsed when they are first called.
+    void write_program(statement_node* program, std::uint64_t source_hash, std::ostream& o);
+    
+    // Deserializes a program from a mapped cache file. Throws
+    // program_cache_error if the file is malformed, fails its checksum, is
+    // from another version or doesn't belong to a source with the given
+    // hash. Only the top level is checked here; a function body that fails
+    // its checksum throws program_cache_error when it is first called.
+    statement_node::ptr read_program(std::shared_ptr<detail::mapped_file> file,
+        std::uint64_t source_hash);
+    
+    // Maps source files to cache files in a directory, keyed by the path of
+    // the source. A cache file is only used if its content hash matches.
+    class program_cache
+    {
+    private:
+        std::string _directory;
+        
+        std::string cache_filename(std::string const& source_path) const;
+        
+    public:
+        explicit program_cache(std::string directory);
+        
+        // $VANILLA_CACHE_DIR, $XDG_CACHE_HOME/vanilla or ~/.cache/vanilla.
+        static std::string default_directory();
+        
+        std::string const& directory() const;
+        
+        // Loads the program from the cache, or parses the source and stores
+        // it in the cache if there is no up to date entry.
+        statement_node::ptr load(char const* filename);
+    };
+}
+
+#endif // HEADER_UUID_5B0E3D7A9C2F4E1B8D6A40C3F1E7B925
@@ -0,0 +1,83 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_3A5FA4F07E3B465B93283F044B9F665F
+#define HEADER_UUID_3A5FA4F07E3B465B93283F044B9F665F
+
+// C++ Standard Library:
+#include <cstddef>
+#include <cstdint>
+
+// Vanilla:
+#include <vanilla/object.hpp>
+
+namespace vanilla
+{
+    // Destruction of object graphs without recursion. Containers hand the
+    // references they own to release() when they die; containers among them
+    // that die as well are queued and destroyed one after another by the
+    // outermost release on the thread, so nesting depth doesn't reach the
+    // native stack.
+    //
+    // With a budget, only that many queued containers are destroyed at once,
+    // the rest at the following safepoints. With the background reclaimer
+    // running, big containers are handed to it whole.
+    namespace reclaimer
+    {
+        // Containers with fewer references are never handed off.
+        std::size_t const BACKGROUND_THRESHOLD = 4096;
+        
+        namespace detail
+        {
+            // Containers are queued on the evaluator thread.
+            extern bool deferred;
+            
+            void drain();
+        }
+        
+        struct statistics
+        {
+            std::uint64_t containers_queued;
+            std::uint64_t containers_deferred; // Left over for a safepoint.
+            std::uint64_t batches_handed_off;
+        };
+        
+        // Leaves the references empty.
+        void release(object::ptr* references, std::size_t count);
+        
+        // Continues destroying deferred containers.
+        inline void safepoint()
+        {
+            if(detail::deferred)
+                detail::drain();
+        }
+        
+        // 0, the default, destroys everything queued right away.
+        void set_budget(std::size_t containers_per_safepoint);
+        
+        void start_background();
+        void stop_background();
+        
+        statistics get_statistics();
+    }
+}
+
+#endif // HEADER_UUID_3A5FA4F07E3B465B93283F044B9F665F
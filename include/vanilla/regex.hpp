@@ -0,0 +1,108 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_FC873D57842F4B458F763540CF97005A
+#define HEADER_UUID_FC873D57842F4B458F763540CF97005A
+
+// C++ Standard Library:
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Vanilla:
+#include <vanilla/error.hpp>
+#include <vanilla/str_range.hpp>
+
+namespace vanilla
+{
+    namespace detail
+    {
+        struct regex_program;
+        class regex_dfa;
+    }
+    
+    // Regular expressions over UTF-8 text, matched in time linear in the
+    // text: there are no backreferences or lookarounds. The syntax is
+    // literals, ., [...] and [^...] with ranges, \d \w \s \D \W \S and the
+    // usual escapes, ^ and $ for the begin and end of the text, (...) and
+    // (?:...), | and the quantifiers *, +, ?, {n}, {n,} and {n,m}, lazy
+    // with a ? after them. Matches are leftmost-first, as in Perl.
+    //
+    // Patterns have to be valid UTF-8. Literals, . and classes match whole
+    // characters: they compile to the byte sequences that encode them, so
+    // the program still runs on bytes. \d \w and \s only match ASCII
+    // characters. A malformed byte in the text counts as a character, see
+    // vanilla/utf8.hpp, but nothing matches it, not even . or [^a].
+    //
+    // Patterns compile to an NFA program. Searches run a DFA built lazily
+    // from it: forwards to find where the leftmost match ends, then a DFA
+    // of the reversed pattern backwards to find where it begins. A search
+    // that keeps running out of DFA states simulates the NFA instead (a Pike
+    // VM), which is slower but needs no memory per state.
+    class regex
+    {
+    public:
+        // Bounds that keep untrusted patterns from taking unbounded time or
+        // memory to compile.
+        static std::size_t const MAX_REPEAT = 1000;
+        static std::size_t const MAX_NESTING = 256;
+        static std::size_t const MAX_PROGRAM_SIZE = 1 << 16;
+        
+        // The DFA starts over when it has more states; a search that has
+        // started over that many times is finished by the Pike VM.
+        static std::size_t const MAX_DFA_STATES = 4096;
+        static std::size_t const MAX_DFA_FLUSHES = 4;
+        
+        struct span
+        {
+            std::size_t begin;
+            std::size_t end;
+        };
+        
+    private:
+        std::unique_ptr<detail::regex_program> _forward;
+        std::unique_ptr<detail::regex_program> _reverse;
+        std::unique_ptr<detail::regex_dfa> _unanchored_dfa;
+        std::unique_ptr<detail::regex_dfa> _anchored_dfa;
+        std::unique_ptr<detail::regex_dfa> _reverse_dfa;
+        
+    public:
+        explicit regex(cstr_range pattern);
+        ~regex();
+        
+        regex(regex const&) = delete;
+        regex& operator=(regex const&) = delete;
+        
+        // The leftmost match that begins at or after from; with anchored,
+        // only a match that begins at from.
+        bool search(cstr_range text, std::size_t from, bool anchored, span& result);
+    };
+    
+    namespace error
+    {
+        struct invalid_regex_error : evaluation_error
+        { };
+        
+        VANILLA_MAKE_ERRINFO(std::string, regex_pattern)
+    }
+}
+
+#endif // HEADER_UUID_FC873D57842F4B458F763540CF97005A
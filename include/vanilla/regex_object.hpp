@@ -0,0 +1,90 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_9F59A8F636AE4CF98A5025C5E659C04A
+#define HEADER_UUID_9F59A8F636AE4CF98A5025C5E659C04A
+
+// C++ Standard Library:
+#include <cstddef>
+#include <string>
+
+// Vanilla:
+#include <vanilla/object.hpp>
+#include <vanilla/regex.hpp>
+
+namespace vanilla
+{
+    // A compiled regular expression, see vanilla/regex.hpp. regex(pattern)
+    // returns the one in a process-wide cache of the CACHE_SIZE most
+    // recently used patterns if it's there.
+    //
+    // Scripts use the elements match(text), search(text, start = 0),
+    // findall(text), replace(text, replacement, count = all) and pattern.
+    // match and search return the matched slice of text or none, match
+    // only a match at the beginning. After an empty match, the next one is
+    // searched one character later.
+    class regex_object : public object
+    {
+    public:
+        static std::size_t const CACHE_SIZE = 64;
+        
+    private:
+        std::string _pattern;
+        regex _regex;
+        
+    public:
+        explicit regex_object(cstr_range pattern);
+        
+        std::string const& pattern() const
+        {
+            return _pattern;
+        }
+        
+        bool search(cstr_range text, std::size_t from, bool anchored, regex::span& result)
+        {
+            return _regex.search(text, from, anchored, result);
+        }
+        
+        // An array of the matched slices of text, which has to be a string.
+        object::ptr find_all(object::ptr const& text);
+        
+        // A new string with the first max matches replaced.
+        object::ptr replace(object::ptr const& text, cstr_range replacement, std::size_t max);
+        
+        virtual object_type_id type_id() const override;
+        virtual ptr type_name() const override;
+        
+        virtual ptr copy(bool deep) const override;
+        
+        virtual ptr to_string() const override;
+        
+        // Element selection.
+        virtual ptr eget(std::string const& name);
+    };
+    
+    // The regex_object for pattern, compiled unless it's in the cache.
+    object::ptr get_regex(cstr_range pattern);
+    
+    // The builtin regex(pattern).
+    object::ptr make_regex_function();
+}
+
+#endif // HEADER_UUID_9F59A8F636AE4CF98A5025C5E659C04A
@@ -143,7 +143,8 @@ namespace vanilla
         int read_token(token&);
         
     public:
-        scanner(cstr_range const& data);
+        // line and pos are where data starts in its file.
+        scanner(cstr_range const& data, unsigned line = 1, unsigned pos = 1);
         
         token get_token();
         unsigned line() const;
@@ -0,0 +1,111 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_C4AD22EEAE214AB09ED22C391A0A87AB
+#define HEADER_UUID_C4AD22EEAE214AB09ED22C391A0A87AB
+
+// C++ Standard Library:
+#include <cstddef>
+#include <string>
+
+// Vanilla:
+#include <vanilla/object.hpp>
+#include <vanilla/str_range.hpp>
+
+namespace vanilla
+{
+    // A mutable buffer that text is appended to, for assembling strings
+    // without a string_object per step. Ints and floats are formatted
+    // straight into the buffer. finish() hands the buffer to a new
+    // string_object and leaves the builder empty.
+    //
+    // Scripts use the elements append(values...), format(format, values...),
+    // finish(), length and string; string_builder() creates one.
+    class string_builder_object : public object
+    {
+    private:
+        char* _data;
+        std::size_t _size;
+        std::size_t _capacity;  // Without the terminating zero.
+        
+    public:
+        string_builder_object();
+        ~string_builder_object();
+        
+        std::size_t size() const
+        {
+            return _size;
+        }
+        
+        cstr_range value() const
+        {
+            return cstr_range(_data, _data + _size);
+        }
+        
+        // Room for at least n more characters; returns where they go.
+        char* reserve(std::size_t n);
+        
+        // Characters written to reserve() up to end become part of the text.
+        void commit(char* end)
+        {
+            _size = end - _data;
+        }
+        
+        void append(cstr_range v);
+        
+        // Strings, ints and floats without to_string().
+        void append(object::ptr const& v);
+        
+        // printf style: %[-+0][width][.precision] followed by d, x, X, o,
+        // b, f, e, g or s; %% is a percent sign. Integer conversions take
+        // ints, floating point ones ints or floats. Widths, and the
+        // precision of s, count characters. Throws invalid_format_error for
+        // anything else, and for widths or precisions above 65536.
+        void append_format(cstr_range format, object::ptr const* argv, unsigned argc);
+        
+        object::ptr finish();
+        
+        virtual object_type_id type_id() const override;
+        virtual ptr type_name() const override;
+        
+        virtual ptr copy(bool deep) const override;
+        
+        virtual ptr to_string() const override;
+        
+        // Element selection.
+        virtual ptr eget(std::string const& name);
+    };
+    
+    namespace error
+    {
+        struct invalid_format_error : evaluation_error
+        { };
+        
+        VANILLA_MAKE_ERRINFO(std::string, format_string)
+    }
+    
+    // The builtins string_builder() and format(format, values...), the
+    // latter returning a string.
+    object::ptr make_string_builder_function();
+    object::ptr make_format_function();
+}
+
+#endif // HEADER_UUID_C4AD22EEAE214AB09ED22C391A0A87AB
@@ -24,24 +24,185 @@
 
 // C++ Standard Library:
 #include <string>
+#include <cstring>
+#include <cstdint>
 
 // Vanilla:
 #include <vanilla/object.hpp>
+#include <vanilla/str_range.hpp>
 
 namespace vanilla
 {   
+    // The characters are stored right after the object, followed by a
+    // terminating zero; see object_size<string_object>. A string that is
+    // appended to in place moves them to a heap buffer with room to grow.
+    //
+    // Long results of concat are ropes instead: the two operands are stored
+    // after the object, and the characters are only copied into a buffer
+    // of their own once somebody asks for them (flattening).
+    //
+    // Slices are views: the string they were taken from is stored after
+    // the object, and the view points into its characters. Views aren't
+    // zero terminated, c_str() copies the characters first.
+    //
+    // String literals are interned, equal interned strings are the same
+    // object. The hash is computed once.
+    //
+    // Scripts index and slice by characters, see vanilla/utf8.hpp. The
+    // characters are counted on first use; ASCII strings then map them to
+    // bytes directly, others build a table of the byte offset of every
+    // INDEX_STRIDE-th character and scan from there.
     class string_object : public object
     {
     public:
-        typedef std::string string_type;
+        typedef cstr_range string_type;
+        
+        // Shorter results of concat are copied right away.
+        static std::size_t const MIN_ROPE_SIZE = 256;
+        
+        // Shorter slices are copied right away, as are slices of less than
+        // 1/COMPACT_RATIO of a string of at least COMPACT_SIZE bytes, so
+        // that small views don't keep huge strings alive.
+        static std::size_t const MIN_VIEW_SIZE = 64;
+        static std::size_t const COMPACT_SIZE = 1 << 20;
+        static std::size_t const COMPACT_RATIO = 16;
+        
+        static std::size_t const INDEX_STRIDE = 32;
+        
+        struct concatenation_tag { };
+        struct view_tag { };
+        struct buffer_tag { };
+        struct uninitialized_tag { };
         
     private:
-        string_type _v;
+        enum class representation : std::uint8_t
+        {
+            flat,
+            concatenation,
+            view,
+            copied          // A concatenation or view that released its references.
+        };
+        
+        enum class encoding : std::uint8_t
+        {
+            unknown,        // Not counted yet.
+            ascii,
+            utf8
+        };
+        
+        std::size_t _size;
+        mutable std::size_t _capacity;  // Without the terminating zero.
+        mutable char* _data;            // Null while a concatenation.
+        mutable std::size_t _hash;      // 0 until computed.
+        mutable representation _representation;
+        bool _interned;
+        mutable encoding _encoding;
+        mutable std::size_t _length;    // In characters, once counted.
+        mutable std::size_t* _index;    // Null until needed.
+        
+        char* storage() const
+        {
+            return reinterpret_cast<char*>(const_cast<string_object*>(this)) + sizeof(string_object);
+        }
+        
+        // The operands of a concatenation, or the string a view is a slice
+        // of and an empty reference.
+        object::ptr* operands() const
+        {
+            return reinterpret_cast<object::ptr*>(storage());
+        }
+        
+        // Characters of its own for a concatenation or view.
+        void flatten() const;
+        void copy_view() const;
+        
+        void append(cstr_range v);
+        
+        void count_characters() const;
+        void build_index() const;
         
     public:
-        explicit string_object(string_type v);
+        explicit string_object(cstr_range v);
+        string_object(cstr_range first, cstr_range second);
+        explicit string_object(std::string const& v);
+        explicit string_object(char const* v);
+        
+        // Both have to be strings.
+        string_object(concatenation_tag, object::ptr first, object::ptr second);
+        
+        // The size characters of parent, which has to be a flat string, from
+        // offset on.
+        string_object(view_tag, object::ptr parent, std::size_t offset, std::size_t size);
+        
+        // Takes over data, allocated by new char[capacity + 1] and holding
+        // size characters and a terminating zero.
+        string_object(buffer_tag, char* data, std::size_t size, std::size_t capacity);
+        
+        // size characters, written by whoever creates the string.
+        string_object(uninitialized_tag, std::size_t size);
+        
+        ~string_object();
+        
+        string_type value() const;
+        
+        std::size_t size() const
+        {
+            return _size;
+        }
+        
+        char const* c_str() const
+        {
+            if(_representation == representation::view)
+                copy_view();
+            return value().begin();
+        }
+        
+        // The characters from begin to end, usually as a view; unchecked.
+        object::ptr slice(std::size_t begin, std::size_t end) const;
+        
+        // The number of characters.
+        std::size_t length() const
+        {
+            if(_encoding == encoding::unknown)
+                count_characters();
+            return _length;
+        }
+        
+        // The byte offset of a character, at most length(); unchecked.
+        std::size_t byte_offset(std::size_t character) const;
         
-        string_type const& value() const;
+        // The number of characters that begin before a byte offset.
+        std::size_t character_offset(std::size_t byte) const;
+        
+        // An array of the slices between separators. split_whitespace
+        // splits at runs of whitespace and leaves out empty slices.
+        object::ptr split(cstr_range separator) const;
+        object::ptr split_whitespace() const;
+        
+        // A new string with the first max occurrences of old replaced, or
+        // this string if there are none. An empty old occurs before every
+        // character and at the end, as for count.
+        object::ptr replace(cstr_range old, cstr_range replacement, std::size_t max) const;
+        
+        // The slice without the given characters at either end.
+        object::ptr strip(cstr_range characters) const;
+        
+        virtual std::size_t hash() const override;
+        virtual bool equals(object const& other) const override;
+        
+        bool is_hashed() const
+        {
+            return _hash != 0;
+        }
+        
+        bool is_interned() const
+        {
+            return _interned;
+        }
+        
+        // The one interned string with the characters of v. Interned strings
+        // live until the process ends.
+        static object::ptr intern(cstr_range v);
         
         virtual object_type_id type_id() const override;
         virtual ptr type_name() const override;
@@ -50,11 +211,83 @@ namespace vanilla
         
         virtual ptr to_string() const override;
         
+        // Relational operations.
+        virtual ptr lt(object::ptr const& other);
+        virtual ptr le(object::ptr const& other);
+        virtual ptr gt(object::ptr const& other);
+        virtual ptr ge(object::ptr const& other);
+        
+        // Equality operations.
+        virtual ptr eq(object::ptr const& other);
+        virtual ptr neq(object::ptr const& other);
+        
         // Other.
         virtual ptr concat(object::ptr const& other);
+        
+        // Subscript, a string of the character at the index.
+        virtual ptr sget(object::ptr const& subscript);
+        
+        // Element selection: length, slice(begin, end = length),
+        // find(needle, start = 0), count(needle), split(separator =
+        // whitespace), replace(old, new, count = all), strip(characters =
+        // whitespace), starts_with(prefix) and ends_with(suffix).
+        virtual ptr eget(std::string const& name);
+        
+        // A concatenation references its operands; they can't form cycles,
+        // but are destroyed through the reclaimer like container elements.
+        virtual bool is_container() const override;
+        virtual void traverse(object_visitor& v) const override;
+        virtual void release_references() override;
+        virtual std::size_t memory_size() const override;
+    };
+    
+    template<>
+    struct object_size<string_object>
+    {
+        static std::size_t get(cstr_range const& v)
+        {
+            return sizeof(string_object) + v.length() + 1;
+        }
+        
+        static std::size_t get(std::string const& v)
+        {
+            return sizeof(string_object) + v.size() + 1;
+        }
+        
+        static std::size_t get(char const* v)
+        {
+            return sizeof(string_object) + std::strlen(v) + 1;
+        }
+        
+        static std::size_t get(cstr_range const& first, cstr_range const& second)
+        {
+            return sizeof(string_object) + first.length() + second.length() + 1;
+        }
+        
+        static std::size_t get(string_object::concatenation_tag, object::ptr const&, object::ptr const&)
+        {
+            return sizeof(string_object) + 2 * sizeof(object::ptr);
+        }
+        
+        static std::size_t get(string_object::view_tag, object::ptr const&, std::size_t, std::size_t)
+        {
+            return sizeof(string_object) + 2 * sizeof(object::ptr);
+        }
+        
+        static std::size_t get(string_object::buffer_tag, char*, std::size_t, std::size_t)
+        {
+            return sizeof(string_object);
+        }
+        
+        static std::size_t get(string_object::uninitialized_tag, std::size_t size)
+        {
+            return sizeof(string_object) + size + 1;
+        }
     };
     
-    std::string const& string_object_to_cpp_string(object::ptr const& obj);
+    // The range is valid as long as obj is, and not zero terminated.
+    cstr_range string_object_to_range(object::ptr const& obj);
+    std::string string_object_to_cpp_string(object::ptr const& obj);
 }
 
 #endif // HEADER_UUID_1DD4B72D0EF4494E884EB43C4103E74D
\ No newline at end of file
@@ -0,0 +1,85 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_0D6EAE9B713B44ABBDC69739777123A1
+#define HEADER_UUID_0D6EAE9B713B44ABBDC69739777123A1
+
+// C++ Standard Library:
+#include <cstddef>
+
+// Vanilla:
+#include <vanilla/str_range.hpp>
+
+namespace vanilla
+{
+    // Substring search for the string methods. Short needles are found by
+    // comparing their first and last byte with a whole vector of haystack
+    // positions at once (SSE2, or AVX2 when compiled for it) and only
+    // comparing the rest at positions where both match. Longer needles use
+    // the two-way algorithm, which is linear in the haystack size whatever
+    // the needle looks like.
+    namespace string_search
+    {
+        std::size_t const npos = std::size_t(-1);
+        
+        // Needles up to this length use the vector filter.
+        std::size_t const MAX_FILTERED_NEEDLE = 32;
+        
+        // Searches one needle in any number of haystacks; the needle has to
+        // stay valid.
+        class searcher
+        {
+        private:
+            cstr_range _needle;
+            
+            // The critical factorization of long needles: the last position
+            // of its first part, and the shift after a match.
+            std::ptrdiff_t _ell;
+            std::ptrdiff_t _period;
+            bool _is_periodic;
+            
+            std::size_t find_long(char const* haystack, std::size_t n) const;
+            
+        public:
+            explicit searcher(cstr_range needle);
+            
+            // The position of the first needle at or after from, or npos. An
+            // empty needle is found at from.
+            std::size_t find(cstr_range haystack, std::size_t from = 0) const;
+            
+            // The number of non-overlapping needles, at most max. An empty
+            // needle is found before every UTF-8 character and at the end.
+            std::size_t count(cstr_range haystack, std::size_t max = npos) const;
+        };
+        
+        inline std::size_t find(cstr_range haystack, cstr_range needle)
+        {
+            return searcher(needle).find(haystack);
+        }
+        
+        inline std::size_t count(cstr_range haystack, cstr_range needle)
+        {
+            return searcher(needle).count(haystack);
+        }
+    }
+}
+
+#endif // HEADER_UUID_0D6EAE9B713B44ABBDC69739777123A1
@@ -0,0 +1,108 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_D1D9E7F332FC432BB499008898F51A3B
+#define HEADER_UUID_D1D9E7F332FC432BB499008898F51A3B
+
+// C++ Standard Library:
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <ostream>
+
+namespace vanilla
+{
+    // Timeline tracing. Scoped events append begin/end records to a ring
+    // buffer owned by the recording thread, so recording takes no locks;
+    // the buffers are written out as Chrome trace-event JSON, which opens
+    // in Perfetto and chrome://tracing. Older events are overwritten once
+    // a thread's buffer is full.
+    namespace tracing
+    {
+        namespace detail
+        {
+            struct event
+            {
+                char const* name;
+                char const* category;
+                std::uint64_t timestamp; // Nanoseconds since start().
+                char phase;              // 'B' or 'E'.
+            };
+            
+            // Only changed while no traced code runs.
+            extern bool active;
+            
+            void record(char phase, char const* name, char const* category);
+            
+            // Returns a pointer that stays valid for the rest of the process,
+            // so callers can intern a name once and keep it. Takes a lock.
+            char const* intern(std::string const& name);
+        }
+        
+        // Records a begin event now and the matching end event when it goes
+        // out of scope. Does nothing unless tracing was started.
+        class scoped_event
+        {
+        private:
+            char const* _name;
+            char const* _category;
+            
+        public:
+            // Both strings must outlive the trace, e.g. literals or interned
+            // names. A null name records nothing.
+            scoped_event(char const* name, char const* category)
+                : _name(detail::active ? name : nullptr), _category(category)
+            {
+                if(_name)
+                    detail::record('B', _name, _category);
+            }
+            
+            // Interns the name, for events that are rarely recorded; code
+            // recording a name over and over interns it once instead.
+            scoped_event(std::string const& name, char const* category)
+                : _name(detail::active ? detail::intern(name) : nullptr), _category(category)
+            {
+                if(_name)
+                    detail::record('B', _name, _category);
+            }
+            
+            scoped_event(scoped_event const&) = delete;
+            scoped_event& operator=(scoped_event const&) = delete;
+            
+            ~scoped_event()
+            {
+                if(_name)
+                    detail::record('E', _name, _category);
+            }
+        };
+        
+        // Starts recording, discarding earlier events. Every thread gets a
+        // buffer of the given number of events when it first records.
+        void start(std::size_t events_per_thread = 1 << 20);
+        void stop();
+        
+        bool is_running();
+        
+        void write_chrome_json(std::ostream& o);
+    }
+}
+
+#endif // HEADER_UUID_D1D9E7F332FC432BB499008898F51A3B
@@ -0,0 +1,53 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+#ifndef HEADER_UUID_D203CFD5C6FE43379699544900CA1E6D
+#define HEADER_UUID_D203CFD5C6FE43379699544900CA1E6D
+
+// C++ Standard Library:
+#include <cstddef>
+
+// Vanilla:
+#include <vanilla/str_range.hpp>
+
+namespace vanilla
+{
+    // Characters of UTF-8 text. Malformed text isn't rejected: every byte
+    // that isn't a continuation byte begins a character, and so does the
+    // first byte.
+    namespace utf8
+    {
+        inline bool is_continuation(char c)
+        {
+            return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+        }
+        
+        // Also tells whether all bytes are ASCII. Vectorized with SSE2, or
+        // AVX2 when compiled for it.
+        std::size_t count_characters(cstr_range v, bool& is_ascii);
+        
+        // The offset of the character that begins count characters after
+        // the one at offset, or the size of v.
+        std::size_t skip_characters(cstr_range v, std::size_t offset, std::size_t count);
+    }
+}
+
+#endif // HEADER_UUID_D203CFD5C6FE43379699544900CA1E6D
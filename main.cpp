@@ -21,59 +21,280 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <typeinfo>
+#include <boost/core/demangle.hpp>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <string>
 #include <vanilla/error.hpp>
 #include <vanilla/parsing.hpp>
+#include <vanilla/program_cache.hpp>
 #include <vanilla/native_library_cache.hpp>
 #include <vanilla/gen/xml.hpp>
+#include <vanilla/gen/json.hpp>
+#include <vanilla/profiler.hpp>
+#include <vanilla/instrumentation.hpp>
+#include <vanilla/alloc_stats.hpp>
+#include <vanilla/tracing.hpp>
+#include <vanilla/cycle_collector.hpp>
+#include <vanilla/reclaimer.hpp>
 #include <vanilla/native_function_object.hpp>
+#include <vanilla/string_builder_object.hpp>
+#include <vanilla/regex_object.hpp>
+#include <vanilla/dict_object.hpp>
 
 using namespace vanilla;
 
+namespace
+{
+    // Prints [line:pos], or [file:line:pos] if the error knows its file.
+    std::ostream& print_location(std::ostream& o, error::base_error const& e)
+    {
+        o << '[';
+        if(error::get_file_info(e))
+            o << *error::get_file_info(e) << ':';
+        return o << *error::get_line_info(e) << ':' << *error::get_pos_info(e) << ']';
+    }
+    
+    // Parses a file with lazy and with eager function bodies and compares
+    // the JSON dumps, which parse the lazy bodies, or the errors. Catches
+    // the preparser accepting or rejecting code differently from the
+    // parser; a body the parser rejects after the preparser accepted it
+    // fails while dumping. Returns the exit status.
+    int check_lazy_parse(char const* filename)
+    {
+        std::string results[2];
+        for(bool lazy : { false, true })
+        {
+            std::ostringstream out;
+            char const* stage = "parsing";
+            try
+            {
+                statement_node::ptr ast = parse_file(filename, lazy);
+                stage = "parsing a lazy body";
+                gen::emit_json(ast.get(), out);
+            }
+            catch(error::base_error const& e)
+            {
+                out.str(std::string());
+                out << stage << ": " << boost::core::demangle(typeid(e).name());
+                if(error::get_line_info(e))
+                    print_location(out << ' ', e);
+            }
+            results[lazy] = out.str();
+        }
+        
+        if(results[false] == results[true])
+            return 0;
+        std::cerr   << filename << ": lazy parsing gives '" << results[true].substr(0, 200)
+                    << "', eager parsing '" << results[false].substr(0, 200) << "'\n";
+        return 1;
+    }
+    
+    // Profiles the evaluation and writes <filename>.folded and
+    // <filename>.lines when it ends, whether it failed or not.
+    class profile_session
+    {
+    private:
+        std::string _filename;
+        bool _enabled;
+        
+    public:
+        profile_session(std::string filename, bool enabled, unsigned frequency)
+            : _filename(std::move(filename)), _enabled(enabled)
+        {
+            if(_enabled)
+                profiler::start(frequency);
+        }
+        
+        ~profile_session()
+        {
+            if(!_enabled)
+                return;
+            
+            profiler::stop();
+            std::ofstream folded(_filename + ".folded");
+            profiler::write_folded_stacks(folded);
+            std::ofstream lines(_filename + ".lines");
+            profiler::write_line_table(lines);
+        }
+    };
+    
+    // Counts allocations during the evaluation and prints the tables to
+    // stderr when it ends.
+    class alloc_stats_session
+    {
+    private:
+        alloc_stats::mode _mode;
+        
+    public:
+        explicit alloc_stats_session(alloc_stats::mode m)
+            : _mode(m)
+        {
+            if(_mode != alloc_stats::mode::off)
+                alloc_stats::enable(_mode);
+        }
+        
+        ~alloc_stats_session()
+        {
+            if(_mode == alloc_stats::mode::off)
+                return;
+            
+            alloc_stats::write_report(std::cerr);
+            alloc_stats::enable(alloc_stats::mode::off);
+        }
+    };
+}
+
 int main(int argc, char **argv)
 {
     using namespace std;
     
-    if(argc != 2)
+    bool use_cache = true;
+    std::string dump_format;
+    unsigned jobs = 0;
+    bool profile = false;
+    unsigned profile_frequency = 1000;
+    alloc_stats::mode alloc_mode = alloc_stats::mode::off;
+    bool trace = false;
+    bool gc_stats = false;
+    bool background_reclaim = false;
+    bool lazy_parse_check = false;
+    
+    int arg = 1;
+    for(; arg < argc && std::strncmp(argv[arg], "--", 2) == 0; ++arg)
     {
-        cerr << "Usage: " << argv[0] << " <filename>\n";
+        std::string option(argv[arg]);
+        if(option == "--no-cache")
+            use_cache = false;
+        else if(option == "--dump-ast=xml" || option == "--dump-ast=json"
+            || option == "--dump-ast=binary")
+            dump_format = option.substr(std::strlen("--dump-ast="));
+        else if(option.compare(0, std::strlen("--jobs="), "--jobs=") == 0)
+            jobs = std::atoi(option.c_str() + std::strlen("--jobs="));
+        else if(option == "--profile")
+            profile = true;
+        else if(option.compare(0, std::strlen("--profile-hz="), "--profile-hz=") == 0)
+            profile = true, profile_frequency = std::atoi(option.c_str() + std::strlen("--profile-hz="));
+        else if(option == "--alloc-stats")
+            alloc_mode = alloc_stats::mode::types;
+        else if(option == "--alloc-stats=sites")
+            alloc_mode = alloc_stats::mode::sites;
+        else if(option == "--trace")
+            trace = true;
+        else if(option == "--gc-stats")
+            gc_stats = true;
+        else if(option == "--background-reclaim")
+            background_reclaim = true;
+        else if(option == "--check-lazy-parse")
+            lazy_parse_check = true;
+        else if(option.compare(0, std::strlen("--reclaim-budget="), "--reclaim-budget=") == 0)
+            reclaimer::set_budget(std::atoi(option.c_str() + std::strlen("--reclaim-budget=")));
+        else
+            break;
+    }
+    
+    if(arg == argc)
+    {
+        cerr    << "Usage: " << argv[0]
+                << " [--no-cache] [--dump-ast=xml|json|binary] [--jobs=N]"
+                << " [--profile] [--profile-hz=N] [--alloc-stats[=sites]]"
+                << " [--trace] [--gc-stats] [--background-reclaim]"
+                << " [--reclaim-budget=N] [--check-lazy-parse] <filename>...\n";
         return -1;
     }
     
+    // Only parses, for the parse tests.
+    if(lazy_parse_check)
+    {
+        int result = 0;
+        for(; arg < argc; ++arg)
+            result |= check_lazy_parse(argv[arg]);
+        return result;
+    }
+    
+    if(trace)
+        tracing::start();
+    // Objects are only shared with another thread by the reclaimer.
+    if(background_reclaim)
+    {
+        set_atomic_references(true);
+        reclaimer::start_background();
+    }
+    
+    // Set by the handlers below, reported errors still fail the run.
+    int result = 0;
     try
     {
         context c;
+        c.set_global_value("alloc_stats", alloc_stats::make_snapshot_function());
+        c.set_global_value("string_builder", make_string_builder_function());
+        c.set_global_value("format", make_format_function());
+        c.set_global_value("regex", make_regex_function());
         
-        auto ast = vanilla::parse_file(argv[1]);
-        ast->eval(c);
+        // Several files are parsed in parallel and run as one program, in
+        // the order given.
+        statement_node::ptr ast;
+        {
+            tracing::scoped_event phase("parse", "phase");
+            if(argc - arg > 1)
+                ast = vanilla::parse_files(std::vector<std::string>(argv + arg, argv + argc), jobs);
+            else if(use_cache)
+                ast = program_cache(program_cache::default_directory()).load(argv[arg]);
+            else
+                ast = vanilla::parse_file(argv[arg]);
+        }
+        
+        // Written to <filename>.<format>, before evaluation so that failing
+        // scripts can be inspected as well.
+        if(!dump_format.empty())
+        {
+            std::string filename = std::string(argv[arg]) + '.' + dump_format;
+            std::ofstream out(filename, std::ios::binary);
+            if(dump_format == "xml")
+                gen::emit_xml(ast.get(), out);
+            else if(dump_format == "json")
+                gen::emit_json(ast.get(), out);
+            else
+                write_program(ast.get(), 0, out);
+        }
         
-        std::string filename(argv[1]);
-        std::ofstream out(filename + ".xml");
-        gen::emit_xml(ast.get(), out);
+        alloc_stats_session allocations(alloc_mode);
+        profile_session session(argv[arg], profile, profile_frequency);
+        tracing::scoped_event phase("eval", "phase");
+        ast->eval(c);
     }
     catch(error::invalid_token_error const& e)
     {
-        cerr    << "[" << *error::get_line_info(e) << ':' << *error::get_pos_info(e)
-                << "] Scanning error : Start of invalid token\n";
+        result = 1;
+        print_location(cerr, e)
+                << " Scanning error : Start of invalid token\n";
     }
     catch(error::unexpected_token_error const& e)
     {
-        cerr    << "[" << *error::get_line_info(e) << ':' << *error::get_pos_info(e)
-                << "] Parsing error : Expected '" << *error::get_expected_type(e)
+        result = 1;
+        print_location(cerr, e)
+                << " Parsing error : Expected '" << *error::get_expected_type(e)
                 << "' token but got '" << *error::get_received_type(e) << "' token\n";
     }
     catch(error::expected_primary_expression_error const& e)
     {
-        cerr    << "[" << *error::get_line_info(e) << ':' << *error::get_pos_info(e)
-                << "] Parsing error : Expected primary expression but received '"
+        result = 1;
+        print_location(cerr, e)
+                << " Parsing error : Expected primary expression but received '"
                 << *error::get_received_type(e) << "' token\n";
     }
     catch(error::undefined_value_error const& e)
     {
+        result = 1;
         cerr    << "[" << *error::get_line_info(e) << ':' << *error::get_pos_info(e)
                 << "] Evaluation error : Undefined value '" << *error::get_value_name(e) << "'\n";
     }
     catch(error::bad_binary_operation_error const& e)
     {
+        result = 1;
         cerr    << "[" << *error::get_line_info(e) << ':' << *error::get_pos_info(e)
                 << "] Evaluation error : Can't apply binary operator '"
                 << *error::get_operation_name(e)
@@ -83,8 +304,44 @@ int main(int argc, char **argv)
                 << string_object_to_cpp_string((*error::get_second_operand(e))->type_name())
                 << "'\n"; 
     }
+    catch(error::key_not_found_error const& e)
+    {
+        result = 1;
+        // Element functions like get() throw without a location.
+        if(error::get_line_info(e))
+            print_location(cerr, e) << ' ';
+        cerr    << "Evaluation error : Key '"
+                << string_object_to_cpp_string((*error::get_missing_key(e))->to_string())
+                << "' not found\n";
+    }
+    catch(error::invalid_index_error const& e)
+    {
+        result = 1;
+        if(error::get_line_info(e))
+            print_location(cerr, e) << ' ';
+        cerr    << "Evaluation error : Index out of range\n";
+    }
+    catch(error::unsupported_operation_error const& e)
+    {
+        result = 1;
+        cerr    << "Evaluation error : Can't apply '" << *error::get_operation_name(e)
+                << "' to a value of type '"
+                << string_object_to_cpp_string((*error::get_first_operand(e))->type_name())
+                << "'\n";
+    }
+    catch(error::bad_cast_error const& e)
+    {
+        result = 1;
+        if(error::get_line_info(e))
+            print_location(cerr, e) << ' ';
+        cerr    << "Evaluation error : Expected a value of type '"
+                << *error::get_cast_target_name(e) << "' but got one of type '"
+                << string_object_to_cpp_string((*error::get_first_operand(e))->type_name())
+                << "'\n";
+    }
     catch(error::native_library_loading_error& e)
     {
+        result = 1;
         cerr    << "[" << *error::get_line_info(e) << ':' << *error::get_pos_info(e)
                 << "] Evaluation error : Failed to load native library '"
                 << *error::get_native_library_name(e) << '\'';
@@ -100,6 +357,7 @@ int main(int argc, char **argv)
     }
     catch(error::native_symbol_not_found_error& e)
     {
+        result = 1;
         cerr    << "[" << *error::get_line_info(e) << ':' << *error::get_pos_info(e)
                 << "] Evaluation error : Failed to load symbol '"
                 << *error::get_native_symbol_name(e) << "' from native library '"
@@ -116,14 +374,70 @@ int main(int argc, char **argv)
     }
     catch(error::unknown_native_type_name_error& e)
     {
+        result = 1;
         cerr    << "[" << *error::get_line_info(e) << ':' << *error::get_pos_info(e)
                 << "] Evaluation error : Native type name '"
                 << *error::get_native_type_name(e) << "' is currently not supported\n";
     }
     catch(error::void_as_argument_type_error& e)
     {
+        result = 1;
         cerr    << "[" << *error::get_line_info(e) << ':' << *error::get_pos_info(e)
                 << "] Evaluation error : void used as argument type for native function\n";
     }
+    catch(error::invalid_format_error& e)
+    {
+        result = 1;
+        cerr    << "Evaluation error : Invalid format string '"
+                << *error::get_format_string(e) << "'\n";
+    }
+    catch(error::invalid_regex_error& e)
+    {
+        result = 1;
+        cerr    << "Evaluation error : Invalid regular expression '"
+                << *error::get_regex_pattern(e) << "' ("
+                << *error::get_error_string(e) << ")\n";
+    }
+    catch(error::profiler_error& e)
+    {
+        result = 1;
+        cerr    << "Profiler error : " << *error::get_error_string(e) << '\n';
+    }
+    catch(error::program_cache_error& e)
+    {
+        result = 1;
+        cerr    << "Program cache error : " << *error::get_error_string(e) << '\n';
+    }
+
+    if(trace)
+    {
+        tracing::stop();
+        std::ofstream out(std::string(argv[arg]) + ".trace.json");
+        tracing::write_chrome_json(out);
+    }
+    
+    reclaimer::stop_background();
+    
+    if(gc_stats)
+    {
+        cycle_collector::statistics s = cycle_collector::get_statistics();
+        cerr    << "Cycle collector: " << s.collections << " collections, "
+                << s.containers_scanned << " containers scanned, "
+                << s.containers_reclaimed << " reclaimed ("
+                << s.bytes_reclaimed << " bytes)\n";
+        
+        reclaimer::statistics r = reclaimer::get_statistics();
+        cerr    << "Reclaimer: " << r.containers_queued << " containers queued, "
+                << r.containers_deferred << " times deferred, "
+                << r.batches_handed_off << " batches handed off\n";
+    }
+    
+    // Only compiled in with -DVANILLA_INSTRUMENTATION=ON.
+    if(instrumentation::enabled())
+    {
+        std::ofstream out(std::string(argv[arg]) + ".counts.json");
+        instrumentation::write_json(out);
+    }
     
+    return result;
 }
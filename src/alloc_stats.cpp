@@ -0,0 +1,283 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <algorithm>
+#include <iomanip>
+
+// Vanilla:
+#include <vanilla/alloc_stats.hpp>
+#include <vanilla/ast_base.hpp>
+#include <vanilla/profiler.hpp>
+#include <vanilla/array_object.hpp>
+#include <vanilla/int_object.hpp>
+#include <vanilla/string_object.hpp>
+#include <vanilla/function_object.hpp>
+
+namespace
+{
+    struct site
+    {
+        unsigned line;
+        unsigned pos;
+        bool toplevel;
+        std::uint64_t live;
+        std::uint64_t total;
+        std::uint64_t live_bytes;
+        std::uint64_t total_bytes;
+    };
+    
+    struct type_record
+    {
+        std::string name;
+        std::uint64_t live;
+        std::uint64_t total;
+        std::uint64_t live_bytes;
+        std::uint64_t total_bytes;
+    };
+    
+    struct accounting_state
+    {
+        vanilla::alloc_stats::mode mode;
+        std::map<std::uint32_t, type_record> types;
+        std::unordered_map<vanilla::ast_node const*, site> sites;
+        site toplevel;
+        
+        // Size and site of every counted object that is alive.
+        std::unordered_map<vanilla::object const*, std::pair<std::size_t, site*>> objects;
+    };
+    
+    // Never destroyed, objects may still be released during static
+    // destruction.
+    accounting_state& state()
+    {
+        static accounting_state* s = new accounting_state();
+        return *s;
+    }
+    
+    template<typename Record>
+    void count_allocation(Record& r, std::size_t bytes)
+    {
+        ++r.live;
+        ++r.total;
+        r.live_bytes += bytes;
+        r.total_bytes += bytes;
+    }
+    
+    // Objects allocated before the counters were reset are ignored.
+    template<typename Record>
+    void count_deallocation(Record& r, std::size_t bytes)
+    {
+        if(r.live == 0 || r.live_bytes < bytes)
+            return;
+        --r.live;
+        r.live_bytes -= bytes;
+    }
+    
+    site* current_site()
+    {
+        accounting_state& s = state();
+        if(s.mode != vanilla::alloc_stats::mode::sites)
+            return nullptr;
+        
+        vanilla::ast_node const* n = vanilla::profiler::detail::published.current;
+        if(!n)
+            return &s.toplevel;
+        
+        auto iter = s.sites.find(n);
+        if(iter == s.sites.end())
+        {
+            site fresh = { n->get_line(), n->get_pos(), false, 0, 0, 0, 0 };
+            iter = s.sites.emplace(n, fresh).first;
+        }
+        return &iter->second;
+    }
+    
+    void write_counts(std::ostream& o, std::uint64_t live, std::uint64_t total,
+        std::uint64_t live_bytes, std::uint64_t total_bytes)
+    {
+        o   << std::setw(12) << live << std::setw(12) << total
+            << std::setw(14) << live_bytes << std::setw(14) << total_bytes << '\n';
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::alloc_stats::detail
+///////////////////////////////////////////////////////////////////////////
+
+bool vanilla::alloc_stats::detail::active = false;
+
+void vanilla::alloc_stats::detail::allocated(object& obj, std::size_t bytes)
+{
+    accounting_state& s = state();
+    site* at = current_site();
+    s.objects[&obj] = std::make_pair(bytes, at);
+    obj.set_flag(object::FLAG_ACCOUNTED);
+    
+    type_record& r = s.types[obj.type_id()];
+    if(r.total == 0)
+    {
+        // The name itself must not be counted.
+        active = false;
+        r.name = string_object_to_cpp_string(obj.type_name());
+        active = true;
+    }
+    
+    count_allocation(r, bytes);
+    if(at)
+        count_allocation(*at, bytes);
+}
+
+void vanilla::alloc_stats::detail::deallocated(object const& obj)
+{
+    accounting_state& s = state();
+    auto allocation = s.objects.find(&obj);
+    if(allocation == s.objects.end())
+        return;
+    
+    std::size_t bytes = allocation->second.first;
+    site* at = allocation->second.second;
+    s.objects.erase(allocation);
+    
+    auto iter = s.types.find(obj.type_id());
+    if(iter != s.types.end())
+        count_deallocation(iter->second, bytes);
+    if(at)
+        count_deallocation(*at, bytes);
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// FREE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////
+
+void vanilla::alloc_stats::enable(mode m)
+{
+    accounting_state& s = state();
+    s.mode = m;
+    s.types.clear();
+    s.sites.clear();
+    s.objects.clear();
+    s.toplevel = site{ 0, 0, true, 0, 0, 0, 0 };
+    detail::active = m != mode::off;
+}
+
+vanilla::alloc_stats::mode vanilla::alloc_stats::current_mode()
+{
+    return state().mode;
+}
+
+void vanilla::alloc_stats::write_report(std::ostream& o)
+{
+    accounting_state& s = state();
+    
+    std::vector<type_record const*> types;
+    for(auto const& cur : s.types)
+        types.push_back(&cur.second);
+    std::sort(types.begin(), types.end(),
+        [](type_record const* a, type_record const* b) { return a->live_bytes > b->live_bytes; });
+    
+    o   << "Allocations by type:\n"
+        << std::left << std::setw(20) << "  type" << std::right
+        << std::setw(12) << "live" << std::setw(12) << "total"
+        << std::setw(14) << "live bytes" << std::setw(14) << "total bytes" << '\n';
+    for(type_record const* cur : types)
+    {
+        o << "  " << std::left << std::setw(18) << cur->name << std::right;
+        write_counts(o, cur->live, cur->total, cur->live_bytes, cur->total_bytes);
+    }
+    
+    if(s.mode != mode::sites)
+        return;
+    
+    // Several nodes can share a position, e.g. after lazy parsing.
+    std::map<std::tuple<bool, unsigned, unsigned>, site> merged;
+    merged[std::make_tuple(true, 0u, 0u)] = s.toplevel;
+    for(auto const& cur : s.sites)
+    {
+        site& m = merged[std::make_tuple(false, cur.second.line, cur.second.pos)];
+        m.line = cur.second.line;
+        m.pos = cur.second.pos;
+        m.live += cur.second.live;
+        m.total += cur.second.total;
+        m.live_bytes += cur.second.live_bytes;
+        m.total_bytes += cur.second.total_bytes;
+    }
+    
+    std::vector<std::pair<std::string, site>> sites;
+    for(auto const& cur : merged)
+    {
+        if(cur.second.total == 0)
+            continue;
+        std::string name = std::get<0>(cur.first) ? "<outside>"
+            : std::to_string(cur.second.line) + ':' + std::to_string(cur.second.pos);
+        sites.emplace_back(std::move(name), cur.second);
+    }
+    std::sort(sites.begin(), sites.end(),
+        [](std::pair<std::string, site> const& a, std::pair<std::string, site> const& b)
+        { return a.second.live_bytes > b.second.live_bytes
+            || (a.second.live_bytes == b.second.live_bytes && a.second.total > b.second.total); });
+    
+    o   << "Allocations by statement:\n"
+        << std::left << std::setw(20) << "  line:pos" << std::right
+        << std::setw(12) << "live" << std::setw(12) << "total"
+        << std::setw(14) << "live bytes" << std::setw(14) << "total bytes" << '\n';
+    for(auto const& cur : sites)
+    {
+        o << "  " << std::left << std::setw(18) << cur.first << std::right;
+        write_counts(o, cur.second.live, cur.second.total, cur.second.live_bytes, cur.second.total_bytes);
+    }
+}
+
+vanilla::object::ptr vanilla::alloc_stats::snapshot()
+{
+    // Copied first, building the result allocates.
+    std::vector<type_record> types;
+    for(auto const& cur : state().types)
+        types.push_back(cur.second);
+    
+    array_object::array_type result;
+    result.reserve(types.size());
+    for(type_record const& cur : types)
+    {
+        array_object::array_type row;
+        row.push_back(allocate_object<string_object>(cur.name));
+        row.push_back(allocate_object<int_object>(static_cast<unsigned long>(cur.live)));
+        row.push_back(allocate_object<int_object>(static_cast<unsigned long>(cur.total)));
+        row.push_back(allocate_object<int_object>(static_cast<unsigned long>(cur.live_bytes)));
+        row.push_back(allocate_object<int_object>(static_cast<unsigned long>(cur.total_bytes)));
+        result.push_back(allocate_object<array_object>(std::move(row)));
+    }
+    return allocate_object<array_object>(std::move(result));
+}
+
+vanilla::object::ptr vanilla::alloc_stats::make_snapshot_function()
+{
+    return allocate_object<function_object>(
+        "alloc_stats",
+        std::vector<function_argument>(),
+        [](context&, object::ptr*, unsigned) { return snapshot(); },
+        false);
+}
@@ -21,11 +21,15 @@
 
 // C++ Standard Library:
 #include <unordered_map>
+#include <algorithm>
+#include <new>
 
 // Vanilla:
 #include <vanilla/array_object.hpp>
 #include <vanilla/string_object.hpp>
 #include <vanilla/int_object.hpp>
+#include <vanilla/cycle_collector.hpp>
+#include <vanilla/reclaimer.hpp>
 
 ///////////////////////////////////////////////////////////////////////////
 /////////// UTILITY
@@ -43,23 +47,176 @@ namespace
             "length", [](vanilla::array_object* obj) -> vanilla::object::ptr
             {
                 return vanilla::allocate_object<vanilla::int_object>(
-                    obj->value().size());
+                    obj->size());
+            }
+        },
+        {   
+            "copy", [](vanilla::array_object* obj) -> vanilla::object::ptr
+            {
+                return obj->copy();
             }
         },
     };
+    
+    // Same policy as the reference counts, borrowers may die on the
+    // background reclaimer.
+    void add_borrower(std::atomic<std::uint32_t>& borrowers)
+    {
+        if(vanilla::detail::atomic_references)
+            borrowers.fetch_add(1, std::memory_order_relaxed);
+        else
+            borrowers.store(borrowers.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    
+    void remove_borrower(std::atomic<std::uint32_t>& borrowers)
+    {
+        if(vanilla::detail::atomic_references)
+            borrowers.fetch_sub(1, std::memory_order_acq_rel);
+        else
+            borrowers.store(borrowers.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    }
+    
+    // A heap buffer holding the first size references of slots.
+    vanilla::object::ptr* copy_slots(vanilla::object::ptr const* slots,
+        std::size_t size, std::size_t capacity)
+    {
+        vanilla::object::ptr* result = static_cast<vanilla::object::ptr*>(
+            ::operator new(capacity * sizeof(vanilla::object::ptr)));
+        for(std::size_t i = 0; i < size; ++i)
+            new(result + i) vanilla::object::ptr(slots[i]);
+        for(std::size_t i = size; i < capacity; ++i)
+            new(result + i) vanilla::object::ptr();
+        return result;
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////
 /////////// vanilla::array_object
 ///////////////////////////////////////////////////////////////////////////
  
+vanilla::array_object::array_object(std::size_t size)
+    : _size(size), _capacity(size), _slots(inline_slots()),
+    _lent(nullptr), _lent_size(0), _borrowers(0)
+{
+    for(std::size_t i = 0; i < size; ++i)
+        new(_slots + i) object::ptr();
+}
+
 vanilla::array_object::array_object(array_type v)
-    : _v(std::move(v))
-{ }
-        
-vanilla::array_object::array_type const& vanilla::array_object::value() const
+    : _size(v.size()), _capacity(v.size()), _slots(inline_slots()),
+    _lent(nullptr), _lent_size(0), _borrowers(0)
+{
+    for(std::size_t i = 0; i < _size; ++i)
+        new(_slots + i) object::ptr(std::move(v[i]));
+}
+
+vanilla::array_object::array_object(borrow_tag, array_object const& store)
+    : _size(store._lent_size), _capacity(0), _slots(store._lent),
+    _store(const_cast<array_object*>(&store)),
+    _lent(nullptr), _lent_size(0), _borrowers(0)
+{
+    add_borrower(store._borrowers);
+}
+
+vanilla::array_object::~array_object()
+{
+    if(_store)
+    {
+        return_slots();
+        return;
+    }
+    
+    // The store outlives its borrowers, they reference it.
+    release_lent();
+    
+    // Nested arrays would otherwise be destroyed recursively.
+    reclaimer::release(_slots, _size);
+    
+    for(std::size_t i = 0; i < _capacity; ++i)
+        _slots[i].~ptr();
+    if(_slots != inline_slots())
+        ::operator delete(_slots);
+}
+
+void vanilla::array_object::return_slots()
 {
-    return _v;
+    remove_borrower(static_cast<array_object*>(_store.get())->_borrowers);
+    _slots = nullptr;
+    _size = 0;
+    reclaimer::release(&_store, 1);
+}
+
+void vanilla::array_object::release_lent() const
+{
+    if(!_lent)
+        return;
+    
+    // Still the current slots, they are simply owned again.
+    object::ptr* lent = _lent;
+    _lent = nullptr;
+    if(lent == _slots)
+        return;
+    
+    reclaimer::release(lent, _lent_size);
+    for(std::size_t i = 0; i < _lent_size; ++i)
+        lent[i].~ptr();
+    if(lent != inline_slots())
+        ::operator delete(lent);
+}
+
+void vanilla::array_object::make_writable()
+{
+    if(_store)
+    {
+        std::size_t size = _size;
+        object::ptr* slots = copy_slots(_slots, size, size);
+        return_slots();
+        _size = size;
+        _capacity = size;
+        _slots = slots;
+        return;
+    }
+    
+    if(!_lent || _lent != _slots)
+        return;
+    
+    if(_borrowers.load(std::memory_order_acquire) == 0)
+    {
+        release_lent();
+        return;
+    }
+    
+    // Only the first _size slots of a lent buffer stay alive, the
+    // rest are empty anyway.
+    _slots = copy_slots(_lent, _size, _capacity);
+    for(std::size_t i = _size; i < _capacity; ++i)
+        _lent[i].~ptr();
+}
+
+void vanilla::array_object::grow()
+{
+    std::size_t capacity = std::max<std::size_t>(4, _capacity * 2);
+    object::ptr* slots = static_cast<object::ptr*>(::operator new(capacity * sizeof(object::ptr)));
+    for(std::size_t i = 0; i < _capacity; ++i)
+    {
+        new(slots + i) object::ptr(std::move(_slots[i]));
+        _slots[i].~ptr();
+    }
+    for(std::size_t i = _capacity; i < capacity; ++i)
+        new(slots + i) object::ptr();
+    
+    if(_slots != inline_slots())
+        ::operator delete(_slots);
+    _slots = slots;
+    _capacity = capacity;
+}
+
+void vanilla::array_object::append(ptr value)
+{
+    make_writable();
+    if(_size == _capacity)
+        grow();
+    _slots[_size++] = std::move(value);
 }
         
 vanilla::object_type_id vanilla::array_object::type_id() const
@@ -75,29 +232,50 @@ vanilla::object::ptr vanilla::array_object::type_name() const
 vanilla::object::ptr vanilla::array_object::copy(bool deep) const
 {
     if(!deep)
-        return allocate_object<array_object>(_v);
+    {
+        if(_store)
+            return allocate_object<array_object>(borrow_tag(), static_cast<array_object const&>(*_store));
+        
+        if(_lent && _lent != _slots && _borrowers.load(std::memory_order_acquire) == 0)
+            release_lent();
+        if(!_lent)
+        {
+            _lent = _slots;
+            _lent_size = _size;
+        }
+        
+        // Otherwise the lent slots are outdated and still borrowed.
+        if(_lent == _slots)
+            return allocate_object<array_object>(borrow_tag(), *this);
+    }
     
-    array_type deep_copies;
-    deep_copies.reserve(_v.size());
-    for(object::ptr const& o : _v)
-        deep_copies.emplace_back(o->copy(true));
-    return allocate_object<array_object>(std::move(deep_copies));
+    object::ptr result = allocate_object<array_object>(_size);
+    array_object* copies = static_cast<array_object*>(result.get());
+    for(std::size_t i = 0; i < _size; ++i)
+        copies->_slots[i] = deep ? _slots[i]->copy(true) : _slots[i];
+    return result;
 }
 
 vanilla::object::ptr vanilla::array_object::sget(object::ptr const& subscript)
 {
     long index = int_object_to_signed_long(subscript->to_int());
-    if(index < 0 || index >= _v.size())
+    if(index < 0 || index >= _size)
         BOOST_THROW_EXCEPTION(error::invalid_index_error());
-    return _v[index];
+    return _slots[index];
 }
 
 void vanilla::array_object::sset(object::ptr const& subscript, ptr value)
 {
     long index = int_object_to_signed_long(subscript->to_int());
-    if(index < 0 || index >= _v.size())
+    if(index < 0 || index >= _size)
         BOOST_THROW_EXCEPTION(error::invalid_index_error());
-    _v[index] = std::move(value);
+    
+    make_writable();
+    
+    // Only a store can close a cycle.
+    if(value->is_container())
+        cycle_collector::add_candidate(this);
+    _slots[index] = std::move(value);
 }
 
 vanilla::object::ptr vanilla::array_object::eget(std::string const& name)
@@ -111,4 +289,51 @@ vanilla::object::ptr vanilla::array_object::eget(std::string const& name)
 void vanilla::array_object::eset(std::string const& name, ptr value)
 {
     return object::eset(name, std::move(value));
-}
\ No newline at end of file
+}
+
+bool vanilla::array_object::is_container() const
+{
+    return true;
+}
+
+void vanilla::array_object::traverse(object_visitor& v) const
+{
+    // The borrowed slots are the store's references.
+    if(_store)
+    {
+        v.visit(_store);
+        return;
+    }
+    
+    for(std::size_t i = 0; i < _size; ++i)
+        v.visit(_slots[i]);
+    if(_lent && _lent != _slots)
+    {
+        for(std::size_t i = 0; i < _lent_size; ++i)
+            v.visit(_lent[i]);
+    }
+}
+
+void vanilla::array_object::release_references()
+{
+    if(_store)
+    {
+        return_slots();
+        return;
+    }
+    
+    // Lent slots are left empty, borrowers are dying too.
+    std::size_t size = _size;
+    _size = 0;
+    reclaimer::release(_slots, size);
+    if(_lent && _lent != _slots)
+        reclaimer::release(_lent, _lent_size);
+}
+
+std::size_t vanilla::array_object::memory_size() const
+{
+    std::size_t result = sizeof(array_object) + _capacity * sizeof(object::ptr);
+    if(_lent && _lent != _slots)
+        result += _lent_size * sizeof(object::ptr);
+    return result;
+}
@@ -73,6 +73,17 @@ vanilla::bool_object::bool_type vanilla::bool_object::value() const
     return _v;
 }
 
+std::size_t vanilla::bool_object::hash() const
+{
+    return mix_hash(_v.value);
+}
+
+bool vanilla::bool_object::equals(object const& other) const
+{
+    return other.type_id() == OBJECT_ID_BOOL
+        && static_cast<bool_object const&>(other)._v.value == _v.value;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 /////////// FREE FUNCTIONS
 ///////////////////////////////////////////////////////////////////////////
@@ -83,6 +83,17 @@ void vanilla::context::set_local_value(std::string name, object::ptr v)
     _locals.back()[std::move(name)] = std::move(v);
 }
 
+bool vanilla::context::release_value(std::string const& name, object::ptr const& v)
+{
+    auto& values = _locals.empty() ? _globals : _locals.back();
+    auto iter = values.find(name);
+    if(iter == values.end() || iter->second != v)
+        return false;
+    
+    iter->second.reset();
+    return true;
+}
+
 void vanilla::context::begin_stackframe()
 {
     _locals.resize(_locals.size() + 1);
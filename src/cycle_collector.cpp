@@ -0,0 +1,241 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// Vanilla:
+#include <vanilla/cycle_collector.hpp>
+#include <vanilla/object.hpp>
+
+namespace
+{
+    struct graph_node
+    {
+        long count;     // References from outside the scanned subgraph.
+        bool live;
+    };
+    
+    typedef std::unordered_map<vanilla::object*, graph_node> graph_type;
+    
+    // The candidates, flagged while buffered. They aren't owned: a candidate
+    // that dies removes itself, see detail::forget. Never destroyed,
+    // containers may still die during static destruction. The lock is for
+    // the background reclaimer, which destroys containers as well.
+    std::unordered_set<vanilla::object*>& candidates = *new std::unordered_set<vanilla::object*>();
+    std::mutex& candidates_lock = *new std::mutex();
+    std::size_t candidate_limit = vanilla::cycle_collector::DEFAULT_CANDIDATE_LIMIT;
+    std::size_t step_size = vanilla::cycle_collector::DEFAULT_STEP_SIZE;
+    vanilla::cycle_collector::statistics stats = { 0, 0, 0, 0 };
+    
+    // Adds every container reachable from the roots, subtracting one count
+    // per reference between them.
+    class discover_visitor : public vanilla::object_visitor
+    {
+    private:
+        graph_type& _graph;
+        std::vector<vanilla::object*>& _pending;
+        
+    public:
+        discover_visitor(graph_type& graph, std::vector<vanilla::object*>& pending)
+            : _graph(graph), _pending(pending)
+        { }
+        
+        void add(vanilla::object* o, long held)
+        {
+            graph_node n = { long(o->reference_count()) - held, false };
+            _graph.emplace(o, n);
+            _pending.push_back(o);
+        }
+        
+        virtual void visit(vanilla::object::ptr const& o) override
+        {
+            if(!o->is_container())
+                return;
+            
+            auto iter = _graph.find(o.get());
+            if(iter == _graph.end())
+            {
+                add(o.get(), 0);
+                iter = _graph.find(o.get());
+            }
+            --iter->second.count;
+        }
+    };
+    
+    // Marks containers reachable from an externally referenced one.
+    class mark_live_visitor : public vanilla::object_visitor
+    {
+    private:
+        graph_type& _graph;
+        std::vector<vanilla::object*>& _pending;
+        
+    public:
+        mark_live_visitor(graph_type& graph, std::vector<vanilla::object*>& pending)
+            : _graph(graph), _pending(pending)
+        { }
+        
+        virtual void visit(vanilla::object::ptr const& o) override
+        {
+            auto iter = _graph.find(o.get());
+            if(iter != _graph.end() && !iter->second.live)
+            {
+                iter->second.live = true;
+                _pending.push_back(o.get());
+            }
+        }
+    };
+    
+    // Takes up to count (0: all) candidates out of the buffer, skipping
+    // those that are already being destroyed.
+    std::vector<vanilla::object::ptr> take_candidates(std::size_t count)
+    {
+        std::vector<vanilla::object::ptr> result;
+        std::lock_guard<std::mutex> lock(candidates_lock);
+        auto iter = candidates.begin();
+        for(; iter != candidates.end() && (count == 0 || result.size() < count); ++iter)
+        {
+            vanilla::object::ptr o = vanilla::object::ptr::try_acquire(*iter);
+            if(!o)
+                continue;
+            o->clear_flag(vanilla::object::FLAG_CYCLE_CANDIDATE);
+            result.push_back(std::move(o));
+        }
+        candidates.erase(candidates.begin(), iter);
+        vanilla::cycle_collector::detail::pending = !candidates.empty();
+        return result;
+    }
+    
+    // Runs a trial deletion over the subgraph reachable from the roots,
+    // which are held for its duration.
+    void collect_roots(std::vector<vanilla::object::ptr>& roots)
+    {
+        using namespace vanilla;
+        
+        ++stats.collections;
+        
+        // Roots have one more reference, held by roots.
+        graph_type graph;
+        std::vector<object*> pending;
+        discover_visitor discover(graph, pending);
+        for(object::ptr const& root : roots)
+            discover.add(root.get(), 1);
+        while(!pending.empty())
+        {
+            object* cur = pending.back();
+            pending.pop_back();
+            cur->traverse(discover);
+        }
+        stats.containers_scanned += graph.size();
+        
+        // Everything reachable from an externally referenced container lives.
+        mark_live_visitor mark_live(graph, pending);
+        for(auto& cur : graph)
+        {
+            if(cur.second.count > 0 && !cur.second.live)
+            {
+                cur.second.live = true;
+                pending.push_back(cur.first);
+                while(!pending.empty())
+                {
+                    object* o = pending.back();
+                    pending.pop_back();
+                    o->traverse(mark_live);
+                }
+            }
+        }
+        
+        // Break the garbage cycles. Everything is held until all references
+        // are released, so no container dies while it is being cleared.
+        std::vector<object::ptr> garbage;
+        for(auto& cur : graph)
+        {
+            if(!cur.second.live)
+                garbage.emplace_back(cur.first);
+        }
+        roots.clear();
+        
+        for(object::ptr const& o : garbage)
+            stats.bytes_reclaimed += o->memory_size();
+        for(object::ptr const& o : garbage)
+            o->release_references();
+        stats.containers_reclaimed += garbage.size();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::cycle_collector::detail
+///////////////////////////////////////////////////////////////////////////
+
+bool vanilla::cycle_collector::detail::pending = false;
+
+///////////////////////////////////////////////////////////////////////////
+/////////// FREE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////
+
+void vanilla::cycle_collector::detail::forget(object const* container)
+{
+    std::lock_guard<std::mutex> lock(candidates_lock);
+    candidates.erase(const_cast<object*>(container));
+}
+
+void vanilla::cycle_collector::add_candidate(object* container)
+{
+    if(container->flags() & object::FLAG_CYCLE_CANDIDATE)
+        return;
+    
+    container->set_flag(object::FLAG_CYCLE_CANDIDATE);
+    std::lock_guard<std::mutex> lock(candidates_lock);
+    candidates.insert(container);
+    if(candidates.size() >= candidate_limit)
+        detail::pending = true;
+}
+
+void vanilla::cycle_collector::collect()
+{
+    std::vector<object::ptr> roots = take_candidates(0);
+    collect_roots(roots);
+}
+
+void vanilla::cycle_collector::collect_step()
+{
+    std::vector<object::ptr> roots = take_candidates(step_size);
+    collect_roots(roots);
+}
+
+void vanilla::cycle_collector::set_candidate_limit(std::size_t limit)
+{
+    candidate_limit = limit;
+}
+
+void vanilla::cycle_collector::set_step_size(std::size_t size)
+{
+    step_size = size;
+}
+
+vanilla::cycle_collector::statistics vanilla::cycle_collector::get_statistics()
+{
+    return stats;
+}
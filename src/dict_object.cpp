@@ -0,0 +1,508 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <climits>
+#include <cstring>
+#include <unordered_map>
+
+// Intrinsics:
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Vanilla:
+#include <vanilla/dict_object.hpp>
+#include <vanilla/array_object.hpp>
+#include <vanilla/string_object.hpp>
+#include <vanilla/int_object.hpp>
+#include <vanilla/bool_object.hpp>
+#include <vanilla/none_object.hpp>
+#include <vanilla/function_object.hpp>
+#include <vanilla/cycle_collector.hpp>
+#include <vanilla/reclaimer.hpp>
+
+///////////////////////////////////////////////////////////////////////////
+/////////// UTILITY
+///////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    using vanilla::dict_object;
+    
+    // Full slots have the tag of their key, 0 to 127.
+    std::int8_t const EMPTY = -128;
+    std::int8_t const DELETED = -2;
+    
+    std::int8_t tag_of(std::size_t hash)
+    {
+        return std::int8_t(hash >> (sizeof(std::size_t) * CHAR_BIT - 7));
+    }
+    
+    // Bit i of a match is set if control byte i of the group matches.
+    struct group
+    {
+#if defined(__SSE2__)
+        __m128i control;
+        
+        explicit group(std::int8_t const* p)
+            : control(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p)))
+        { }
+        
+        std::uint32_t match(std::int8_t tag) const
+        {
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(tag)));
+        }
+        
+        // Both have the sign bit set.
+        std::uint32_t match_empty_or_deleted() const
+        {
+            return _mm_movemask_epi8(control);
+        }
+#else
+        std::int8_t const* control;
+        
+        explicit group(std::int8_t const* p)
+            : control(p)
+        { }
+        
+        std::uint32_t match(std::int8_t tag) const
+        {
+            std::uint32_t result = 0;
+            for(std::size_t i = 0; i < dict_object::GROUP_SIZE; ++i)
+                result |= std::uint32_t(control[i] == tag) << i;
+            return result;
+        }
+        
+        std::uint32_t match_empty_or_deleted() const
+        {
+            std::uint32_t result = 0;
+            for(std::size_t i = 0; i < dict_object::GROUP_SIZE; ++i)
+                result |= std::uint32_t(control[i] < 0) << i;
+            return result;
+        }
+#endif
+        
+        std::uint32_t match_empty() const
+        {
+            return match(EMPTY);
+        }
+    };
+    
+    // Visits the groups starting at the low bits of the hash, each one
+    // further away than the last. Reaches every group of a power of two
+    // capacity.
+    class probe_sequence
+    {
+    private:
+        std::size_t _mask;
+        std::size_t _offset;
+        std::size_t _step;
+        
+    public:
+        probe_sequence(std::size_t hash, std::size_t capacity)
+            : _mask(capacity - 1), _offset(hash & _mask), _step(0)
+        { }
+        
+        std::size_t offset() const
+        {
+            return _offset;
+        }
+        
+        std::size_t slot(std::uint32_t bit) const
+        {
+            return (_offset + bit) & _mask;
+        }
+        
+        void next()
+        {
+            _step += dict_object::GROUP_SIZE;
+            _offset = (_offset + _step) & _mask;
+        }
+    };
+    
+    std::size_t find_free(std::int8_t const* control, std::size_t capacity, std::size_t hash)
+    {
+        for(probe_sequence seq(hash, capacity);; seq.next())
+        {
+            std::uint32_t free = group(control + seq.offset()).match_empty_or_deleted();
+            if(free)
+                return seq.slot(__builtin_ctz(free));
+        }
+    }
+    
+    void set_control(std::int8_t* control, std::size_t capacity, std::size_t slot, std::int8_t value)
+    {
+        control[slot] = value;
+        if(slot < dict_object::GROUP_SIZE)
+            control[capacity + slot] = value;
+    }
+    
+    // Entries fill the table up to 7/8.
+    std::size_t max_entries(std::size_t capacity)
+    {
+        return capacity - capacity / 8;
+    }
+    
+    std::unordered_map
+    <
+        std::string,
+        vanilla::object::ptr (*)(vanilla::dict_object*)
+    > const dict_object_elements =
+    {
+        {
+            "length", [](vanilla::dict_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::allocate_object<vanilla::int_object>(
+                    static_cast<unsigned long>(obj->size()));
+            }
+        },
+        {
+            "keys", [](vanilla::dict_object* obj) -> vanilla::object::ptr
+            {
+                return obj->keys();
+            }
+        },
+        {
+            "values", [](vanilla::dict_object* obj) -> vanilla::object::ptr
+            {
+                return obj->values();
+            }
+        },
+        {
+            "items", [](vanilla::dict_object* obj) -> vanilla::object::ptr
+            {
+                return obj->items();
+            }
+        },
+        {
+            "copy", [](vanilla::dict_object* obj) -> vanilla::object::ptr
+            {
+                return obj->copy();
+            }
+        },
+        {
+            "contains", [](vanilla::dict_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "contains",
+                    { vanilla::function_argument("key") },
+                    [](vanilla::dict_object* d, vanilla::object::ptr* argv, unsigned)
+                    {
+                        return vanilla::allocate_object<vanilla::bool_object>(
+                            static_cast<bool>(d->lookup(*argv[0])));
+                    });
+            }
+        },
+        {
+            "get", [](vanilla::dict_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "get",
+                    { vanilla::function_argument("key"), vanilla::function_argument("default", vanilla::allocate_object<vanilla::none_object>()) },
+                    [](vanilla::dict_object* d, vanilla::object::ptr* argv, unsigned)
+                    {
+                        vanilla::object::ptr value = d->lookup(*argv[0]);
+                        return value ? value : argv[1];
+                    });
+            }
+        },
+        {
+            "remove", [](vanilla::dict_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "remove",
+                    { vanilla::function_argument("key") },
+                    [](vanilla::dict_object* d, vanilla::object::ptr* argv, unsigned)
+                    {
+                        return vanilla::allocate_object<vanilla::bool_object>(d->remove(*argv[0]));
+                    });
+            }
+        },
+    };
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::dict_object
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::dict_object::dict_object()
+    :   _pairs(nullptr), _hashes(nullptr), _entries(0), _size(0),
+        _control(nullptr), _slots(nullptr), _capacity(0), _growth_left(0)
+{ }
+
+vanilla::dict_object::~dict_object()
+{
+    clear();
+}
+
+void vanilla::dict_object::clear()
+{
+    // Nested containers would otherwise be destroyed recursively.
+    reclaimer::release(_pairs, 2 * _entries);
+    
+    delete[] _pairs;
+    delete[] _hashes;
+    delete[] _control;
+    delete[] _slots;
+    _pairs = nullptr;
+    _hashes = nullptr;
+    _control = nullptr;
+    _slots = nullptr;
+    _entries = _size = _capacity = _growth_left = 0;
+}
+
+std::size_t vanilla::dict_object::find(object const& key, std::size_t hash) const
+{
+    if(!_capacity)
+        return _capacity;
+    
+    std::int8_t tag = tag_of(hash);
+    for(probe_sequence seq(hash, _capacity);; seq.next())
+    {
+        group g(_control + seq.offset());
+        for(std::uint32_t candidates = g.match(tag); candidates; candidates &= candidates - 1)
+        {
+            std::size_t slot = seq.slot(__builtin_ctz(candidates));
+            std::uint32_t i = _slots[slot];
+            object const& cur = *_pairs[2 * i];
+            if(_hashes[i] == hash && (&cur == &key || cur.equals(key)))
+                return slot;
+        }
+        
+        // The key would have been put into the first empty slot.
+        if(g.match_empty())
+            return _capacity;
+    }
+}
+
+void vanilla::dict_object::rehash()
+{
+    std::size_t capacity = MIN_CAPACITY;
+    while(max_entries(capacity) < 2 * (_size + 1))
+        capacity *= 2;
+    
+    std::size_t entries = max_entries(capacity);
+    object::ptr* pairs = new object::ptr[2 * entries];
+    std::size_t* hashes = new std::size_t[entries];
+    std::int8_t* control = new std::int8_t[capacity + GROUP_SIZE];
+    std::uint32_t* slots = new std::uint32_t[capacity];
+    
+    std::size_t n = 0;
+    for(std::size_t i = 0; i < _entries; ++i)
+    {
+        if(!_pairs[2 * i])
+            continue;
+        pairs[2 * n] = std::move(_pairs[2 * i]);
+        pairs[2 * n + 1] = std::move(_pairs[2 * i + 1]);
+        hashes[n++] = _hashes[i];
+    }
+    
+    std::memset(control, EMPTY, capacity + GROUP_SIZE);
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        std::size_t slot = find_free(control, capacity, hashes[i]);
+        set_control(control, capacity, slot, tag_of(hashes[i]));
+        slots[slot] = i;
+    }
+    
+    // The old pairs only hold the null references of removed entries.
+    delete[] _pairs;
+    delete[] _hashes;
+    delete[] _control;
+    delete[] _slots;
+    _pairs = pairs;
+    _hashes = hashes;
+    _control = control;
+    _slots = slots;
+    _entries = n;
+    _capacity = capacity;
+    _growth_left = entries - n;
+}
+
+vanilla::object::ptr vanilla::dict_object::lookup(object const& key) const
+{
+    std::size_t slot = find(key, key.hash());
+    if(slot == _capacity)
+        return object::ptr();
+    return _pairs[2 * _slots[slot] + 1];
+}
+
+void vanilla::dict_object::insert(object::ptr key, object::ptr value)
+{
+    std::size_t hash = key->hash();
+    std::size_t slot = find(*key, hash);
+    if(slot != _capacity)
+    {
+        _pairs[2 * _slots[slot] + 1] = std::move(value);
+        return;
+    }
+    
+    if(_growth_left == 0 || _entries == max_entries(_capacity))
+        rehash();
+    
+    slot = find_free(_control, _capacity, hash);
+    if(_control[slot] == EMPTY)
+        --_growth_left;
+    set_control(_control, _capacity, slot, tag_of(hash));
+    _slots[slot] = _entries;
+    
+    _pairs[2 * _entries] = std::move(key);
+    _pairs[2 * _entries + 1] = std::move(value);
+    _hashes[_entries] = hash;
+    ++_entries;
+    ++_size;
+}
+
+bool vanilla::dict_object::remove(object const& key)
+{
+    std::size_t slot = find(key, key.hash());
+    if(slot == _capacity)
+        return false;
+    
+    // Probes continue past deleted slots, other keys may be behind it.
+    set_control(_control, _capacity, slot, DELETED);
+    reclaimer::release(_pairs + 2 * _slots[slot], 2);
+    --_size;
+    return true;
+}
+
+vanilla::object::ptr vanilla::dict_object::keys() const
+{
+    object::ptr result = allocate_object<array_object>(_size);
+    array_object* keys = static_cast<array_object*>(result.get());
+    std::size_t n = 0;
+    for(std::size_t i = 0; i < _entries; ++i)
+    {
+        if(_pairs[2 * i])
+            keys->set(n++, _pairs[2 * i]);
+    }
+    return result;
+}
+
+vanilla::object::ptr vanilla::dict_object::values() const
+{
+    object::ptr result = allocate_object<array_object>(_size);
+    array_object* values = static_cast<array_object*>(result.get());
+    std::size_t n = 0;
+    for(std::size_t i = 0; i < _entries; ++i)
+    {
+        if(_pairs[2 * i])
+            values->set(n++, _pairs[2 * i + 1]);
+    }
+    return result;
+}
+
+vanilla::object::ptr vanilla::dict_object::items() const
+{
+    object::ptr result = allocate_object<array_object>(_size);
+    array_object* items = static_cast<array_object*>(result.get());
+    std::size_t n = 0;
+    for(std::size_t i = 0; i < _entries; ++i)
+    {
+        if(!_pairs[2 * i])
+            continue;
+        
+        object::ptr item = allocate_object<array_object>(2);
+        static_cast<array_object*>(item.get())->set(0, _pairs[2 * i]);
+        static_cast<array_object*>(item.get())->set(1, _pairs[2 * i + 1]);
+        items->set(n++, std::move(item));
+    }
+    return result;
+}
+
+vanilla::object_type_id vanilla::dict_object::type_id() const
+{
+    return OBJECT_ID_DICT;
+}
+
+vanilla::object::ptr vanilla::dict_object::type_name() const
+{
+    return allocate_object<string_object>("dict");
+}
+
+vanilla::object::ptr vanilla::dict_object::copy(bool deep) const
+{
+    object::ptr result = allocate_object<dict_object>();
+    dict_object* copies = static_cast<dict_object*>(result.get());
+    for(std::size_t i = 0; i < _entries; ++i)
+    {
+        if(_pairs[2 * i])
+            copies->insert(_pairs[2 * i], deep ? _pairs[2 * i + 1]->copy(true) : _pairs[2 * i + 1]);
+    }
+    return result;
+}
+
+vanilla::object::ptr vanilla::dict_object::sget(object::ptr const& subscript)
+{
+    object::ptr value = lookup(*subscript);
+    if(!value)
+        BOOST_THROW_EXCEPTION(error::key_not_found_error() << error::missing_key(subscript));
+    return value;
+}
+
+void vanilla::dict_object::sset(object::ptr const& subscript, ptr value)
+{
+    // Only a store can close a cycle.
+    if(value->is_container())
+        cycle_collector::add_candidate(this);
+    insert(subscript, std::move(value));
+}
+
+vanilla::object::ptr vanilla::dict_object::eget(std::string const& name)
+{
+    auto iter = dict_object_elements.find(name);
+    if(iter != dict_object_elements.end())
+        return iter->second(this);
+    return object::eget(name);
+}
+
+void vanilla::dict_object::eset(std::string const& name, ptr value)
+{
+    return object::eset(name, std::move(value));
+}
+
+bool vanilla::dict_object::is_container() const
+{
+    return true;
+}
+
+void vanilla::dict_object::traverse(object_visitor& v) const
+{
+    for(std::size_t i = 0; i < 2 * _entries; ++i)
+    {
+        if(_pairs[i])
+            v.visit(_pairs[i]);
+    }
+}
+
+void vanilla::dict_object::release_references()
+{
+    clear();
+}
+
+std::size_t vanilla::dict_object::memory_size() const
+{
+    std::size_t result = sizeof(dict_object);
+    if(_capacity)
+    {
+        result += max_entries(_capacity) * (2 * sizeof(object::ptr) + sizeof(std::size_t));
+        result += _capacity + GROUP_SIZE + _capacity * sizeof(std::uint32_t);
+    }
+    return result;
+}
@@ -25,8 +25,10 @@
 #include <vanilla/native_function_object.hpp>
 #include <vanilla/native_library_cache.hpp>
 #include <vanilla/function_object.hpp>
+#include <vanilla/instrumentation.hpp>
 #include <vanilla/bool_object.hpp>
 #include <vanilla/array_object.hpp>
+#include <vanilla/dict_object.hpp>
 
 ///////////////////////////////////////////////////////////////////////////
 /////////// vanilla::expression_node
@@ -88,6 +90,61 @@ vanilla::expression_node* vanilla::binary_expression_node::get_right()
     return _right.get();
 }
 
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::update_expression_node
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::update_expression_node::update_expression_node(
+            unsigned line,
+            unsigned pos,
+            expression_node::ptr left,
+            expression_node::ptr right)
+    :   binary_expression_node(line, pos, std::move(left), std::move(right))
+{ }
+
+vanilla::object::ptr vanilla::update_expression_node::eval(context& c)
+{
+    try
+    {
+        object::ptr left = _left->eval(c);
+        object::ptr right = _right->eval(c);
+        return apply(left, right);
+    }
+    catch(error::bad_binary_operation_error& e)
+    {
+        BOOST_THROW_EXCEPTION(e << error::line_info(get_line()) << error::pos_info(get_pos()));
+    }
+}
+
+vanilla::object::ptr vanilla::update_expression_node::eval_update(
+            context& c,
+            std::string const& name)
+{
+    object::ptr left = _left->eval(c);
+    object::ptr right = _right->eval(c);
+    
+    // Evaluating the right operand may have assigned the variable already.
+    bool released = c.release_value(name, left);
+    try
+    {
+        try
+        {
+            return apply(left, right);
+        }
+        catch(...)
+        {
+            // Operands are only changed once the operation can't fail.
+            if(released)
+                c.set_value(name, std::move(left));
+            throw;
+        }
+    }
+    catch(error::bad_binary_operation_error& e)
+    {
+        BOOST_THROW_EXCEPTION(e << error::line_info(get_line()) << error::pos_info(get_pos()));
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////
 /////////// vanilla::variable_expression_node
 ///////////////////////////////////////////////////////////////////////////
@@ -101,6 +158,8 @@ vanilla::variable_expression_node::variable_expression_node(
         
 vanilla::object::ptr vanilla::variable_expression_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("variable_expression_node", this);
+    
     try
     {
         return c.get_value(_name);
@@ -160,10 +219,18 @@ void vanilla::float_expression_node::accept(ast_visitor* v)
 vanilla::string_expression_node::string_expression_node(
             unsigned line,
             unsigned pos,
-            string_object::string_type v)
-    :   value_expression_node<string_object::string_type, string_object>(line, pos, std::move(v))
+            std::string v)
+    :   value_expression_node<std::string, string_object>(line, pos, std::move(v))
 { }
 
+vanilla::object::ptr vanilla::string_expression_node::eval(context&)
+{
+    instrumentation::policy::node_evaluated("string_expression_node", this);
+    if(!_interned)
+        _interned = string_object::intern(cstr_range(_v.data(), _v.data() + _v.size()));
+    return _interned;
+}
+
 void vanilla::string_expression_node::accept(ast_visitor* v)
 {
     v->visit(this);
@@ -199,11 +266,13 @@ vanilla::array_expression_node::array_expression_node(
 
 vanilla::object::ptr vanilla::array_expression_node::eval(context& c)
 {
-    array_object::array_type result;
-    result.reserve(_values.size());
-    for(auto& cur : _values)
-        result.push_back(cur->eval(c));
-    return allocate_object<array_object>(std::move(result));
+    instrumentation::policy::node_evaluated("array_expression_node", this);
+    
+    object::ptr result = allocate_object<array_object>(_values.size());
+    array_object* elements = static_cast<array_object*>(result.get());
+    for(std::size_t i = 0; i < _values.size(); ++i)
+        elements->set(i, _values[i]->eval(c));
+    return result;
 }       
 
 void vanilla::array_expression_node::accept(ast_visitor* v)
@@ -217,6 +286,51 @@ vanilla::array_expression_node::values()
     return _values;
 }
 
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::dict_expression_node
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::dict_expression_node::dict_expression_node(
+            unsigned line,
+            unsigned pos,
+            std::vector<expression_node::ptr> keys,
+            std::vector<expression_node::ptr> values)
+    :   expression_node(line, pos),
+        _keys(std::move(keys)),
+        _values(std::move(values))
+{ }
+
+vanilla::object::ptr vanilla::dict_expression_node::eval(context& c)
+{
+    instrumentation::policy::node_evaluated("dict_expression_node", this);
+    
+    object::ptr result = allocate_object<dict_object>();
+    dict_object* entries = static_cast<dict_object*>(result.get());
+    for(std::size_t i = 0; i < _keys.size(); ++i)
+    {
+        object::ptr key = _keys[i]->eval(c);
+        entries->insert(std::move(key), _values[i]->eval(c));
+    }
+    return result;
+}
+
+void vanilla::dict_expression_node::accept(ast_visitor* v)
+{
+    v->visit(this);
+}
+
+std::vector<vanilla::expression_node::ptr> const&
+vanilla::dict_expression_node::keys()
+{
+    return _keys;
+}
+
+std::vector<vanilla::expression_node::ptr> const&
+vanilla::dict_expression_node::values()
+{
+    return _values;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 /////////// vanilla::negation_expression_node
 ///////////////////////////////////////////////////////////////////////////
@@ -230,6 +344,8 @@ vanilla::negation_expression_node::negation_expression_node(
 
 vanilla::object::ptr vanilla::negation_expression_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("negation_expression_node", this);
+    
     try
     {
         return _child->eval(c)->neg();
@@ -258,6 +374,8 @@ vanilla::abs_expression_node::abs_expression_node(
 
 vanilla::object::ptr vanilla::abs_expression_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("abs_expression_node", this);
+    
     try
     {
         return _child->eval(c)->abs();
@@ -282,19 +400,16 @@ vanilla::addition_expression_node::addition_expression_node(
             unsigned pos,
             expression_node::ptr left,
             expression_node::ptr right)
-    :   binary_expression_node(line, pos, std::move(left), std::move(right))
+    :   update_expression_node(line, pos, std::move(left), std::move(right))
 { }
     
-vanilla::object::ptr vanilla::addition_expression_node::eval(context& c)
+vanilla::object::ptr vanilla::addition_expression_node::apply(
+            object::ptr const& left,
+            object::ptr const& right)
 {
-    try
-    {
-        return _left->eval(c)->add(_right->eval(c));
-    }
-    catch(error::bad_binary_operation_error& e)
-    {
-        BOOST_THROW_EXCEPTION(e << error::line_info(get_line()) << error::pos_info(get_pos()));
-    }
+    instrumentation::policy::node_evaluated("addition_expression_node", this);
+    instrumentation::policy::binary_operation("+", *left, *right);
+    return left->add(right);
 }
         
 void vanilla::addition_expression_node::accept(ast_visitor* v)
@@ -311,19 +426,16 @@ vanilla::subtraction_expression_node::subtraction_expression_node(
             unsigned pos,
             expression_node::ptr left,
             expression_node::ptr right)
-    :   binary_expression_node(line, pos, std::move(left), std::move(right))
+    :   update_expression_node(line, pos, std::move(left), std::move(right))
 { }
     
-vanilla::object::ptr vanilla::subtraction_expression_node::eval(context& c)
+vanilla::object::ptr vanilla::subtraction_expression_node::apply(
+            object::ptr const& left,
+            object::ptr const& right)
 {
-    try
-    {
-        return _left->eval(c)->sub(_right->eval(c));
-    }
-    catch(error::bad_binary_operation_error& e)
-    {
-        BOOST_THROW_EXCEPTION(e << error::line_info(get_line()) << error::pos_info(get_pos()));
-    }
+    instrumentation::policy::node_evaluated("subtraction_expression_node", this);
+    instrumentation::policy::binary_operation("-", *left, *right);
+    return left->sub(right);
 }
         
 void vanilla::subtraction_expression_node::accept(ast_visitor* v)
@@ -340,19 +452,16 @@ vanilla::multiplication_expression_node::multiplication_expression_node(
             unsigned pos,
             expression_node::ptr left,
             expression_node::ptr right)
-    :   binary_expression_node(line, pos, std::move(left), std::move(right))
+    :   update_expression_node(line, pos, std::move(left), std::move(right))
 { }
     
-vanilla::object::ptr vanilla::multiplication_expression_node::eval(context& c)
+vanilla::object::ptr vanilla::multiplication_expression_node::apply(
+            object::ptr const& left,
+            object::ptr const& right)
 {
-    try
-    {
-        return _left->eval(c)->mul(_right->eval(c));
-    }
-    catch(error::bad_binary_operation_error& e)
-    {
-        BOOST_THROW_EXCEPTION(e << error::line_info(get_line()) << error::pos_info(get_pos()));
-    }
+    instrumentation::policy::node_evaluated("multiplication_expression_node", this);
+    instrumentation::policy::binary_operation("*", *left, *right);
+    return left->mul(right);
 }
         
 void vanilla::multiplication_expression_node::accept(ast_visitor* v)
@@ -369,19 +478,16 @@ vanilla::division_expression_node::division_expression_node(
             unsigned pos,
             expression_node::ptr left,
             expression_node::ptr right)
-    :   binary_expression_node(line, pos, std::move(left), std::move(right))
+    :   update_expression_node(line, pos, std::move(left), std::move(right))
 { }
     
-vanilla::object::ptr vanilla::division_expression_node::eval(context& c)
+vanilla::object::ptr vanilla::division_expression_node::apply(
+            object::ptr const& left,
+            object::ptr const& right)
 {
-    try
-    {
-        return _left->eval(c)->div(_right->eval(c));
-    }
-    catch(error::bad_binary_operation_error& e)
-    {
-        BOOST_THROW_EXCEPTION(e << error::line_info(get_line()) << error::pos_info(get_pos()));
-    }
+    instrumentation::policy::node_evaluated("division_expression_node", this);
+    instrumentation::policy::binary_operation("/", *left, *right);
+    return left->div(right);
 }
         
 void vanilla::division_expression_node::accept(ast_visitor* v)
@@ -403,9 +509,14 @@ vanilla::lessthan_expression_node::lessthan_expression_node(
     
 vanilla::object::ptr vanilla::lessthan_expression_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("lessthan_expression_node", this);
+    
     try
     {
-        return _left->eval(c)->lt(_right->eval(c));
+        object::ptr left = _left->eval(c);
+        object::ptr right = _right->eval(c);
+        instrumentation::policy::binary_operation("<", *left, *right);
+        return left->lt(right);
     }
     catch(error::bad_binary_operation_error& e)
     {
@@ -432,9 +543,14 @@ vanilla::lessequal_expression_node::lessequal_expression_node(
     
 vanilla::object::ptr vanilla::lessequal_expression_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("lessequal_expression_node", this);
+    
     try
     {
-        return _left->eval(c)->le(_right->eval(c));
+        object::ptr left = _left->eval(c);
+        object::ptr right = _right->eval(c);
+        instrumentation::policy::binary_operation("<=", *left, *right);
+        return left->le(right);
     }
     catch(error::bad_binary_operation_error& e)
     {
@@ -461,9 +577,14 @@ vanilla::greaterthan_expression_node::greaterthan_expression_node(
     
 vanilla::object::ptr vanilla::greaterthan_expression_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("greaterthan_expression_node", this);
+    
     try
     {
-        return _left->eval(c)->gt(_right->eval(c));
+        object::ptr left = _left->eval(c);
+        object::ptr right = _right->eval(c);
+        instrumentation::policy::binary_operation(">", *left, *right);
+        return left->gt(right);
     }
     catch(error::bad_binary_operation_error& e)
     {
@@ -490,9 +611,14 @@ vanilla::greaterequal_expression_node::greaterequal_expression_node(
     
 vanilla::object::ptr vanilla::greaterequal_expression_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("greaterequal_expression_node", this);
+    
     try
     {
-        return _left->eval(c)->ge(_right->eval(c));
+        object::ptr left = _left->eval(c);
+        object::ptr right = _right->eval(c);
+        instrumentation::policy::binary_operation(">=", *left, *right);
+        return left->ge(right);
     }
     catch(error::bad_binary_operation_error& e)
     {
@@ -519,9 +645,14 @@ vanilla::equality_expression_node::equality_expression_node(
     
 vanilla::object::ptr vanilla::equality_expression_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("equality_expression_node", this);
+    
     try
     {
-        return _left->eval(c)->eq(_right->eval(c));
+        object::ptr left = _left->eval(c);
+        object::ptr right = _right->eval(c);
+        instrumentation::policy::binary_operation("==", *left, *right);
+        return left->eq(right);
     }
     catch(error::bad_binary_operation_error& e)
     {
@@ -548,9 +679,14 @@ vanilla::inequality_expression_node::inequality_expression_node(
     
 vanilla::object::ptr vanilla::inequality_expression_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("inequality_expression_node", this);
+    
     try
     {
-        return _left->eval(c)->neq(_right->eval(c));
+        object::ptr left = _left->eval(c);
+        object::ptr right = _right->eval(c);
+        instrumentation::policy::binary_operation("!=", *left, *right);
+        return left->neq(right);
     }
     catch(error::bad_binary_operation_error& e)
     {
@@ -572,19 +708,16 @@ vanilla::concatenation_expression_node::concatenation_expression_node(
             unsigned pos,
             expression_node::ptr left,
             expression_node::ptr right)
-    :   binary_expression_node(line, pos, std::move(left), std::move(right))
+    :   update_expression_node(line, pos, std::move(left), std::move(right))
 { }
     
-vanilla::object::ptr vanilla::concatenation_expression_node::eval(context& c)
+vanilla::object::ptr vanilla::concatenation_expression_node::apply(
+            object::ptr const& left,
+            object::ptr const& right)
 {
-    try
-    {
-        return _left->eval(c)->concat(_right->eval(c));
-    }
-    catch(error::bad_binary_operation_error& e)
-    {
-        BOOST_THROW_EXCEPTION(e << error::line_info(get_line()) << error::pos_info(get_pos()));
-    }
+    instrumentation::policy::node_evaluated("concatenation_expression_node", this);
+    instrumentation::policy::binary_operation("~", *left, *right);
+    return left->concat(right);
 }
         
 void vanilla::concatenation_expression_node::accept(ast_visitor* v)
@@ -608,6 +741,8 @@ vanilla::function_call_expression_node::function_call_expression_node(
 
 vanilla::object::ptr vanilla::function_call_expression_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("function_call_expression_node", this);
+    
     unsigned argc = _args.size();
     try
     {
@@ -633,6 +768,14 @@ vanilla::object::ptr vanilla::function_call_expression_node::eval(context& c)
     {
         BOOST_THROW_EXCEPTION(e << error::line_info(get_line()) << error::pos_info(get_pos()));
     }
+    catch(error::bad_cast_error& e)
+    {
+        // Element functions throw without a location, the innermost call
+        // is the one that got the argument.
+        if(!error::get_line_info(e))
+            e << error::line_info(get_line()) << error::pos_info(get_pos());
+        throw;
+    }
 }
 
 vanilla::expression_node* vanilla::function_call_expression_node::get_function()
@@ -669,6 +812,8 @@ vanilla::function_definition_expression_node::function_definition_expression_nod
 
 vanilla::object::ptr vanilla::function_definition_expression_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("function_definition_expression_node", this);
+    
     auto callable = [=](context& c_, object::ptr*, unsigned) -> object::ptr
     {
         try
@@ -737,6 +882,8 @@ vanilla::native_function_definition_expression_node::native_function_definition_
         
 vanilla::object::ptr vanilla::native_function_definition_expression_node::eval(context&)
 {
+    instrumentation::policy::node_evaluated("native_function_definition_expression_node", this);
+    
     try
     {
         return allocate_object<native_function_object>(
@@ -811,6 +958,8 @@ vanilla::conditional_expression_node::conditional_expression_node(
 
 vanilla::object::ptr vanilla::conditional_expression_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("conditional_expression_node", this);
+    
     try
     {
         return bool_object_to_cpp_bool(_condition->eval(c)->to_bool()) ?
@@ -858,7 +1007,25 @@ vanilla::subscript_expression_node::subscript_expression_node(
         
 vanilla::object::ptr vanilla::subscript_expression_node::eval(context& c)
 {
-    return _expr->eval(c)->sget(_subscript->eval(c));
+    instrumentation::policy::node_evaluated("subscript_expression_node", this);
+    
+    object::ptr target = _expr->eval(c);
+    object::ptr subscript = _subscript->eval(c);
+    try
+    {
+        return target->sget(subscript);
+    }
+    catch(error::invalid_index_error& e)
+    {
+        // Rethrown as is, e may be a key_not_found_error.
+        e << error::line_info(get_line()) << error::pos_info(get_pos());
+        throw;
+    }
+    catch(error::bad_cast_error& e)
+    {
+        e << error::line_info(get_line()) << error::pos_info(get_pos());
+        throw;
+    }
 }
         
 vanilla::expression_node* vanilla::subscript_expression_node::get_expression()
@@ -892,6 +1059,8 @@ vanilla::element_selection_expression_node::element_selection_expression_node(
         
 vanilla::object::ptr vanilla::element_selection_expression_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("element_selection_expression_node", this);
+    
     return _left->eval(c)->eget(_element_name);
 }
         
@@ -907,5 +1076,5 @@ std::string const& vanilla::element_selection_expression_node::get_element_name(
         
 void vanilla::element_selection_expression_node::accept(ast_visitor* v)
 {
-    //v->visit(this);
+    v->visit(this);
 }
\ No newline at end of file
@@ -26,6 +26,8 @@
 
 // Vanilla:
 #include <vanilla/float_object.hpp>
+#include <vanilla/int_object.hpp>
+#include <vanilla/bool_object.hpp>
 #include <vanilla/string_object.hpp>
 
 ///////////////////////////////////////////////////////////////////////////
@@ -126,27 +128,60 @@ vanilla::object::ptr vanilla::float_object::copy(bool) const
 }
 
 vanilla::object::ptr vanilla::float_object::to_string() const
+{
+    std::string result;
+    result.resize(max_chars());
+    result.resize(to_chars(&result[0]) - result.data());
+    return allocate_object<string_object>(std::move(result));
+}
+
+std::size_t vanilla::float_object::max_chars() const
+{
+    // The digits mpf_get_str generates for the precision, plus the zeros
+    // between them and the point. mpf_get_str adds a sign and a
+    // terminating zero, the rest is for "0.".
+    long exponent;
+    mpf_get_d_2exp(&exponent, _v.mpf());
+    std::size_t digits = std::size_t((mpf_get_prec(_v.mpf()) + 2 * GMP_NUMB_BITS) * 0.30103) + 3;
+    std::size_t zeros = std::size_t(std::labs(exponent) * 0.30103) + 2;
+    return digits + zeros + 4;
+}
+
+char* vanilla::float_object::to_chars(char* out) const
 {
     mp_exp_t exp;
-    char* str = mpf_get_str(nullptr, &exp, 10, 0, _v.mpf());
-    std::unique_ptr<char, void (*)(char*)> tmp(str, [](char* ptr) { std::free(ptr); } );
+    mpf_get_str(out, &exp, 10, 0, _v.mpf());
+    char* digits = out + (*out == '-');
+    std::size_t n = std::strlen(digits);
     
+    // Point after the integral digits, padded with zeros if needed.
     if(exp > 0)
     {
-        std::string result(str, str + exp);
-        result += '.';
-        for(char* s = str + exp; *s; ++s)
-            result += *s;
-        return allocate_object<string_object>(std::move(result));
-    }
-    else
-    {
-       std::string result("0.");
-       for(mp_exp_t i = 0; i < exp; ++i)
-           result += '0';
-       result.append(str);
-       return allocate_object<string_object>(std::move(result));
+        std::size_t integral = exp;
+        if(n <= integral)
+        {
+            std::memset(digits + n, '0', integral - n);
+            digits[integral] = '.';
+            return digits + integral + 1;
+        }
+        
+        std::memmove(digits + integral + 1, digits + integral, n - integral);
+        digits[integral] = '.';
+        return digits + n + 1;
     }
+    
+    // "0." and the zeros before the first digit.
+    std::size_t zeros = -exp;
+    std::memmove(digits + 2 + zeros, digits, n);
+    digits[0] = '0';
+    digits[1] = '.';
+    std::memset(digits + 2, '0', zeros);
+    return digits + 2 + zeros + n;
+}
+
+vanilla::object::ptr vanilla::float_object::to_float() const
+{
+    return const_cast<float_object*>(this)->shared_from_this();
 }
 
 vanilla::float_object::float_type const& vanilla::float_object::value() const
@@ -154,6 +189,48 @@ vanilla::float_object::float_type const& vanilla::float_object::value() const
     return _v;
 }
 
+vanilla::object::ptr vanilla::float_object::eq(object::ptr const& other)
+{
+    if(other->type_id() != OBJECT_ID_FLOAT && other->type_id() != OBJECT_ID_INT)
+        return object::eq(other);
+    return allocate_object<bool_object>(equals(*other));
+}
+
+vanilla::object::ptr vanilla::float_object::neq(object::ptr const& other)
+{
+    if(other->type_id() != OBJECT_ID_FLOAT && other->type_id() != OBJECT_ID_INT)
+        return object::neq(other);
+    return allocate_object<bool_object>(!equals(*other));
+}
+
+std::size_t vanilla::float_object::hash() const
+{
+    // Integral values hash like the int they're equal to.
+    if(mpf_integer_p(_v.mpf()))
+        return int_object::hash_value(int_object::int_type(_v.mpf()));
+    
+    long exponent;
+    double mantissa = mpf_get_d_2exp(&exponent, _v.mpf());
+    std::uint64_t bits;
+    std::memcpy(&bits, &mantissa, sizeof(bits));
+    return mix_hash(bits ^ mix_hash(exponent));
+}
+
+bool vanilla::float_object::equals(object const& other) const
+{
+    switch(other.type_id())
+    {
+        case OBJECT_ID_FLOAT:
+            return mpf_cmp(_v.mpf(), static_cast<float_object const&>(other).value().mpf()) == 0;
+        
+        case OBJECT_ID_INT:
+            return other.equals(*this);
+        
+        default:
+            return false;
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////
 /////////// FREE FUNCTIONS
 ///////////////////////////////////////////////////////////////////////////
@@ -23,6 +23,8 @@
 #include <vanilla/function_object.hpp>
 #include <vanilla/string_object.hpp>
 #include <vanilla/context.hpp>
+#include <vanilla/profiler.hpp>
+#include <vanilla/tracing.hpp>
 
 ///////////////////////////////////////////////////////////////////////////
 /////////// vanilla::function_argument
@@ -54,13 +56,17 @@ vanilla::function_object::function_object(
             std::vector<function_argument> arguments,
             callable_type f,
             bool set_context,
-            bool variadic)
+            bool variadic,
+            object::ptr bound)
     :   _name(std::move(name)),
         _arguments(std::move(arguments)),
         _f(std::move(f)),
         _set_context(set_context),
         _variadic(variadic),
-        _min_args(0)
+        _min_args(0),
+        _bound(std::move(bound)),
+        _trace_name(nullptr),
+        _profile_name(nullptr)
 {
     // Validate default arguments.
     for(unsigned i = 0; i < _arguments.size() && !_arguments[i].get_default_value(); ++i)
@@ -99,6 +105,29 @@ vanilla::object::ptr vanilla::function_object::to_string() const
     return allocate_object<string_object>(std::move(result));
 }
         
+char const* vanilla::function_object::trace_name() const
+{
+    // Racing calls intern the same name and store the same pointer.
+    char const* name = _trace_name.load(std::memory_order_relaxed);
+    if(!name)
+    {
+        name = tracing::detail::intern(_name);
+        _trace_name.store(name, std::memory_order_relaxed);
+    }
+    return name;
+}
+
+char const* vanilla::function_object::profile_name() const
+{
+    char const* name = _profile_name.load(std::memory_order_relaxed);
+    if(!name)
+    {
+        name = profiler::detail::intern(_name);
+        _profile_name.store(name, std::memory_order_relaxed);
+    }
+    return name;
+}
+
 vanilla::object::ptr vanilla::function_object::call(context& c, ptr* argv, unsigned argc)
 {
     if(argc < _min_args)
@@ -109,7 +138,7 @@ vanilla::object::ptr vanilla::function_object::call(context& c, ptr* argv, unsig
             << error::num_arguments_received(argc));
     }
     
-    if(argc > _arguments.size())
+    if(argc > _arguments.size() && !_variadic)
     {
         BOOST_THROW_EXCEPTION(error::too_many_arguments_error()
             << error::function_name(_name)
@@ -117,6 +146,9 @@ vanilla::object::ptr vanilla::function_object::call(context& c, ptr* argv, unsig
             << error::num_arguments_received(argc));
     }
     
+    profiler::scoped_frame frame(profiler::detail::published.active ? profile_name() : nullptr);
+    tracing::scoped_event event(tracing::detail::active ? trace_name() : nullptr, "function");
+    
     struct stackframe_helper
     {
         context& c;
@@ -140,12 +172,15 @@ vanilla::object::ptr vanilla::function_object::call(context& c, ptr* argv, unsig
         for(unsigned i = argc; i < _arguments.size(); ++i)
             c.set_local_value(_arguments[i].get_name(), _arguments[i].get_default_value());
         
+        // Extra arguments of variadic functions are passed on.
+        if(argc > _arguments.size())
+            return _f(c, argv + _arguments.size(), argc - _arguments.size());
         return _f(c, nullptr, 0);
     }
     else
     {
         // All arguments given - just call.
-        if(argc == _arguments.size())
+        if(argc >= _arguments.size())
         {
             return _f(c, argv, argc);
         }
@@ -172,4 +207,33 @@ vanilla::object::ptr vanilla::function_object::call(context& c, ptr* argv, unsig
             return _f(c, complete_argv.data(), _arguments.size());
         }
     }
-}
\ No newline at end of file
+}
+
+bool vanilla::function_object::is_container() const
+{
+    return true;
+}
+
+void vanilla::function_object::traverse(object_visitor& v) const
+{
+    for(function_argument const& a : _arguments)
+    {
+        if(a.get_default_value())
+            v.visit(a.get_default_value());
+    }
+    if(_bound)
+        v.visit(_bound);
+}
+
+void vanilla::function_object::release_references()
+{
+    for(function_argument& a : _arguments)
+        a = function_argument(a.get_name());
+    _bound.reset();
+}
+
+std::size_t vanilla::function_object::memory_size() const
+{
+    return sizeof(function_object) + _name.capacity()
+        + _arguments.capacity() * sizeof(function_argument);
+}
@@ -0,0 +1,410 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <cstdio>
+
+// Vanilla:
+#include <vanilla/gen/json.hpp>
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::json_generator
+///////////////////////////////////////////////////////////////////////////
+
+void vanilla::gen::json_generator::begin_node(char const* name, ast_node* n)
+{
+    _o.put("{\"node\":\"");
+    _o.put(name);
+    _o.put("\",\"line\":");
+    _o.put_unsigned(n->get_line());
+    _o.put(",\"pos\":");
+    _o.put_unsigned(n->get_pos());
+}
+
+void vanilla::gen::json_generator::end_node()
+{
+    _o.put('}');
+}
+
+void vanilla::gen::json_generator::key(char const* name)
+{
+    _o.put(",\"");
+    _o.put(name);
+    _o.put("\":");
+}
+
+void vanilla::gen::json_generator::print_string(std::string const& s)
+{
+    _o.put('"');
+    for(char c : s)
+    {
+        switch(c)
+        {
+            case '"': _o.put("\\\"", 2); break;
+            case '\\': _o.put("\\\\", 2); break;
+            case '\n': _o.put("\\n", 2); break;
+            case '\r': _o.put("\\r", 2); break;
+            case '\t': _o.put("\\t", 2); break;
+            default:
+                if(static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    _o.put(escaped, 6);
+                }
+                else
+                {
+                    _o.put(c);
+                }
+        }
+    }
+    _o.put('"');
+}
+
+void vanilla::gen::json_generator::print_child(char const* name, ast_node* n)
+{
+    key(name);
+    if(n)
+        n->accept(this);
+    else
+        _o.put("null", 4);
+}
+
+void vanilla::gen::json_generator::print_list(
+    char const* name, std::vector<expression_node::ptr> const& nodes)
+{
+    key(name);
+    _o.put('[');
+    for(std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        if(i != 0)
+            _o.put(',');
+        nodes[i]->accept(this);
+    }
+    _o.put(']');
+}
+
+void vanilla::gen::json_generator::print_arguments(
+    std::vector<std::pair<std::string, expression_node::ptr>> const& arguments)
+{
+    key("arguments");
+    _o.put('[');
+    for(std::size_t i = 0; i < arguments.size(); ++i)
+    {
+        if(i != 0)
+            _o.put(',');
+        _o.put("{\"name\":");
+        print_string(arguments[i].first);
+        print_child("default", arguments[i].second.get());
+        _o.put('}');
+    }
+    _o.put(']');
+}
+
+void vanilla::gen::json_generator::print_binary(char const* name, binary_expression_node* n)
+{
+    begin_node(name, n);
+    print_child("left", n->get_left());
+    print_child("right", n->get_right());
+    end_node();
+}
+
+vanilla::gen::json_generator::json_generator(std::ostream& o)
+    : _o(o)
+{ }
+    
+// Nullary expressions.
+void vanilla::gen::json_generator::visit(variable_expression_node* n)
+{
+    begin_node("variable_expression_node", n);
+    key("name");
+    print_string(n->get_name());
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(int_expression_node* n)
+{
+    // Values are kept as strings since they may exceed double precision.
+    begin_node("int_expression_node", n);
+    key("value");
+    _o.put('"');
+    _o.put_mpz(n->get_value().mpz());
+    _o.put('"');
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(float_expression_node* n)
+{
+    begin_node("float_expression_node", n);
+    key("value");
+    _o.put('"');
+    _o.put_mpf(n->get_value().mpf());
+    _o.put('"');
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(string_expression_node* n)
+{
+    begin_node("string_expression_node", n);
+    key("value");
+    print_string(n->get_value());
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(bool_expression_node* n)
+{
+    begin_node("bool_expression_node", n);
+    key("value");
+    bool_object::bool_type v = n->get_value();
+    _o.put(v ? "true" : !v ? "false" : "null");
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(array_expression_node* n)
+{
+    begin_node("array_expression_node", n);
+    print_list("values", n->values());
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(dict_expression_node* n)
+{
+    begin_node("dict_expression_node", n);
+    print_list("keys", n->keys());
+    print_list("values", n->values());
+    end_node();
+}
+    
+// Unary expressions.
+void vanilla::gen::json_generator::visit(negation_expression_node* n)
+{
+    begin_node("negation_expression_node", n);
+    print_child("child", n->get_child());
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(abs_expression_node* n)
+{
+    begin_node("abs_expression_node", n);
+    print_child("child", n->get_child());
+    end_node();
+}
+    
+// Binary expressions.
+void vanilla::gen::json_generator::visit(addition_expression_node* n)
+{
+    print_binary("addition_expression_node", n);
+}
+    
+void vanilla::gen::json_generator::visit(subtraction_expression_node* n)
+{
+    print_binary("subtraction_expression_node", n);
+}
+
+void vanilla::gen::json_generator::visit(multiplication_expression_node* n)
+{
+    print_binary("multiplication_expression_node", n);
+}
+    
+void vanilla::gen::json_generator::visit(division_expression_node* n)
+{
+    print_binary("division_expression_node", n);
+}
+
+void vanilla::gen::json_generator::visit(concatenation_expression_node* n)
+{
+    print_binary("concatenation_expression_node", n);
+}
+
+void vanilla::gen::json_generator::visit(lessthan_expression_node* n)
+{
+    print_binary("lessthan_expression_node", n);
+}
+
+void vanilla::gen::json_generator::visit(lessequal_expression_node* n)
+{
+    print_binary("lessequal_expression_node", n);
+}
+
+void vanilla::gen::json_generator::visit(greaterthan_expression_node* n)
+{
+    print_binary("greaterthan_expression_node", n);
+}
+    
+void vanilla::gen::json_generator::visit(greaterequal_expression_node* n)
+{
+    print_binary("greaterequal_expression_node", n);
+}
+
+void vanilla::gen::json_generator::visit(equality_expression_node* n)
+{
+    print_binary("equality_expression_node", n);
+}
+
+void vanilla::gen::json_generator::visit(inequality_expression_node* n)
+{
+    print_binary("inequality_expression_node", n);
+}
+
+void vanilla::gen::json_generator::visit(function_call_expression_node* n)
+{
+    begin_node("function_call_expression_node", n);
+    print_child("target", n->get_function());
+    print_list("arguments", n->get_args());
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(function_definition_expression_node* n)
+{
+    begin_node("function_definition_expression_node", n);
+    key("name");
+    print_string(n->get_name());
+    print_arguments(n->get_arguments());
+    print_child("body", n->get_body());
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(native_function_definition_expression_node* n)
+{
+    begin_node("native_function_definition_expression_node", n);
+    key("name");
+    print_string(n->get_name());
+    key("library");
+    print_string(n->get_library());
+    key("returns");
+    print_string(n->get_return_type());
+    
+    key("arguments");
+    _o.put('[');
+    auto const& types = n->get_argument_types();
+    for(std::size_t i = 0; i < types.size(); ++i)
+    {
+        if(i != 0)
+            _o.put(',');
+        print_string(types[i]);
+    }
+    _o.put(']');
+    
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(conditional_expression_node* n)
+{
+    begin_node("conditional_expression_node", n);
+    print_child("condition", n->get_condition());
+    print_child("expression", n->get_expression());
+    print_child("else", n->get_else());
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(subscript_expression_node* n)
+{
+    begin_node("subscript_expression_node", n);
+    print_child("expression", n->get_expression());
+    print_child("subscript", n->get_subscript());
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(element_selection_expression_node* n)
+{
+    begin_node("element_selection_expression_node", n);
+    print_child("left", n->get_left());
+    key("element");
+    print_string(n->get_element_name());
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(return_statement_node* n)
+{
+    begin_node("return_statement_node", n);
+    print_child("expression", n->get_expression());
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(statement_sequence_node* n)
+{
+    begin_node("statement_sequence_node", n);
+    key("code");
+    _o.put('[');
+    auto const& code = n->get_code();
+    for(std::size_t i = 0; i < code.size(); ++i)
+    {
+        if(i != 0)
+            _o.put(',');
+        code[i]->accept(this);
+    }
+    _o.put(']');
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(assignment_statement_node* n)
+{
+    begin_node("assignment_statement_node", n);
+    print_child("left", n->get_left());
+    print_child("right", n->get_right());
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(if_statement_node* n)
+{
+    begin_node("if_statement_node", n);
+    
+    key("ifs");
+    _o.put('[');
+    auto const& ifs = n->get_ifs();
+    for(std::size_t i = 0; i < ifs.size(); ++i)
+    {
+        if(i != 0)
+            _o.put(',');
+        _o.put("{\"condition\":");
+        ifs[i].first->accept(this);
+        print_child("sequence", ifs[i].second.get());
+        _o.put('}');
+    }
+    _o.put(']');
+    
+    print_child("else", n->get_else());
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(while_statement_node* n)
+{
+    begin_node("while_statement_node", n);
+    print_child("condition", n->get_condition());
+    print_child("code", n->get_code());
+    end_node();
+}
+
+void vanilla::gen::json_generator::visit(function_definition_statement_node* n)
+{
+    begin_node("function_definition_statement_node", n);
+    key("name");
+    print_string(n->get_name());
+    print_arguments(n->get_arguments());
+    print_child("body", n->get_body());
+    end_node();
+}
+
+void vanilla::gen::emit_json(ast_node* ast, std::ostream& o)
+{
+    json_generator gen((o));
+    ast->accept(&gen);
+}
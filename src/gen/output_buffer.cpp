@@ -0,0 +1,182 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <cstring>
+#include <algorithm>
+
+// Vanilla:
+#include <vanilla/gen/output_buffer.hpp>
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::gen::output_buffer
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::gen::output_buffer::output_buffer(std::ostream& o, std::size_t capacity)
+    :   _o(o),
+        _buffer(new char[capacity]),
+        _capacity(capacity),
+        _size(0)
+{ }
+
+vanilla::gen::output_buffer::~output_buffer()
+{
+    flush();
+}
+
+void vanilla::gen::output_buffer::flush()
+{
+    if(_size != 0)
+    {
+        _o.write(_buffer.get(), _size);
+        _size = 0;
+    }
+}
+
+char* vanilla::gen::output_buffer::reserve(std::size_t n)
+{
+    if(_capacity - _size < n)
+    {
+        flush();
+        if(_capacity < n)
+        {
+            _buffer.reset(new char[n]);
+            _capacity = n;
+        }
+    }
+    
+    return _buffer.get() + _size;
+}
+
+void vanilla::gen::output_buffer::commit(std::size_t n)
+{
+    _size += n;
+}
+
+void vanilla::gen::output_buffer::put(char const* s, std::size_t n)
+{
+    if(_capacity - _size < n)
+    {
+        flush();
+        
+        // Don't copy huge fragments around.
+        if(_capacity < n)
+        {
+            _o.write(s, n);
+            return;
+        }
+    }
+    
+    std::memcpy(_buffer.get() + _size, s, n);
+    _size += n;
+}
+
+void vanilla::gen::output_buffer::put(char const* s)
+{
+    put(s, std::strlen(s));
+}
+
+void vanilla::gen::output_buffer::put(std::string const& s)
+{
+    put(s.data(), s.size());
+}
+
+void vanilla::gen::output_buffer::put_repeated(char c, std::size_t n)
+{
+    while(n != 0)
+    {
+        std::size_t chunk = std::min(n, _capacity);
+        std::memset(reserve(chunk), c, chunk);
+        commit(chunk);
+        n -= chunk;
+    }
+}
+
+void vanilla::gen::output_buffer::put_unsigned(unsigned long v)
+{
+    char digits[3 * sizeof(v)];
+    char* p = digits + sizeof(digits);
+    do
+    {
+        *--p = '0' + v % 10;
+        v /= 10;
+    } while(v != 0);
+    
+    put(p, digits + sizeof(digits) - p);
+}
+
+void vanilla::gen::output_buffer::put_mpz(mpz_t const v)
+{
+    // mpz_get_str needs room for the sign and the terminating null.
+    char* p = reserve(mpz_sizeinbase(v, 10) + 2);
+    mpz_get_str(p, 10, v);
+    commit(std::strlen(p));
+}
+
+void vanilla::gen::output_buffer::put_mpf(mpf_t const v)
+{
+    mp_exp_t exp;
+    char* str = mpf_get_str(nullptr, &exp, 10, 0, v);
+    std::size_t length = std::strlen(str);
+    
+    char const* digits = str;
+    if(*digits == '-')
+    {
+        put('-');
+        ++digits;
+        --length;
+    }
+    
+    if(exp > 0)
+    {
+        // The digit string may be shorter than the integral part.
+        std::size_t integral = exp;
+        if(integral < length)
+        {
+            put(digits, integral);
+            put('.');
+            put(digits + integral, length - integral);
+        }
+        else
+        {
+            // Integral values keep a fractional digit, so they read back
+            // as floats.
+            put(digits, length);
+            put_repeated('0', integral - length);
+            put(".0", 2);
+        }
+    }
+    else if(length == 0)
+    {
+        // Zero has no digits.
+        put("0.0", 3);
+    }
+    else
+    {
+        put("0.", 2);
+        put_repeated('0', -exp);
+        put(digits, length);
+    }
+    
+    void (*free_func)(void*, std::size_t);
+    mp_get_memory_functions(nullptr, nullptr, &free_func);
+    free_func(str, std::strlen(str) + 1);
+}
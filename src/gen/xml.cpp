@@ -28,9 +28,7 @@
 
 void vanilla::gen::xml_generator::indent()
 {
-    for(unsigned i = 0; i < _indent_level; ++i)
-        for(unsigned j = 0; j < _indent_spaces; ++j)
-            _o << ' ';
+    _o.put_repeated(' ', _indent_level * _indent_spaces);
 }
     
 void vanilla::gen::xml_generator::increase_indent()
@@ -46,7 +44,34 @@ void vanilla::gen::xml_generator::decrease_indent()
 void vanilla::gen::xml_generator::print_line(char const* s)
 {
     indent();
-    _o << s << '\n';
+    _o.put(s);
+    _o.put('\n');
+}
+
+void vanilla::gen::xml_generator::print_escaped(std::string const& s)
+{
+    for(char c : s)
+    {
+        switch(c)
+        {
+            case '<': _o.put("&lt;", 4); break;
+            case '>': _o.put("&gt;", 4); break;
+            case '&': _o.put("&amp;", 5); break;
+            default: _o.put(c); break;
+        }
+    }
+}
+
+void vanilla::gen::xml_generator::print_element(char const* tag, std::string const& text)
+{
+    indent();
+    _o.put('<');
+    _o.put(tag);
+    _o.put('>');
+    print_escaped(text);
+    _o.put("</", 2);
+    _o.put(tag);
+    _o.put(">\n", 2);
 }
     
 vanilla::gen::xml_generator::xml_generator(std::ostream& o, unsigned indent_spaces)
@@ -56,38 +81,36 @@ vanilla::gen::xml_generator::xml_generator(std::ostream& o, unsigned indent_spac
 // Nullary expressions.
 void vanilla::gen::xml_generator::visit(variable_expression_node* n)
 {
-    indent();
-    _o << "<variable_expression_node>" << n->get_name() << "</variable_expression_node>\n";
+    print_element("variable_expression_node", n->get_name());
 }
 
 void vanilla::gen::xml_generator::visit(int_expression_node* n)
 {
     indent();
-    _o << "<int_expression_node>";
-    context dummy;
-    _o << string_object_to_cpp_string(n->eval(dummy)->to_string());
-    _o << "</int_expression_node>\n";
+    _o.put("<int_expression_node>");
+    _o.put_mpz(n->get_value().mpz());
+    _o.put("</int_expression_node>\n");
 }
 
 void vanilla::gen::xml_generator::visit(float_expression_node* n)
 {
     indent();
-    _o << "<float_expression_node>";
-    context dummy;
-    _o << string_object_to_cpp_string(n->eval(dummy)->to_string());
-    _o << "</float_expression_node>\n";
+    _o.put("<float_expression_node>");
+    _o.put_mpf(n->get_value().mpf());
+    _o.put("</float_expression_node>\n");
 }
 
 void vanilla::gen::xml_generator::visit(string_expression_node* n)
 {
-    indent();
-    _o << "<string_expression_node>" << n->get_value() << "</string_expression_node>\n";
+    print_element("string_expression_node", n->get_value());
 }
 
 void vanilla::gen::xml_generator::visit(bool_expression_node* n)
 {
-    indent();
-    _o << "<bool_expression_node>" << n->get_value() << "</bool_expression_node>\n";
+    bool_object::bool_type v = n->get_value();
+    print_line(v ? "<bool_expression_node>1</bool_expression_node>"
+        : !v ? "<bool_expression_node>0</bool_expression_node>"
+        : "<bool_expression_node>indeterminate</bool_expression_node>");
 }
 
 void vanilla::gen::xml_generator::visit(array_expression_node* n)
@@ -99,6 +122,23 @@ void vanilla::gen::xml_generator::visit(array_expression_node* n)
     decrease_indent();
     print_line("</array_expression_node>");
 }
+
+void vanilla::gen::xml_generator::visit(dict_expression_node* n)
+{
+    print_line("<dict_expression_node>");
+    increase_indent();
+    for(std::size_t i = 0; i < n->keys().size(); ++i)
+    {
+        print_line("<entry>");
+        increase_indent();
+        n->keys()[i]->accept(this);
+        n->values()[i]->accept(this);
+        decrease_indent();
+        print_line("</entry>");
+    }
+    decrease_indent();
+    print_line("</dict_expression_node>");
+}
     
 // Unary expressions.
 void vanilla::gen::xml_generator::visit(negation_expression_node* n)
@@ -257,15 +297,13 @@ void vanilla::gen::xml_generator::visit(function_definition_expression_node* n)
     print_line("<function_definition_expression_node>");
     increase_indent();
     
-    indent();
-    _o << "<name>" << n->get_name() << "</name>\n";
+    print_element("name", n->get_name());
     
     print_line("<arguments>");
     increase_indent();
     for(auto const& cur : n->get_arguments())
     {
-        indent();
-        _o << "<name>" << n->get_name() << "</name>\n";
+        print_element("name", cur.first);
         
         if(cur.second)
         {
@@ -294,21 +332,15 @@ void vanilla::gen::xml_generator::visit(native_function_definition_expression_no
     print_line("<native_function_definition_expression_node>");
     increase_indent();
     
-    indent();
-    _o << "<name>" << n->get_name() << "</name>\n";
-    
-    indent();
-    _o << "<library>" << n->get_library() << "</library>\n";
-    
-    indent();
-    _o << "<returns>" << n->get_return_type() << "</returns>\n";
+    print_element("name", n->get_name());
+    print_element("library", n->get_library());
+    print_element("returns", n->get_return_type());
     
     print_line("<arguments>");
     increase_indent();
     for(std::string const& cur : n->get_argument_types())
     {
-        indent();
-        _o << "<type>" << cur << "</type>\n";
+        print_element("type", cur);
     }
     decrease_indent();
     print_line("</arguments>");
@@ -342,13 +374,12 @@ void vanilla::gen::xml_generator::visit(subscript_expression_node* n)
 
 void vanilla::gen::xml_generator::visit(element_selection_expression_node* n)
 {
-    print_line("<equality_expression_node>");
+    print_line("<element_selection_expression_node>");
     increase_indent();
     n->get_left()->accept(this);
-    indent();
-    _o << n->get_element_name() << '\n';
+    print_element("element", n->get_element_name());
     decrease_indent();
-    print_line("</equality_expression_node>");
+    print_line("</element_selection_expression_node>");
 }
 
 void vanilla::gen::xml_generator::visit(return_statement_node* n)
@@ -453,15 +484,13 @@ void vanilla::gen::xml_generator::visit(function_definition_statement_node* n)
     print_line("<function_definition_statement_node>");
     increase_indent();
     
-    indent();
-    _o << "<name>" << n->get_name() << "</name>\n";
+    print_element("name", n->get_name());
     
     print_line("<arguments>");
     increase_indent();
     for(auto const& cur : n->get_arguments())
     {
-        indent();
-        _o << "<name>" << n->get_name() << "</name>\n";
+        print_element("name", cur.first);
         
         if(cur.second)
         {
@@ -0,0 +1,150 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+// Vanilla:
+#include <vanilla/instrumentation.hpp>
+#include <vanilla/ast_base.hpp>
+#include <vanilla/string_object.hpp>
+
+namespace
+{
+    std::unordered_map<char const*, std::uint64_t> node_counts;
+    std::vector<std::uint64_t> line_counts;
+    
+    struct operand_types
+    {
+        std::uint64_t count;
+        std::string left;
+        std::string right;
+    };
+    
+    typedef std::tuple<char const*, vanilla::object_type_id, vanilla::object_type_id> operation_key;
+    std::map<operation_key, operand_types> operation_counts;
+    
+    void write_string(std::ostream& o, std::string const& s)
+    {
+        o << '"';
+        for(char c : s)
+        {
+            if(c == '"' || c == '\\')
+                o << '\\';
+            o << c;
+        }
+        o << '"';
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::instrumentation::counting_policy
+///////////////////////////////////////////////////////////////////////////
+
+void vanilla::instrumentation::counting_policy::node_evaluated(
+    char const* node_class, ast_node const* n)
+{
+    ++node_counts[node_class];
+    
+    unsigned line = n->get_line();
+    if(line >= line_counts.size())
+        line_counts.resize(line + 1);
+    ++line_counts[line];
+}
+
+void vanilla::instrumentation::counting_policy::binary_operation(
+    char const* op, object const& left, object const& right)
+{
+    operand_types& types = operation_counts[operation_key(op, left.type_id(), right.type_id())];
+    if(types.count++ == 0)
+    {
+        // Names are only looked up once per combination.
+        types.left = string_object_to_cpp_string(left.type_name());
+        types.right = string_object_to_cpp_string(right.type_name());
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// FREE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////
+
+bool vanilla::instrumentation::enabled()
+{
+#ifdef VANILLA_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+void vanilla::instrumentation::write_json(std::ostream& o)
+{
+    std::map<std::string, std::uint64_t> nodes;
+    for(auto const& cur : node_counts)
+        nodes[cur.first] += cur.second; // Equal literals may have several addresses.
+    
+    o << "{\n  \"nodes\": {";
+    char const* separator = "\n";
+    for(auto const& cur : nodes)
+    {
+        o << separator << "    ";
+        write_string(o, cur.first);
+        o << ": " << cur.second;
+        separator = ",\n";
+    }
+    
+    o << "\n  },\n  \"lines\": {";
+    separator = "\n";
+    for(std::size_t line = 0; line < line_counts.size(); ++line)
+    {
+        if(line_counts[line] == 0)
+            continue;
+        o << separator << "    \"" << line << "\": " << line_counts[line];
+        separator = ",\n";
+    }
+    
+    std::map<std::tuple<std::string, std::string, std::string>, std::uint64_t> operations;
+    for(auto const& cur : operation_counts)
+    {
+        operations[std::make_tuple(std::string(std::get<0>(cur.first)),
+            cur.second.left, cur.second.right)] += cur.second.count;
+    }
+    
+    o << "\n  },\n  \"binary_operations\": [";
+    separator = "\n";
+    for(auto const& cur : operations)
+    {
+        o << separator << "    { \"operator\": ";
+        write_string(o, std::get<0>(cur.first));
+        o << ", \"left\": ";
+        write_string(o, std::get<1>(cur.first));
+        o << ", \"right\": ";
+        write_string(o, std::get<2>(cur.first));
+        o << ", \"count\": " << cur.second << " }";
+        separator = ",\n";
+    }
+    o << "\n  ]\n}\n";
+}
@@ -22,6 +22,7 @@
 // C++ Standard Library:
 #include <cstring>
 #include <climits>
+#include <limits>
 #include <unordered_map>
 
 // Vanilla:
@@ -174,12 +175,23 @@ vanilla::object::ptr vanilla::int_object::copy(bool) const
 vanilla::object::ptr vanilla::int_object::to_string() const
 {
     std::string result;
-    result.resize(mpz_sizeinbase(_v.mpz(), 10) + 2);
-    mpz_get_str(&result[0], 10, _v.mpz());
-    result.pop_back(); // Remove null terminator.
+    result.resize(max_chars());
+    result.resize(to_chars(&result[0]) - result.data());
     return allocate_object<string_object>(std::move(result));
 }
 
+std::size_t vanilla::int_object::max_chars(int base) const
+{
+    // Sign and the zero mpz_get_str terminates with.
+    return mpz_sizeinbase(_v.mpz(), base) + 2;
+}
+
+char* vanilla::int_object::to_chars(char* out, int base) const
+{
+    mpz_get_str(out, base, _v.mpz());
+    return out + std::strlen(out); // mpz_sizeinbase may overestimate.
+}
+
 vanilla::object::ptr vanilla::int_object::to_int() const
 {
     return const_cast<int_object*>(this)->shared_from_this();
@@ -197,6 +209,12 @@ vanilla::int_object::int_type const& vanilla::int_object::value() const
 
 vanilla::object::ptr vanilla::int_object::neg()
 {
+    if(reference_count() == 1)
+    {
+        mpz_neg(_v.mpz(), _v.mpz());
+        return shared_from_this();
+    }
+    
     int_type result;
     mpz_neg(result.mpz(), _v.mpz());
     return allocate_object<int_object>(std::move(result));
@@ -204,6 +222,12 @@ vanilla::object::ptr vanilla::int_object::neg()
 
 vanilla::object::ptr vanilla::int_object::abs()
 {
+    if(reference_count() == 1)
+    {
+        mpz_abs(_v.mpz(), _v.mpz());
+        return shared_from_this();
+    }
+    
     int_type result;
     mpz_abs(result.mpz(), _v.mpz());
     return allocate_object<int_object>(std::move(result));
@@ -216,6 +240,13 @@ vanilla::object::ptr vanilla::int_object::add(object::ptr const& other)
         case OBJECT_ID_INT:
         {
             int_object const* rhs = static_cast<int_object const*>(other.get());
+            if(reference_count() == 1)
+            {
+                // The limbs are reused, GMP allows the result to alias.
+                mpz_add(_v.mpz(), _v.mpz(), rhs->value().mpz());
+                return shared_from_this();
+            }
+            
             int_type result;
             mpz_add(result.mpz(), _v.mpz(), rhs->value().mpz());
             return allocate_object<int_object>(std::move(result));
@@ -244,6 +275,12 @@ vanilla::object::ptr vanilla::int_object::sub(object::ptr const& other)
         case OBJECT_ID_INT:
         {
             int_object const* rhs = static_cast<int_object const*>(other.get());
+            if(reference_count() == 1)
+            {
+                mpz_sub(_v.mpz(), _v.mpz(), rhs->value().mpz());
+                return shared_from_this();
+            }
+            
             int_type result;
             mpz_sub(result.mpz(), _v.mpz(), rhs->value().mpz());
             return allocate_object<int_object>(std::move(result));
@@ -272,6 +309,12 @@ vanilla::object::ptr vanilla::int_object::mul(object::ptr const& other)
         case OBJECT_ID_INT:
         {
             int_object const* rhs = static_cast<int_object const*>(other.get());
+            if(reference_count() == 1)
+            {
+                mpz_mul(_v.mpz(), _v.mpz(), rhs->value().mpz());
+                return shared_from_this();
+            }
+            
             int_type result;
             mpz_mul(result.mpz(), _v.mpz(), rhs->value().mpz());
             return allocate_object<int_object>(std::move(result));
@@ -434,18 +477,11 @@ vanilla::object::ptr vanilla::int_object::eq(object::ptr const& other)
         }
         
         case OBJECT_ID_FLOAT:
-        {
-            float_object const* rhs = static_cast<float_object const*>(other.get());
-            if(!mpf_integer_p(rhs->value().mpf()))
-                return allocate_object<bool_object>(false);
-            
-            float_object::float_type lhs( (_v.mpz()) );
-            return allocate_object<bool_object>(mpf_cmp(lhs.mpf(), rhs->value().mpf()) == 0);
-        }
+            return allocate_object<bool_object>(equals(*other));
         
         default:
         {
-            return object::ge(other);
+            return object::eq(other);
         }
     }
 }
@@ -462,18 +498,11 @@ vanilla::object::ptr vanilla::int_object::neq(object::ptr const& other)
         }
         
         case OBJECT_ID_FLOAT:
-        {
-            float_object const* rhs = static_cast<float_object const*>(other.get());
-            if(!mpf_integer_p(rhs->value().mpf()))
-                return allocate_object<bool_object>(true);
-            
-            float_object::float_type lhs( (_v.mpz()) );
-            return allocate_object<bool_object>(mpf_cmp(lhs.mpf(), rhs->value().mpf()) != 0);
-        }
+            return allocate_object<bool_object>(!equals(*other));
         
         default:
         {
-            return object::ge(other);
+            return object::neq(other);
         }
     }
 }
@@ -492,6 +521,45 @@ void vanilla::int_object::eset(std::string const& name, ptr value)
     return object::eset(name, std::move(value));
 }
 
+std::size_t vanilla::int_object::hash() const
+{
+    return hash_value(_v);
+}
+
+bool vanilla::int_object::equals(object const& other) const
+{
+    switch(other.type_id())
+    {
+        case OBJECT_ID_INT:
+            return mpz_cmp(_v.mpz(), static_cast<int_object const&>(other).value().mpz()) == 0;
+        
+        case OBJECT_ID_FLOAT:
+        {
+            // Exact, and the conversion float_object::hash uses.
+            float_object const& rhs = static_cast<float_object const&>(other);
+            if(!mpf_integer_p(rhs.value().mpf()))
+                return false;
+            
+            int_type rhs_value( (rhs.value().mpf()) );
+            return mpz_cmp(_v.mpz(), rhs_value.mpz()) == 0;
+        }
+        
+        default:
+            return false;
+    }
+}
+
+std::size_t vanilla::int_object::hash_value(int_type const& v)
+{
+    if(mpz_fits_slong_p(v.mpz()))
+        return mix_hash(mpz_get_si(v.mpz()));
+    
+    std::uint64_t h = mpz_sgn(v.mpz());
+    for(std::size_t i = 0; i < mpz_size(v.mpz()); ++i)
+        h = mix_hash(h ^ mpz_getlimbn(v.mpz(), i));
+    return h;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 /////////// FREE FUNCTIONS
 ///////////////////////////////////////////////////////////////////////////
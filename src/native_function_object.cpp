@@ -30,6 +30,8 @@
 #include <vanilla/string_object.hpp>
 #include <vanilla/float_object.hpp>
 #include <vanilla/function_object.hpp>
+#include <vanilla/profiler.hpp>
+#include <vanilla/tracing.hpp>
 
 ///////////////////////////////////////////////////////////////////////////
 /////////// UTILITY
@@ -144,14 +146,15 @@ namespace
     class ffi_argument_converter_string8 : public vanilla::detail::ffi_argument_converter
     {
     private:
-        std::string _string8;
+        // Kept alive for the call, its characters are zero terminated.
+        vanilla::object::ptr _string8;
         
     public:
         virtual vanilla::detail::native_datatype convert(vanilla::object::ptr const& in) override
         {
             vanilla::detail::native_datatype result;
-            _string8 = vanilla::string_object_to_cpp_string(in->to_string());
-            result.p =  const_cast<char*>(_string8.c_str());
+            _string8 = in->to_string();
+            result.p = const_cast<char*>(static_cast<vanilla::string_object const*>(_string8.get())->c_str());
             return result;
         }
         
@@ -310,7 +313,9 @@ vanilla::native_function_object::native_function_object(
         _argument_converter(),
         _result_converter(create_result_converter(_result)),
         _lock(),
-        _requires_locking(false)
+        _requires_locking(false),
+        _trace_name(nullptr),
+        _profile_name(nullptr)
 {
     // Fill ffiargs.
     for(unsigned i = 0; i < _args.size(); ++i)
@@ -362,6 +367,29 @@ vanilla::object::ptr vanilla::native_function_object::to_string() const
     return allocate_object<string_object>(std::move(result));
 }
 
+char const* vanilla::native_function_object::trace_name() const
+{
+    // Racing calls intern the same name and store the same pointer.
+    char const* name = _trace_name.load(std::memory_order_relaxed);
+    if(!name)
+    {
+        name = tracing::detail::intern(_name);
+        _trace_name.store(name, std::memory_order_relaxed);
+    }
+    return name;
+}
+
+char const* vanilla::native_function_object::profile_name() const
+{
+    char const* name = _profile_name.load(std::memory_order_relaxed);
+    if(!name)
+    {
+        name = profiler::detail::intern(_name);
+        _profile_name.store(name, std::memory_order_relaxed);
+    }
+    return name;
+}
+
 vanilla::object::ptr vanilla::native_function_object::call(
     context& c, ptr* argv, unsigned argc)
 {
@@ -381,6 +409,9 @@ vanilla::object::ptr vanilla::native_function_object::call(
             << error::num_arguments_received(argc));
     }
     
+    profiler::scoped_frame frame(profiler::detail::published.active ? profile_name() : nullptr);
+    tracing::scoped_event event(tracing::detail::active ? trace_name() : nullptr, "native");
+    
     std::vector<detail::native_datatype> converted_args( (argc) );
     std::vector<void*> native_argv( (argc) );
     detail::native_datatype result;
@@ -396,6 +427,7 @@ vanilla::object::ptr vanilla::native_function_object::call(
         }   
     
         // Call the function.
+        tracing::scoped_event call("ffi_call", "ffi");
         ffi_call(&_cif, _function, &result, &native_argv[0]);
     }
     else
@@ -408,6 +440,7 @@ vanilla::object::ptr vanilla::native_function_object::call(
         }   
     
         // Call the function.
+        tracing::scoped_event call("ffi_call", "ffi");
         ffi_call(&_cif, _function, &result, &native_argv[0]);
     } 
     
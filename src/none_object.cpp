@@ -47,3 +47,12 @@ vanilla::object::ptr vanilla::none_object::to_string() const
     return allocate_object<string_object>("none");
 }
 
+std::size_t vanilla::none_object::hash() const
+{
+    return mix_hash(OBJECT_ID_NONE);
+}
+
+bool vanilla::none_object::equals(object const& other) const
+{
+    return other.type_id() == OBJECT_ID_NONE;
+}
@@ -24,15 +24,34 @@
 
 // Vanilla:
 #include <vanilla/object.hpp>
+#include <vanilla/cycle_collector.hpp>
 #include <vanilla/string_object.hpp>
 
 ///////////////////////////////////////////////////////////////////////////
 /////////// vanilla::object
 ///////////////////////////////////////////////////////////////////////////
 
+vanilla::object::object()
+    : _references(0), _flags(0)
+{ }
+
 vanilla::object::~object()
 { }
 
+void vanilla::object::operator delete(void* p)
+{
+    ::operator delete(p);
+}
+
+void vanilla::object::destroy() const
+{
+    if(_flags & FLAG_CYCLE_CANDIDATE)
+        cycle_collector::detail::forget(this);
+    if(_flags & FLAG_ACCOUNTED)
+        alloc_stats::detail::deallocated(*this);
+    delete this;
+}
+
 vanilla::object::ptr vanilla::object::copy(bool) const
 {
     vanilla::object* this_ = const_cast<vanilla::object*>(this);
@@ -206,4 +225,50 @@ void vanilla::object::eset(std::string const& name, ptr)
         << error::first_operand(shared_from_this())
         << error::cast_target_name(name)
         << error::operation_name("element assign"));
-}
\ No newline at end of file
+}
+
+std::size_t vanilla::object::hash() const
+{
+    BOOST_THROW_EXCEPTION(error::unsupported_operation_error()
+        << error::first_operand(shared_from_this())
+        << error::operation_name("hash"));
+}
+
+bool vanilla::object::equals(object const& other) const
+{
+    return this == &other;
+}
+
+bool vanilla::object::is_container() const
+{
+    return false;
+}
+
+std::size_t vanilla::object::memory_size() const
+{
+    return 0;
+}
+
+void vanilla::object::traverse(object_visitor&) const
+{ }
+
+void vanilla::object::release_references()
+{ }
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::object_visitor
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::object_visitor::~object_visitor()
+{ }
+
+///////////////////////////////////////////////////////////////////////////
+/////////// FREE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////
+
+bool vanilla::detail::atomic_references = false;
+
+void vanilla::set_atomic_references(bool enabled)
+{
+    detail::atomic_references = enabled;
+}
@@ -24,6 +24,13 @@
 #include <string>
 #include <fstream>
 #include <iterator>
+#include <memory>
+#include <initializer_list>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <exception>
+#include <cassert>
 
 // Boost:
 #include <boost/optional.hpp>
@@ -33,6 +40,7 @@
 #include <vanilla/scanner.hpp>
 #include <vanilla/statement_ast.hpp>
 #include <vanilla/float_object.hpp>
+#include <vanilla/tracing.hpp>
 
 namespace
 {    
@@ -42,27 +50,44 @@ namespace
         return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
     }
     
+    std::shared_ptr<vanilla::detail::token_source> tokenize(vanilla::cstr_range data,
+        std::shared_ptr<vanilla::detail::token_source> source =
+            std::make_shared<vanilla::detail::token_source>(),
+        unsigned line = 1, unsigned pos = 1)
+    {
+        vanilla::scanner scan(data, line, pos);
+        for(vanilla::token token = scan.get_token(); ; token = scan.get_token())
+        {
+            source->tokens.push_back(token);
+            if(token.type == vanilla::ttype::eof)
+                break;
+        }
+        
+        return source;
+    }
+    
     class token_buffer
     {
     private:
-        std::vector<vanilla::token> _buffer;
+        std::shared_ptr<vanilla::detail::token_source> _source;
+        vanilla::token* _buffer;
+        std::size_t _size;
         std::size_t _cur;
+        bool _lazy_functions;
         
     public:
-        token_buffer(vanilla::scanner& scan)
-            : _buffer(), _cur(0)
-        {
-            for(vanilla::token token = scan.get_token(); ; token = scan.get_token())
-            {
-                _buffer.push_back(token);
-                if(token.type == vanilla::ttype::eof)
-                    break;
-            }
-        }
+        token_buffer(std::shared_ptr<vanilla::detail::token_source> source,
+            bool lazy_functions = false, std::size_t cur = 0)
+            :   _source(std::move(source)),
+                _buffer(_source->tokens.data()),
+                _size(_source->tokens.size()),
+                _cur(cur),
+                _lazy_functions(lazy_functions)
+        { }
         
         bool exhausted()
         {
-            return _cur == _buffer.size();
+            return _cur == _size;
         }
         
         vanilla::token* cur()
@@ -73,6 +98,21 @@ namespace
             return &_buffer[_cur];
         }
         
+        std::size_t index() const
+        {
+            return _cur;
+        }
+        
+        bool lazy_functions() const
+        {
+            return _lazy_functions;
+        }
+        
+        std::shared_ptr<vanilla::detail::token_source> const& source() const
+        {
+            return _source;
+        }
+        
         vanilla::token* accept(vanilla::ttype t)
         {
             assert(!exhausted());
@@ -199,6 +239,293 @@ namespace
         }
     }
     
+    ///////////////////////////////////////////////////////////////////////
+    // Preparser.
+    //
+    // Mirrors the grammar of the parser below without building any AST so
+    // that function bodies can be validated cheaply and parsed on first use.
+    // It has to report exactly the errors the parser would report.
+    ///////////////////////////////////////////////////////////////////////
+    
+    void check_escape_sequences(vanilla::token* t)
+    {
+        assert(t->type == vanilla::ttype::string_lit);
+        
+        char const* end = t->lexeme.end();
+        for(char const* it = t->lexeme.begin(); it != end; ++it)
+        {
+            if(*it != '\\')
+                continue;
+            
+            ++it;
+            if(*it != 'n' && *it != 't' && *it != '\\' && *it != '\"')
+            {
+                BOOST_THROW_EXCEPTION(vanilla::error::invalid_escape_sequence()
+                    << vanilla::error::escape_sequence(std::string(it - 1, it + 1))
+                    << vanilla::error::line_info(t->line)
+                    << vanilla::error::pos_info(t->pos));
+            }
+        }
+    }
+    
+    void preparse_expression(token_buffer& buffer);
+    void preparse_statement(token_buffer& buffer);
+    
+    void preparse_parameter_list(token_buffer& buffer)
+    {
+        buffer.expect(vanilla::ttype::lparen);
+        while(!buffer.accept(vanilla::ttype::rparen))
+        {
+            buffer.expect(vanilla::ttype::ident);
+            if(buffer.accept(vanilla::ttype::assign))
+                preparse_expression(buffer);
+            
+            if(!buffer.accept(vanilla::ttype::comma))
+            {
+                buffer.expect(vanilla::ttype::rparen);
+                break;
+            }
+        }
+    }
+    
+    void preparse_expression_list(token_buffer& buffer, vanilla::ttype close)
+    {
+        while(!buffer.accept(close))
+        {
+            preparse_expression(buffer);
+            if(!buffer.accept(vanilla::ttype::comma))
+            {
+                buffer.expect(close);
+                break;
+            }
+        }
+    }
+    
+    void preparse_primary_expression(token_buffer& buffer)
+    {
+        vanilla::token* t;
+        if( (t = buffer.accept(vanilla::ttype::string_lit)) )
+        {
+            check_escape_sequences(t);
+            return;
+        }
+        
+        if( buffer.accept(vanilla::ttype::int_lit) ||
+            buffer.accept(vanilla::ttype::real_lit) ||
+            buffer.accept(vanilla::ttype::truelit) ||
+            buffer.accept(vanilla::ttype::falselit) ||
+            buffer.accept(vanilla::ttype::indeterminate) ||
+            buffer.accept(vanilla::ttype::ident) )
+        {
+            return;
+        }
+        
+        if(buffer.accept(vanilla::ttype::lparen))
+        {
+            preparse_expression(buffer);
+            buffer.expect(vanilla::ttype::rparen);
+            return;
+        }
+        
+        if(buffer.accept(vanilla::ttype::function))
+        {
+            buffer.accept(vanilla::ttype::ident);
+            preparse_parameter_list(buffer);
+            preparse_statement(buffer);
+            return;
+        }
+        
+        if(buffer.accept(vanilla::ttype::native))
+        {
+            check_escape_sequences(buffer.expect(vanilla::ttype::string_lit));
+            buffer.expect(vanilla::ttype::from);
+            check_escape_sequences(buffer.expect(vanilla::ttype::string_lit));
+            buffer.expect(vanilla::ttype::declared);
+            check_escape_sequences(buffer.expect(vanilla::ttype::string_lit));
+            buffer.expect(vanilla::ttype::lparen);
+            while(!buffer.accept(vanilla::ttype::rparen))
+            {
+                check_escape_sequences(buffer.expect(vanilla::ttype::string_lit));
+                if(!buffer.accept(vanilla::ttype::comma))
+                {
+                    buffer.expect(vanilla::ttype::rparen);
+                    break;
+                }
+            }
+            return;
+        }
+        
+        if(buffer.accept(vanilla::ttype::lbrack))
+        {
+            preparse_expression_list(buffer, vanilla::ttype::rbrack);
+            return;
+        }
+        
+        if(buffer.accept(vanilla::ttype::lbrace))
+        {
+            while(!buffer.accept(vanilla::ttype::rbrace))
+            {
+                preparse_expression(buffer);
+                buffer.expect(vanilla::ttype::colon);
+                preparse_expression(buffer);
+                if(!buffer.accept(vanilla::ttype::comma))
+                {
+                    buffer.expect(vanilla::ttype::rbrace);
+                    break;
+                }
+            }
+            return;
+        }
+        
+        t = buffer.cur();
+        BOOST_THROW_EXCEPTION(vanilla::error::expected_primary_expression_error()
+            << vanilla::error::line_info(t->line) << vanilla::error::pos_info(t->pos)
+            << vanilla::error::received_type(t->type));
+    }
+    
+    void preparse_postfix_expression(token_buffer& buffer)
+    {
+        preparse_primary_expression(buffer);
+        for(;;)
+        {
+            if(buffer.accept(vanilla::ttype::lparen))
+            {
+                preparse_expression_list(buffer, vanilla::ttype::rparen);
+                continue;
+            }
+            
+            if(buffer.accept(vanilla::ttype::lbrack))
+            {
+                preparse_expression(buffer);
+                buffer.expect(vanilla::ttype::rbrack);
+                continue;
+            }
+            
+            if(buffer.accept(vanilla::ttype::element_selection))
+            {
+                buffer.expect(vanilla::ttype::ident);
+                continue;
+            }
+            
+            break;
+        }
+    }
+    
+    void preparse_prefix_expression(token_buffer& buffer)
+    {
+        while(buffer.accept(vanilla::ttype::minus) || buffer.accept(vanilla::ttype::plus))
+            ;
+        preparse_postfix_expression(buffer);
+    }
+    
+    // The binary operators are right recursive in the parser, which is
+    // equivalent to a loop over the operands when no AST is built.
+    template<typename Operand>
+    void preparse_binary_expression(token_buffer& buffer, Operand operand,
+        std::initializer_list<vanilla::ttype> operators)
+    {
+        for(;;)
+        {
+            operand(buffer);
+            
+            bool matched = false;
+            for(vanilla::ttype op : operators)
+            {
+                if( (matched = buffer.accept(op) != nullptr) )
+                    break;
+            }
+            
+            if(!matched)
+                return;
+        }
+    }
+    
+    void preparse_multiplicative_expression(token_buffer& buffer)
+    {
+        preparse_binary_expression(buffer, preparse_prefix_expression,
+            { vanilla::ttype::mul, vanilla::ttype::div });
+    }
+    
+    void preparse_additive_expression(token_buffer& buffer)
+    {
+        preparse_binary_expression(buffer, preparse_multiplicative_expression,
+            { vanilla::ttype::plus, vanilla::ttype::minus, vanilla::ttype::concat });
+    }
+    
+    void preparse_relational_expression(token_buffer& buffer)
+    {
+        preparse_binary_expression(buffer, preparse_additive_expression,
+            {   vanilla::ttype::less, vanilla::ttype::less_equal,
+                vanilla::ttype::greater, vanilla::ttype::greater_equal });
+    }
+    
+    void preparse_equality_expression(token_buffer& buffer)
+    {
+        preparse_binary_expression(buffer, preparse_relational_expression,
+            { vanilla::ttype::equal, vanilla::ttype::not_equal });
+    }
+    
+    void preparse_expression(token_buffer& buffer)
+    {
+        preparse_equality_expression(buffer);
+        if(!buffer.accept(vanilla::ttype::questionmark))
+            return;
+        
+        preparse_expression(buffer);
+        buffer.expect(vanilla::ttype::colon);
+        preparse_expression(buffer);
+    }
+    
+    void preparse_statement(token_buffer& buffer)
+    {
+        if(buffer.accept(vanilla::ttype::ret))
+        {
+            preparse_expression(buffer);
+            buffer.expect(vanilla::ttype::endstmnt);
+            return;
+        }
+        
+        if(buffer.accept(vanilla::ttype::lbrace))
+        {
+            while(!buffer.accept(vanilla::ttype::rbrace))
+                preparse_statement(buffer);
+            return;
+        }
+        
+        if(buffer.accept(vanilla::ttype::if_))
+        {
+            do
+            {
+                preparse_expression(buffer);
+                preparse_statement(buffer);
+            } while(buffer.accept(vanilla::ttype::elseif));
+            
+            if(buffer.accept(vanilla::ttype::else_))
+                preparse_statement(buffer);
+            return;
+        }
+        
+        if(buffer.accept(vanilla::ttype::while_))
+        {
+            preparse_expression(buffer);
+            preparse_statement(buffer);
+            return;
+        }
+        
+        if(buffer.accept(vanilla::ttype::function))
+        {
+            buffer.expect(vanilla::ttype::ident);
+            preparse_parameter_list(buffer);
+            preparse_statement(buffer);
+            return;
+        }
+        
+        preparse_expression(buffer);
+        if(buffer.accept(vanilla::ttype::assign))
+            preparse_expression(buffer);
+        buffer.expect(vanilla::ttype::endstmnt);
+    }
+    
     vanilla::expression_node::ptr parse_int_lit(token_buffer& buffer)
     {
         vanilla::token* t;
@@ -338,6 +665,19 @@ namespace
     }
     
     vanilla::statement_node::ptr parse_statement(token_buffer& buffer);
+    std::shared_ptr<vanilla::statement_node> parse_function_body(token_buffer& buffer)
+    {
+        if(!buffer.lazy_functions())
+            return std::shared_ptr<vanilla::statement_node>(parse_statement(buffer));
+        
+        // Only validate the body and remember where it is.
+        vanilla::token* t = buffer.cur();
+        std::size_t begin = buffer.index();
+        preparse_statement(buffer);
+        return std::make_shared<vanilla::lazy_statement_node>(
+            t->line, t->pos, buffer.source(), begin, buffer.index());
+    }
+    
     vanilla::expression_node::ptr parse_function_definition_expression(token_buffer& buffer)
     {
         vanilla::token* t;
@@ -372,9 +712,7 @@ namespace
         }
         
         // Parse the function body.
-        vanilla::statement_node::ptr body_unique = parse_statement(buffer);
-        std::shared_ptr<vanilla::statement_node> body(body_unique.get());
-        body_unique.release();
+        std::shared_ptr<vanilla::statement_node> body = parse_function_body(buffer);
         
         return make_unique<vanilla::function_definition_expression_node>(
             t->line, t->pos, std::move(name), std::move(arguments), std::move(body));
@@ -430,6 +768,30 @@ namespace
             t->line, t->pos, std::move(values));
     }
     
+    vanilla::expression_node::ptr parse_dict_expression(token_buffer& buffer)
+    {
+        vanilla::token* t;
+        if( !(t = buffer.accept(vanilla::ttype::lbrace)) )
+            return vanilla::expression_node::ptr();
+        
+        std::vector<vanilla::expression_node::ptr> keys;
+        std::vector<vanilla::expression_node::ptr> values;
+        while(!buffer.accept(vanilla::ttype::rbrace))
+        {
+            keys.push_back(parse_expression(buffer));
+            buffer.expect(vanilla::ttype::colon);
+            values.push_back(parse_expression(buffer));
+            if(!buffer.accept(vanilla::ttype::comma))
+            {
+                buffer.expect(vanilla::ttype::rbrace);
+                break;
+            }
+        }
+        
+        return make_unique<vanilla::dict_expression_node>(
+            t->line, t->pos, std::move(keys), std::move(values));
+    }
+    
     vanilla::expression_node::ptr parse_primary_expression(token_buffer& buffer)
     {
         vanilla::expression_node::ptr n;
@@ -445,6 +807,8 @@ namespace
             return n;
         if( (n = parse_array_expression(buffer)) )
             return n;
+        if( (n = parse_dict_expression(buffer)) )
+            return n;
         
         vanilla::token* t = buffer.cur();
         BOOST_THROW_EXCEPTION(vanilla::error::expected_primary_expression_error()
@@ -673,11 +1037,14 @@ namespace
         
         // Parse if.
         std::vector<std::pair<vanilla::expression_node::ptr, vanilla::statement_node::ptr>> ifs;
-        ifs.emplace_back(std::make_pair(parse_expression(buffer), parse_statement(buffer)));
-        
-        // Parse elseifs.
-        while(buffer.accept(vanilla::ttype::elseif))
-            ifs.emplace_back(std::make_pair(parse_expression(buffer), parse_statement(buffer)));
+        do
+        {
+            // The condition must be parsed before the statement, so don't
+            // rely on the unspecified evaluation order of function arguments.
+            vanilla::expression_node::ptr condition = parse_expression(buffer);
+            vanilla::statement_node::ptr code = parse_statement(buffer);
+            ifs.emplace_back(std::move(condition), std::move(code));
+        } while(buffer.accept(vanilla::ttype::elseif)); // Parse elseifs.
         
         // Parse else.
         vanilla::statement_node::ptr else_;
@@ -729,9 +1096,7 @@ namespace
         }
         
         // Parse the function body.
-        vanilla::statement_node::ptr body_unique = parse_statement(buffer);
-        std::shared_ptr<vanilla::statement_node> body(body_unique.get());
-        body_unique.release();
+        std::shared_ptr<vanilla::statement_node> body = parse_function_body(buffer);
         
         return make_unique<vanilla::function_definition_statement_node>(
             t->line, t->pos, std::move(name), std::move(arguments), std::move(body));
@@ -771,29 +1136,198 @@ namespace
         
         return parse_assignment_statement(buffer);
     }
+
+    vanilla::statement_node::ptr parse_program(token_buffer& buffer)
+    {
+        std::vector<vanilla::statement_node::ptr> block;
+        while(!buffer.accept(vanilla::ttype::eof))
+            block.push_back(parse_statement(buffer));
+        return make_unique<vanilla::statement_sequence_node>(0, 0, std::move(block));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::lazy_statement_node
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::lazy_statement_node::lazy_statement_node(
+            unsigned line,
+            unsigned pos,
+            std::shared_ptr<detail::token_source> source,
+            std::size_t begin,
+            std::size_t end )
+    :   statement_node(line, pos),
+        _source(std::move(source)),
+        _begin(begin),
+        _end(end),
+        _body()
+{ }
+
+bool vanilla::lazy_statement_node::is_parsed() const
+{
+    return bool(_body);
+}
+
+vanilla::cstr_range vanilla::lazy_statement_node::get_text() const
+{
+    assert(!is_parsed());
+    
+    // String literal lexemes exclude their quotes.
+    token const& first = _source->tokens[_begin];
+    token const& last = _source->tokens[_end - 1];
+    return cstr_range(
+        first.lexeme.begin() - (first.type == ttype::string_lit ? 1 : 0),
+        last.lexeme.end() + (last.type == ttype::string_lit ? 1 : 0));
+}
+
+vanilla::statement_node* vanilla::lazy_statement_node::get_body()
+{
+    if(!_body)
+    {
+        // The range was accepted by the preparser, so this can't fail.
+        token_buffer buffer(_source, true, _begin);
+        _body = parse_statement(buffer);
+        assert(buffer.index() == _end);
+        
+        // Release the tokens once nothing refers to them anymore.
+        _source.reset();
+    }
+    
+    return _body.get();
 }
 
+void vanilla::lazy_statement_node::eval(context& c)
+{
+    get_body()->eval(c);
+}
+
+void vanilla::lazy_statement_node::accept(ast_visitor* v)
+{
+    get_body()->accept(v);
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// FREE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////
+
 vanilla::expression_node::ptr vanilla::parse_expr(char const* expr)
 {
-    scanner scan( (expr) );
-    token_buffer buffer( (scan) );
+    token_buffer buffer( (tokenize(expr)) );
     return parse_expression(buffer);
 }
 
-vanilla::statement_node::ptr vanilla::parse_string(char const* str)
+vanilla::statement_node::ptr vanilla::parse_string(char const* str, bool lazy_functions)
 {
-    scanner scan( (str) );
-    token_buffer buffer( (scan) );
+    // Lazy bodies outlive the caller's string, so the source needs a copy.
+    if(lazy_functions)
+        return parse_source(std::string(str), true);
     
-    std::vector<vanilla::statement_node::ptr> block;
-    while(!buffer.accept(vanilla::ttype::eof))
-        block.push_back(parse_statement(buffer));
-    return make_unique<vanilla::statement_sequence_node>(0, 0, std::move(block));
+    token_buffer buffer(tokenize(str));
+    return parse_program(buffer);
 }
 
-vanilla::statement_node::ptr vanilla::parse_file(char const* filename)
+std::shared_ptr<vanilla::detail::token_source> vanilla::detail::tokenize_source(std::string text)
+{
+    auto source = std::make_shared<token_source>();
+    source->text = std::move(text);
+    char const* data = source->text.c_str();
+    return tokenize(data, std::move(source));
+}
+
+vanilla::statement_node::ptr vanilla::parse_source(std::string text, bool lazy_functions)
+{
+    token_buffer buffer(detail::tokenize_source(std::move(text)), lazy_functions);
+    return parse_program(buffer);
+}
+
+vanilla::statement_node::ptr vanilla::parse_body(std::string text, unsigned line, unsigned pos)
+{
+    auto source = std::make_shared<detail::token_source>();
+    source->text = std::move(text);
+    char const* data = source->text.c_str();
+    token_buffer buffer(tokenize(data, std::move(source), line, pos), true);
+    
+    statement_node::ptr result = parse_statement(buffer);
+    buffer.expect(ttype::eof);
+    return result;
+}
+
+vanilla::statement_node::ptr vanilla::parse_file(char const* filename, bool lazy_functions)
 {
     std::ifstream in( (filename) );
     std::string str( (std::istreambuf_iterator<char>(in)) , std::istreambuf_iterator<char>());
-    return parse_string(str.c_str());
-}
\ No newline at end of file
+    return parse_source(std::move(str), lazy_functions);
+}
+
+vanilla::statement_node::ptr vanilla::parse_files(  std::vector<std::string> const& filenames,
+                                                    unsigned threads,
+                                                    bool lazy_functions )
+{
+    std::vector<statement_node::ptr> programs(filenames.size());
+    std::vector<std::exception_ptr> errors(filenames.size());
+    
+    // Files are handed out in list order. Once a file failed, files after it
+    // can't produce the reported error anymore and are skipped.
+    std::atomic<std::size_t> next(0);
+    std::atomic<std::size_t> first_error(filenames.size());
+    
+    auto worker = [&]()
+    {
+        for(std::size_t i; (i = next++) < filenames.size(); )
+        {
+            if(i > first_error)
+                break;
+            
+            try
+            {
+                tracing::scoped_event event(filenames[i], "parse");
+                programs[i] = parse_file(filenames[i].c_str(), lazy_functions);
+                continue;
+            }
+            catch(error::base_error& e)
+            {
+                e << error::file_info(filenames[i]);
+                errors[i] = std::current_exception();
+            }
+            catch(...)
+            {
+                errors[i] = std::current_exception();
+            }
+            
+            std::size_t cur = first_error;
+            while(i < cur && !first_error.compare_exchange_weak(cur, i))
+                { }
+        }
+    };
+    
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min<std::size_t>(threads, filenames.size());
+    
+    // The calling thread works as well.
+    std::vector<std::thread> pool;
+    for(unsigned i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for(std::thread& t : pool)
+        t.join();
+    
+    if(first_error < filenames.size())
+        std::rethrow_exception(errors[first_error]);
+    
+    std::vector<statement_node::ptr> code;
+    for(statement_node::ptr& program : programs)
+    {
+        if(auto sequence = dynamic_cast<statement_sequence_node*>(program.get()))
+        {
+            for(statement_node::ptr& cur : sequence->get_code())
+                code.push_back(std::move(cur));
+        }
+        else
+        {
+            code.push_back(std::move(program));
+        }
+    }
+    
+    return make_unique<statement_sequence_node>(0, 0, std::move(code));
+}
@@ -0,0 +1,258 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+#include <atomic>
+#include <vector>
+#include <map>
+#include <unordered_set>
+#include <algorithm>
+
+// System:
+#include <signal.h>
+#include <sys/time.h>
+
+// Vanilla:
+#include <vanilla/profiler.hpp>
+#include <vanilla/ast_base.hpp>
+
+namespace
+{
+    // Samples are stored back to back as
+    //  [depth] [current] [name 0] [caller 0] ... [name depth-1] [caller depth-1]
+    // Allocated uninitialized, so only the pages used are ever touched.
+    std::size_t const SAMPLE_BUFFER_SLOTS = 16 * 1024 * 1024;
+    
+    std::unique_ptr<std::uintptr_t[]> samples;
+    std::size_t samples_used = 0;
+    std::size_t samples_dropped = 0;
+    std::atomic_flag handler_busy = ATOMIC_FLAG_INIT;
+    
+    std::unordered_set<std::string> interned_names;
+    
+    struct sigaction old_action;
+    
+    void handle_sigprof(int)
+    {
+        // Another thread might be in here already.
+        if(handler_busy.test_and_set(std::memory_order_acquire))
+        {
+            ++samples_dropped;
+            return;
+        }
+        
+        auto& published = vanilla::profiler::detail::published;
+        std::size_t depth = published.depth;
+        std::atomic_signal_fence(std::memory_order_acquire);
+        depth = std::min(depth, vanilla::profiler::MAX_STACK_DEPTH);
+        
+        std::size_t needed = 2 + 2 * depth;
+        if(SAMPLE_BUFFER_SLOTS - samples_used < needed)
+        {
+            ++samples_dropped;
+        }
+        else
+        {
+            std::uintptr_t* p = &samples[samples_used];
+            *p++ = depth;
+            *p++ = reinterpret_cast<std::uintptr_t>(published.current);
+            for(std::size_t i = 0; i < depth; ++i)
+            {
+                *p++ = reinterpret_cast<std::uintptr_t>(published.stack[i].name);
+                *p++ = reinterpret_cast<std::uintptr_t>(published.stack[i].caller);
+            }
+            samples_used += needed;
+        }
+        
+        handler_busy.clear(std::memory_order_release);
+    }
+    
+    void append_frame(std::string& s, char const* name, std::uintptr_t node)
+    {
+        s += name;
+        if(node)
+        {
+            s += ':';
+            s += std::to_string(reinterpret_cast<vanilla::ast_node const*>(node)->get_line());
+        }
+    }
+    
+    template<typename F>
+    void for_each_sample(F f)
+    {
+        for(std::size_t i = 0; i < samples_used; )
+        {
+            std::size_t depth = samples[i];
+            f(&samples[i + 1], depth);
+            i += 2 + 2 * depth;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::profiler
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::profiler::detail::published_state vanilla::profiler::detail::published;
+
+char const* vanilla::profiler::detail::intern(std::string const& name)
+{
+    return interned_names.insert(name.empty() ? "<anonymous>" : name).first->c_str();
+}
+
+void vanilla::profiler::scoped_frame::push(char const* name)
+{
+    auto& published = detail::published;
+    std::size_t depth = published.depth;
+    if(depth < MAX_STACK_DEPTH)
+    {
+        published.stack[depth].name = name;
+        published.stack[depth].caller = published.current;
+    }
+    
+    std::atomic_signal_fence(std::memory_order_release);
+    published.depth = depth + 1;
+}
+
+void vanilla::profiler::scoped_frame::pop()
+{
+    auto& published = detail::published;
+    std::size_t depth = published.depth - 1;
+    ast_node const* caller = depth < MAX_STACK_DEPTH ? published.stack[depth].caller : nullptr;
+    
+    published.depth = depth;
+    std::atomic_signal_fence(std::memory_order_release);
+    if(caller)
+        published.current = caller;
+}
+
+void vanilla::profiler::start(unsigned frequency)
+{
+    if(detail::published.active)
+        return;
+    
+    if(!samples)
+        samples.reset(new std::uintptr_t[SAMPLE_BUFFER_SLOTS]);
+    samples_used = 0;
+    samples_dropped = 0;
+    detail::published.depth = 0;
+    detail::published.active = true;
+    
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_sigprof;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if(sigaction(SIGPROF, &action, &old_action) != 0)
+    {
+        detail::published.active = false;
+        BOOST_THROW_EXCEPTION(error::profiler_error()
+            << error::error_string(std::string("sigaction: ") + std::strerror(errno)));
+    }
+    
+    long interval = 1000000 / std::max(1u, std::min(frequency, 1000000u));
+    struct itimerval timer;
+    timer.it_interval.tv_sec = interval / 1000000;
+    timer.it_interval.tv_usec = interval % 1000000;
+    timer.it_value = timer.it_interval;
+    if(setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+    {
+        sigaction(SIGPROF, &old_action, nullptr);
+        detail::published.active = false;
+        BOOST_THROW_EXCEPTION(error::profiler_error()
+            << error::error_string(std::string("setitimer: ") + std::strerror(errno)));
+    }
+}
+
+void vanilla::profiler::stop()
+{
+    if(!detail::published.active)
+        return;
+    
+    struct itimerval timer;
+    std::memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    sigaction(SIGPROF, &old_action, nullptr);
+    
+    detail::published.active = false;
+}
+
+bool vanilla::profiler::is_running()
+{
+    return detail::published.active;
+}
+
+void vanilla::profiler::write_folded_stacks(std::ostream& o)
+{
+    std::map<std::string, std::size_t> stacks;
+    for_each_sample([&](std::uintptr_t const* sample, std::size_t depth)
+    {
+        // The line of each frame is the statement of the call to the next
+        // one, the innermost frame is at the current statement.
+        std::string s;
+        std::uintptr_t current = sample[0];
+        append_frame(s, "<toplevel>", depth ? sample[2] : current);
+        for(std::size_t i = 0; i < depth; ++i)
+        {
+            s += ';';
+            append_frame(s, reinterpret_cast<char const*>(sample[1 + 2 * i]),
+                i + 1 < depth ? sample[1 + 2 * (i + 1) + 1] : current);
+        }
+        ++stacks[s];
+    });
+    
+    for(auto const& cur : stacks)
+        o << cur.first << ' ' << cur.second << '\n';
+}
+
+void vanilla::profiler::write_line_table(std::ostream& o)
+{
+    std::size_t total = 0;
+    std::map<unsigned, std::size_t> lines;
+    for_each_sample([&](std::uintptr_t const* sample, std::size_t)
+    {
+        ++total;
+        if(sample[0])
+            ++lines[reinterpret_cast<ast_node const*>(sample[0])->get_line()];
+    });
+    
+    std::vector<std::pair<unsigned, std::size_t>> sorted(lines.begin(), lines.end());
+    std::stable_sort(sorted.begin(), sorted.end(),
+        [](std::pair<unsigned, std::size_t> const& a, std::pair<unsigned, std::size_t> const& b)
+        {
+            return a.second > b.second;
+        });
+    
+    o << "# samples: " << total << ", dropped: " << samples_dropped << '\n';
+    o << "#   line    samples  percent\n";
+    for(auto const& cur : sorted)
+    {
+        char row[64];
+        std::snprintf(row, sizeof(row), "%8u %10zu %7.2f%%\n",
+            cur.first, cur.second, 100.0 * cur.second / std::max<std::size_t>(total, 1));
+        o << row;
+    }
+}
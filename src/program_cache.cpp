@@ -0,0 +1,1185 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <cassert>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+// System:
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+
+// Vanilla:
+#include <vanilla/program_cache.hpp>
+#include <vanilla/parsing.hpp>
+
+///////////////////////////////////////////////////////////////////////////
+/////////// UTILITY
+///////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    template<typename T, typename... Args>
+    std::unique_ptr<T> make_unique(Args&&... args)
+    {
+        return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
+    }
+    
+    char const PROGRAM_CACHE_MAGIC[4] = { 'V', 'N', 'L', 'C' };
+    std::uint32_t const PROGRAM_CACHE_BYTE_ORDER = 0x01020304;
+    
+    // Magic, version, byte order, reserved, source hash and checksum. The
+    // checksum covers everything after the header but the function bodies;
+    // each body has its own checksum, which covers the body but the bodies
+    // nested in it. So only what is read gets checked, and loading doesn't
+    // touch the pages of bodies that are never called.
+    std::size_t const PROGRAM_CACHE_HEADER_SIZE = 32;
+    std::size_t const PROGRAM_CACHE_CHECKSUM_OFFSET = 24;
+    
+    std::uint64_t const FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+    
+    // 64 bit FNV-1a, continued from hash.
+    std::uint64_t fnv1a(std::uint64_t hash, char const* data, std::size_t length)
+    {
+        for(std::size_t i = 0; i < length; ++i)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+    
+    // How a function body is stored. Bodies that were never parsed are
+    // stored as their source text, so writing an entry parses nothing.
+    enum class body_kind : std::uint8_t
+    {
+        ast = 1,
+        source
+    };
+    
+    enum class node_tag : std::uint8_t
+    {
+        // Expressions.
+        variable = 1,
+        int_,
+        float_,
+        string,
+        bool_,
+        array,
+        dict,
+        negation,
+        abs,
+        addition,
+        subtraction,
+        multiplication,
+        division,
+        concatenation,
+        lessthan,
+        lessequal,
+        greaterthan,
+        greaterequal,
+        equality,
+        inequality,
+        function_call,
+        function_definition_expression,
+        native_function_definition,
+        conditional,
+        subscript,
+        element_selection,
+        
+        // Statements.
+        expression_statement,
+        return_,
+        statement_sequence,
+        if_,
+        while_,
+        function_definition_statement,
+        assignment
+    };
+    
+    void throw_malformed(char const* what)
+    {
+        BOOST_THROW_EXCEPTION(vanilla::error::program_cache_error()
+            << vanilla::error::error_string(what));
+    }
+    
+    ///////////////////////////////////////////////////////////////////////
+    // Writer.
+    ///////////////////////////////////////////////////////////////////////
+    
+    class program_writer : public vanilla::ast_visitor
+    {
+    private:
+        std::string& _out;
+        
+        // The ranges of the bodies written so far in each body that is
+        // being written, and in the top level.
+        std::vector<std::vector<std::pair<std::size_t, std::size_t>>> _bodies;
+        
+        void put_raw(void const* p, std::size_t n)
+        {
+            _out.append(static_cast<char const*>(p), n);
+        }
+        
+        void put_u8(std::uint8_t v)
+        {
+            put_raw(&v, sizeof(v));
+        }
+        
+        void put_u32(std::uint32_t v)
+        {
+            put_raw(&v, sizeof(v));
+        }
+        
+        void put_u64(std::uint64_t v)
+        {
+            put_raw(&v, sizeof(v));
+        }
+        
+        void put_i64(std::int64_t v)
+        {
+            put_raw(&v, sizeof(v));
+        }
+        
+        void put_bytes(vanilla::cstr_range s)
+        {
+            put_u32(s.length());
+            put_raw(s.begin(), s.length());
+        }
+        
+        void put_string(std::string const& s)
+        {
+            put_u32(s.size());
+            put_raw(s.data(), s.size());
+        }
+        
+        void put_node(node_tag tag, vanilla::ast_node* n)
+        {
+            put_u8(static_cast<std::uint8_t>(tag));
+            put_u32(n->get_line());
+            put_u32(n->get_pos());
+        }
+        
+        void put_binary(node_tag tag, vanilla::binary_expression_node* n)
+        {
+            put_node(tag, n);
+            n->get_left()->accept(this);
+            n->get_right()->accept(this);
+        }
+        
+        void put_arguments(
+            std::vector<std::pair<std::string, vanilla::expression_node::ptr>> const& arguments)
+        {
+            put_u32(arguments.size());
+            for(auto const& cur : arguments)
+            {
+                put_string(cur.first);
+                put_u8(cur.second ? 1 : 0);
+                if(cur.second)
+                    cur.second->accept(this);
+            }
+        }
+        
+        // The checksum of the innermost body being written, or the top
+        // level, from begin on; the bodies in it are left out.
+        std::uint64_t checksum(std::size_t begin) const
+        {
+            std::uint64_t hash = FNV_OFFSET_BASIS;
+            for(auto const& body : _bodies.back())
+            {
+                hash = fnv1a(hash, _out.data() + begin, body.first - begin);
+                begin = body.second;
+            }
+            return fnv1a(hash, _out.data() + begin, _out.size() - begin);
+        }
+        
+        // Bodies are prefixed with their length and checksum, so the reader
+        // can skip them and check them once they are read.
+        void put_body(vanilla::statement_node* n)
+        {
+            // An entry read from the cache is copied as it is.
+            auto cached = dynamic_cast<vanilla::cached_statement_node*>(n);
+            if(cached && !cached->is_loaded())
+            {
+                vanilla::cstr_range data = cached->get_data();
+                put_u32(data.length());
+                put_u64(cached->get_checksum());
+                _bodies.back().emplace_back(_out.size(), _out.size() + data.length());
+                put_raw(data.begin(), data.length());
+                return;
+            }
+            
+            std::size_t length_offset = _out.size();
+            put_u32(0);
+            put_u64(0);
+            std::size_t begin = _out.size();
+            _bodies.emplace_back();
+            
+            auto lazy = dynamic_cast<vanilla::lazy_statement_node*>(n);
+            if(lazy && !lazy->is_parsed())
+            {
+                put_u8(static_cast<std::uint8_t>(body_kind::source));
+                put_u32(n->get_line());
+                put_u32(n->get_pos());
+                put_bytes(lazy->get_text());
+            }
+            else
+            {
+                put_u8(static_cast<std::uint8_t>(body_kind::ast));
+                put_statement(n);
+            }
+            
+            std::uint32_t length = _out.size() - begin;
+            std::uint64_t body_checksum = checksum(begin);
+            std::memcpy(&_out[length_offset], &length, sizeof(length));
+            std::memcpy(&_out[length_offset + sizeof(length)], &body_checksum, sizeof(body_checksum));
+            _bodies.pop_back();
+            _bodies.back().emplace_back(begin, _out.size());
+        }
+        
+    public:
+        explicit program_writer(std::string& out)
+            : _out(out), _bodies(1)
+        { }
+        
+        void put_header(std::uint64_t source_hash)
+        {
+            put_raw(PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC));
+            put_u32(vanilla::PROGRAM_CACHE_VERSION);
+            put_u32(PROGRAM_CACHE_BYTE_ORDER);
+            put_u32(0); // Reserved.
+            put_raw(&source_hash, sizeof(source_hash));
+            put_raw(&source_hash, sizeof(source_hash)); // Checksum, see finish.
+        }
+        
+        void finish()
+        {
+            std::uint64_t top_level_checksum = checksum(PROGRAM_CACHE_HEADER_SIZE);
+            std::memcpy(&_out[PROGRAM_CACHE_CHECKSUM_OFFSET], &top_level_checksum, sizeof(top_level_checksum));
+        }
+        
+        void put_statement(vanilla::statement_node* n)
+        {
+            // Expression statements forward accept() to their expression and
+            // deferred bodies to their content, so resolve them up front.
+            if(auto lazy = dynamic_cast<vanilla::lazy_statement_node*>(n))
+                n = lazy->get_body();
+            else if(auto cached = dynamic_cast<vanilla::cached_statement_node*>(n))
+                n = cached->get_body();
+            
+            if(auto e = dynamic_cast<vanilla::expression_statement_node*>(n))
+            {
+                put_node(node_tag::expression_statement, n);
+                e->get_expression()->accept(this);
+                return;
+            }
+            
+            n->accept(this);
+        }
+        
+        // Nullary expressions.
+        virtual void visit(vanilla::variable_expression_node* n) override
+        {
+            put_node(node_tag::variable, n);
+            put_string(n->get_name());
+        }
+        
+        virtual void visit(vanilla::int_expression_node* n) override
+        {
+            put_node(node_tag::int_, n);
+            
+            mpz_t& mpz = n->get_value().mpz();
+            std::string magnitude((mpz_sizeinbase(mpz, 2) + CHAR_BIT - 1) / CHAR_BIT, '\0');
+            std::size_t count = 0;
+            mpz_export(&magnitude[0], &count, -1, 1, 0, 0, mpz);
+            magnitude.resize(count);
+            
+            put_u8(mpz_sgn(mpz) < 0 ? 1 : 0);
+            put_string(magnitude);
+        }
+        
+        virtual void visit(vanilla::float_expression_node* n) override
+        {
+            put_node(node_tag::float_, n);
+            
+            // Hexadecimal digits represent the value exactly.
+            mp_exp_t exp;
+            char* digits = mpf_get_str(nullptr, &exp, 16, 0, n->get_value().mpf());
+            put_i64(exp);
+            put_string(digits);
+            
+            void (*free_func)(void*, std::size_t);
+            mp_get_memory_functions(nullptr, nullptr, &free_func);
+            free_func(digits, std::strlen(digits) + 1);
+        }
+        
+        virtual void visit(vanilla::string_expression_node* n) override
+        {
+            put_node(node_tag::string, n);
+            put_string(n->get_value());
+        }
+        
+        virtual void visit(vanilla::bool_expression_node* n) override
+        {
+            put_node(node_tag::bool_, n);
+            vanilla::bool_object::bool_type v = n->get_value();
+            put_u8(v ? 1 : (!v ? 0 : 2));
+        }
+        
+        virtual void visit(vanilla::array_expression_node* n) override
+        {
+            put_node(node_tag::array, n);
+            put_u32(n->values().size());
+            for(auto& value : n->values())
+                value->accept(this);
+        }
+        
+        virtual void visit(vanilla::dict_expression_node* n) override
+        {
+            put_node(node_tag::dict, n);
+            put_u32(n->keys().size());
+            for(auto& key : n->keys())
+                key->accept(this);
+            put_u32(n->values().size());
+            for(auto& value : n->values())
+                value->accept(this);
+        }
+        
+        // Unary expressions.
+        virtual void visit(vanilla::negation_expression_node* n) override
+        {
+            put_node(node_tag::negation, n);
+            n->get_child()->accept(this);
+        }
+        
+        virtual void visit(vanilla::abs_expression_node* n) override
+        {
+            put_node(node_tag::abs, n);
+            n->get_child()->accept(this);
+        }
+        
+        // Binary expressions.
+        virtual void visit(vanilla::addition_expression_node* n) override
+        {
+            put_binary(node_tag::addition, n);
+        }
+        
+        virtual void visit(vanilla::subtraction_expression_node* n) override
+        {
+            put_binary(node_tag::subtraction, n);
+        }
+        
+        virtual void visit(vanilla::multiplication_expression_node* n) override
+        {
+            put_binary(node_tag::multiplication, n);
+        }
+        
+        virtual void visit(vanilla::division_expression_node* n) override
+        {
+            put_binary(node_tag::division, n);
+        }
+        
+        virtual void visit(vanilla::concatenation_expression_node* n) override
+        {
+            put_binary(node_tag::concatenation, n);
+        }
+        
+        virtual void visit(vanilla::lessthan_expression_node* n) override
+        {
+            put_binary(node_tag::lessthan, n);
+        }
+        
+        virtual void visit(vanilla::lessequal_expression_node* n) override
+        {
+            put_binary(node_tag::lessequal, n);
+        }
+        
+        virtual void visit(vanilla::greaterthan_expression_node* n) override
+        {
+            put_binary(node_tag::greaterthan, n);
+        }
+        
+        virtual void visit(vanilla::greaterequal_expression_node* n) override
+        {
+            put_binary(node_tag::greaterequal, n);
+        }
+        
+        virtual void visit(vanilla::equality_expression_node* n) override
+        {
+            put_binary(node_tag::equality, n);
+        }
+        
+        virtual void visit(vanilla::inequality_expression_node* n) override
+        {
+            put_binary(node_tag::inequality, n);
+        }
+        
+        // Function expressions.
+        virtual void visit(vanilla::function_call_expression_node* n) override
+        {
+            put_node(node_tag::function_call, n);
+            n->get_function()->accept(this);
+            put_u32(n->get_args().size());
+            for(auto& cur : n->get_args())
+                cur->accept(this);
+        }
+        
+        virtual void visit(vanilla::function_definition_expression_node* n) override
+        {
+            put_node(node_tag::function_definition_expression, n);
+            put_string(n->get_name());
+            put_arguments(n->get_arguments());
+            put_body(n->get_body());
+        }
+        
+        virtual void visit(vanilla::native_function_definition_expression_node* n) override
+        {
+            put_node(node_tag::native_function_definition, n);
+            put_string(n->get_library());
+            put_string(n->get_name());
+            put_string(n->get_return_type());
+            put_u32(n->get_argument_types().size());
+            for(std::string const& cur : n->get_argument_types())
+                put_string(cur);
+        }
+        
+        // Other expressions.
+        virtual void visit(vanilla::conditional_expression_node* n) override
+        {
+            put_node(node_tag::conditional, n);
+            n->get_condition()->accept(this);
+            n->get_expression()->accept(this);
+            n->get_else()->accept(this);
+        }
+        
+        virtual void visit(vanilla::subscript_expression_node* n) override
+        {
+            put_node(node_tag::subscript, n);
+            n->get_expression()->accept(this);
+            n->get_subscript()->accept(this);
+        }
+        
+        virtual void visit(vanilla::element_selection_expression_node* n) override
+        {
+            put_node(node_tag::element_selection, n);
+            n->get_left()->accept(this);
+            put_string(n->get_element_name());
+        }
+    
+        // Statements.
+        virtual void visit(vanilla::return_statement_node* n) override
+        {
+            put_node(node_tag::return_, n);
+            n->get_expression()->accept(this);
+        }
+        
+        virtual void visit(vanilla::statement_sequence_node* n) override
+        {
+            put_node(node_tag::statement_sequence, n);
+            put_u32(n->get_code().size());
+            for(vanilla::statement_node::ptr const& cur : n->get_code())
+                put_statement(cur.get());
+        }
+        
+        virtual void visit(vanilla::if_statement_node* n) override
+        {
+            put_node(node_tag::if_, n);
+            put_u32(n->get_ifs().size());
+            for(auto const& cur : n->get_ifs())
+            {
+                cur.first->accept(this);
+                put_statement(cur.second.get());
+            }
+            
+            put_u8(n->get_else() ? 1 : 0);
+            if(n->get_else())
+                put_statement(n->get_else());
+        }
+        
+        virtual void visit(vanilla::while_statement_node* n) override
+        {
+            put_node(node_tag::while_, n);
+            n->get_condition()->accept(this);
+            put_statement(n->get_code());
+        }
+        
+        virtual void visit(vanilla::function_definition_statement_node* n) override
+        {
+            put_node(node_tag::function_definition_statement, n);
+            put_string(n->get_name());
+            put_arguments(n->get_arguments());
+            put_body(n->get_body());
+        }
+        
+        virtual void visit(vanilla::assignment_statement_node* n) override
+        {
+            put_node(node_tag::assignment, n);
+            n->get_left()->accept(this);
+            n->get_right()->accept(this);
+        }
+    };
+    
+    ///////////////////////////////////////////////////////////////////////
+    // Reader.
+    ///////////////////////////////////////////////////////////////////////
+    
+    class program_reader
+    {
+    private:
+        std::shared_ptr<vanilla::detail::mapped_file> const& _file;
+        char const* _cur;
+        char const* _end;
+        std::uint64_t _checksum;    // Of what was read, the skipped bodies left out.
+        
+        void get_raw(void* p, std::size_t n)
+        {
+            if(std::size_t(_end - _cur) < n)
+                throw_malformed("unexpected end of program cache");
+            std::memcpy(p, _cur, n);
+            _checksum = fnv1a(_checksum, _cur, n);
+            _cur += n;
+        }
+        
+        std::uint8_t get_u8()
+        {
+            std::uint8_t v;
+            get_raw(&v, sizeof(v));
+            return v;
+        }
+        
+        std::uint32_t get_u32()
+        {
+            std::uint32_t v;
+            get_raw(&v, sizeof(v));
+            return v;
+        }
+        
+        std::int64_t get_i64()
+        {
+            std::int64_t v;
+            get_raw(&v, sizeof(v));
+            return v;
+        }
+        
+        vanilla::cstr_range get_bytes()
+        {
+            std::uint32_t length = get_u32();
+            if(std::size_t(_end - _cur) < length)
+                throw_malformed("unexpected end of program cache");
+            
+            vanilla::cstr_range result(_cur, _cur + length);
+            _checksum = fnv1a(_checksum, _cur, length);
+            _cur += length;
+            return result;
+        }
+        
+        std::string get_string()
+        {
+            vanilla::cstr_range bytes = get_bytes();
+            return std::string(bytes.begin(), bytes.end());
+        }
+        
+        std::vector<vanilla::expression_node::ptr> get_expressions()
+        {
+            std::uint32_t count = get_u32();
+            std::vector<vanilla::expression_node::ptr> result;
+            result.reserve(std::min<std::size_t>(count, _end - _cur));
+            for(std::uint32_t i = 0; i < count; ++i)
+                result.push_back(get_expression());
+            return result;
+        }
+        
+        std::vector<std::pair<std::string, vanilla::expression_node::ptr>> get_arguments()
+        {
+            std::uint32_t count = get_u32();
+            std::vector<std::pair<std::string, vanilla::expression_node::ptr>> result;
+            for(std::uint32_t i = 0; i < count; ++i)
+            {
+                std::string name = get_string();
+                vanilla::expression_node::ptr default_expression;
+                if(get_u8())
+                    default_expression = get_expression();
+                result.emplace_back(std::move(name), std::move(default_expression));
+            }
+            
+            return result;
+        }
+        
+        std::shared_ptr<vanilla::statement_node> get_body(unsigned line, unsigned pos)
+        {
+            std::uint32_t length = get_u32();
+            std::uint64_t checksum;
+            get_raw(&checksum, sizeof(checksum));
+            if(std::size_t(_end - _cur) < length)
+                throw_malformed("unexpected end of program cache");
+            
+            std::size_t offset = _cur - _file->data();
+            _cur += length;
+            return std::make_shared<vanilla::cached_statement_node>(
+                line, pos, _file, offset, length, checksum);
+        }
+        
+        template<typename Node>
+        vanilla::expression_node::ptr get_binary(unsigned line, unsigned pos)
+        {
+            vanilla::expression_node::ptr left = get_expression();
+            vanilla::expression_node::ptr right = get_expression();
+            return make_unique<Node>(line, pos, std::move(left), std::move(right));
+        }
+        
+    public:
+        program_reader(std::shared_ptr<vanilla::detail::mapped_file> const& file,
+            std::size_t offset, std::size_t length)
+            :   _file(file),
+                _cur(file->data() + offset),
+                _end(file->data() + offset + length),
+                _checksum(FNV_OFFSET_BASIS)
+        { }
+        
+        // Once everything was read.
+        void check_end(std::uint64_t checksum) const
+        {
+            if(_cur != _end)
+                throw_malformed("trailing data in program cache");
+            if(_checksum != checksum)
+                throw_malformed("program cache checksum mismatch");
+        }
+        
+        // Returns the checksum of the top level.
+        std::uint64_t check_header(std::uint64_t source_hash)
+        {
+            char magic[sizeof(PROGRAM_CACHE_MAGIC)];
+            get_raw(magic, sizeof(magic));
+            if(std::memcmp(magic, PROGRAM_CACHE_MAGIC, sizeof(magic)) != 0)
+                throw_malformed("not a program cache");
+            if(get_u32() != vanilla::PROGRAM_CACHE_VERSION)
+                throw_malformed("program cache version mismatch");
+            if(get_u32() != PROGRAM_CACHE_BYTE_ORDER)
+                throw_malformed("program cache byte order mismatch");
+            get_u32(); // Reserved.
+            
+            std::uint64_t hash;
+            get_raw(&hash, sizeof(hash));
+            if(hash != source_hash)
+                throw_malformed("program cache is out of date");
+            
+            // What follows is checked as it is read.
+            std::uint64_t checksum;
+            get_raw(&checksum, sizeof(checksum));
+            _checksum = FNV_OFFSET_BASIS;
+            return checksum;
+        }
+        
+        vanilla::expression_node::ptr get_expression()
+        {
+            node_tag tag = static_cast<node_tag>(get_u8());
+            unsigned line = get_u32();
+            unsigned pos = get_u32();
+            
+            switch(tag)
+            {
+                case node_tag::variable:
+                    return make_unique<vanilla::variable_expression_node>(line, pos, get_string());
+                
+                case node_tag::int_:
+                {
+                    bool negative = get_u8() != 0;
+                    vanilla::cstr_range magnitude = get_bytes();
+                    vanilla::int_object::int_type v;
+                    mpz_import(v.mpz(), magnitude.length(), -1, 1, 0, 0, magnitude.begin());
+                    if(negative)
+                        mpz_neg(v.mpz(), v.mpz());
+                    return make_unique<vanilla::int_expression_node>(line, pos, std::move(v));
+                }
+                
+                case node_tag::float_:
+                {
+                    std::int64_t exp = get_i64();
+                    std::string digits = get_string();
+                    
+                    // A negative base means the exponent is given in decimal.
+                    std::string text;
+                    if(!digits.empty() && digits[0] == '-')
+                        text = "-0." + digits.substr(1);
+                    else
+                        text = "0." + digits;
+                    text += '@';
+                    text += std::to_string(exp);
+                    
+                    vanilla::float_object::float_type v;
+                    if(!digits.empty() && mpf_set_str(v.mpf(), text.c_str(), -16) != 0)
+                        throw_malformed("invalid float literal in program cache");
+                    return make_unique<vanilla::float_expression_node>(line, pos, std::move(v));
+                }
+                
+                case node_tag::string:
+                    return make_unique<vanilla::string_expression_node>(line, pos, get_string());
+                
+                case node_tag::bool_:
+                {
+                    std::uint8_t v = get_u8();
+                    vanilla::bool_object::bool_type b = boost::logic::indeterminate;
+                    if(v != 2)
+                        b = v != 0;
+                    return make_unique<vanilla::bool_expression_node>(line, pos, b);
+                }
+                
+                case node_tag::array:
+                    return make_unique<vanilla::array_expression_node>(line, pos, get_expressions());
+                
+                case node_tag::dict:
+                {
+                    std::vector<vanilla::expression_node::ptr> keys = get_expressions();
+                    std::vector<vanilla::expression_node::ptr> values = get_expressions();
+                    if(keys.size() != values.size())
+                        throw_malformed("dict literal with unpaired keys in program cache");
+                    return make_unique<vanilla::dict_expression_node>(line, pos, std::move(keys), std::move(values));
+                }
+                
+                case node_tag::negation:
+                    return make_unique<vanilla::negation_expression_node>(line, pos, get_expression());
+                
+                case node_tag::abs:
+                    return make_unique<vanilla::abs_expression_node>(line, pos, get_expression());
+                    
+                case node_tag::addition:
+                    return get_binary<vanilla::addition_expression_node>(line, pos);
+                case node_tag::subtraction:
+                    return get_binary<vanilla::subtraction_expression_node>(line, pos);
+                case node_tag::multiplication:
+                    return get_binary<vanilla::multiplication_expression_node>(line, pos);
+                case node_tag::division:
+                    return get_binary<vanilla::division_expression_node>(line, pos);
+                case node_tag::concatenation:
+                    return get_binary<vanilla::concatenation_expression_node>(line, pos);
+                case node_tag::lessthan:
+                    return get_binary<vanilla::lessthan_expression_node>(line, pos);
+                case node_tag::lessequal:
+                    return get_binary<vanilla::lessequal_expression_node>(line, pos);
+                case node_tag::greaterthan:
+                    return get_binary<vanilla::greaterthan_expression_node>(line, pos);
+                case node_tag::greaterequal:
+                    return get_binary<vanilla::greaterequal_expression_node>(line, pos);
+                case node_tag::equality:
+                    return get_binary<vanilla::equality_expression_node>(line, pos);
+                case node_tag::inequality:
+                    return get_binary<vanilla::inequality_expression_node>(line, pos);
+                
+                case node_tag::function_call:
+                {
+                    vanilla::expression_node::ptr function = get_expression();
+                    return make_unique<vanilla::function_call_expression_node>(
+                        line, pos, std::move(function), get_expressions());
+                }
+                
+                case node_tag::function_definition_expression:
+                {
+                    std::string name = get_string();
+                    auto arguments = get_arguments();
+                    return make_unique<vanilla::function_definition_expression_node>(
+                        line, pos, std::move(name), std::move(arguments), get_body(line, pos));
+                }
+                
+                case node_tag::native_function_definition:
+                {
+                    std::string library = get_string();
+                    std::string name = get_string();
+                    std::string return_type = get_string();
+                    std::uint32_t count = get_u32();
+                    std::vector<std::string> argument_types;
+                    for(std::uint32_t i = 0; i < count; ++i)
+                        argument_types.push_back(get_string());
+                    return make_unique<vanilla::native_function_definition_expression_node>(
+                        line, pos, std::move(library), std::move(name),
+                        std::move(return_type), std::move(argument_types));
+                }
+                
+                case node_tag::conditional:
+                {
+                    vanilla::expression_node::ptr condition = get_expression();
+                    vanilla::expression_node::ptr expr = get_expression();
+                    vanilla::expression_node::ptr else_ = get_expression();
+                    return make_unique<vanilla::conditional_expression_node>(
+                        line, pos, std::move(condition), std::move(expr), std::move(else_));
+                }
+                
+                case node_tag::subscript:
+                {
+                    vanilla::expression_node::ptr expr = get_expression();
+                    vanilla::expression_node::ptr subscript = get_expression();
+                    return make_unique<vanilla::subscript_expression_node>(
+                        line, pos, std::move(expr), std::move(subscript));
+                }
+                
+                case node_tag::element_selection:
+                {
+                    vanilla::expression_node::ptr left = get_expression();
+                    return make_unique<vanilla::element_selection_expression_node>(
+                        line, pos, std::move(left), get_string());
+                }
+                
+                default:
+                    throw_malformed("invalid expression in program cache");
+            }
+            
+            assert(false);
+            std::terminate();
+        }
+        
+        // The content of a body written by program_writer::put_body, which
+        // has to pass its checksum before its source is parsed.
+        vanilla::statement_node::ptr get_function_body(std::uint64_t checksum)
+        {
+            switch(static_cast<body_kind>(get_u8()))
+            {
+                case body_kind::ast:
+                {
+                    vanilla::statement_node::ptr body = get_statement();
+                    check_end(checksum);
+                    return body;
+                }
+                
+                case body_kind::source:
+                {
+                    unsigned line = get_u32();
+                    unsigned pos = get_u32();
+                    std::string text = get_string();
+                    check_end(checksum);
+                    return vanilla::parse_body(std::move(text), line, pos);
+                }
+                
+                default:
+                    throw_malformed("invalid function body in program cache");
+            }
+            
+            assert(false);
+            std::terminate();
+        }
+        
+        vanilla::statement_node::ptr get_statement()
+        {
+            node_tag tag = static_cast<node_tag>(get_u8());
+            unsigned line = get_u32();
+            unsigned pos = get_u32();
+            
+            switch(tag)
+            {
+                case node_tag::expression_statement:
+                    return make_unique<vanilla::expression_statement_node>(
+                        line, pos, get_expression());
+                
+                case node_tag::return_:
+                    return make_unique<vanilla::return_statement_node>(
+                        line, pos, get_expression());
+                
+                case node_tag::statement_sequence:
+                {
+                    std::uint32_t count = get_u32();
+                    std::vector<vanilla::statement_node::ptr> code;
+                    code.reserve(std::min<std::size_t>(count, _end - _cur));
+                    for(std::uint32_t i = 0; i < count; ++i)
+                        code.push_back(get_statement());
+                    return make_unique<vanilla::statement_sequence_node>(
+                        line, pos, std::move(code));
+                }
+                
+                case node_tag::if_:
+                {
+                    std::uint32_t count = get_u32();
+                    std::vector<std::pair<vanilla::expression_node::ptr,
+                        vanilla::statement_node::ptr>> ifs;
+                    for(std::uint32_t i = 0; i < count; ++i)
+                    {
+                        vanilla::expression_node::ptr condition = get_expression();
+                        vanilla::statement_node::ptr code = get_statement();
+                        ifs.emplace_back(std::move(condition), std::move(code));
+                    }
+                    
+                    vanilla::statement_node::ptr else_;
+                    if(get_u8())
+                        else_ = get_statement();
+                    return make_unique<vanilla::if_statement_node>(
+                        line, pos, std::move(ifs), std::move(else_));
+                }
+                
+                case node_tag::while_:
+                {
+                    vanilla::expression_node::ptr condition = get_expression();
+                    return make_unique<vanilla::while_statement_node>(
+                        line, pos, std::move(condition), get_statement());
+                }
+                
+                case node_tag::function_definition_statement:
+                {
+                    std::string name = get_string();
+                    auto arguments = get_arguments();
+                    return make_unique<vanilla::function_definition_statement_node>(
+                        line, pos, std::move(name), std::move(arguments), get_body(line, pos));
+                }
+                
+                case node_tag::assignment:
+                {
+                    vanilla::expression_node::ptr lhs = get_expression();
+                    return make_unique<vanilla::assignment_statement_node>(
+                        line, pos, std::move(lhs), get_expression());
+                }
+                
+                default:
+                    throw_malformed("invalid statement in program cache");
+            }
+            
+            assert(false);
+            std::terminate();
+        }
+    };
+    
+    std::string read_file(char const* filename)
+    {
+        std::ifstream in( (filename) );
+        return std::string( (std::istreambuf_iterator<char>(in)) , std::istreambuf_iterator<char>());
+    }
+    
+    // Like mkdir -p, errors are detected when writing into the directory.
+    void create_directories(std::string const& path)
+    {
+        for(std::size_t i = 1; i <= path.size(); ++i)
+        {
+            if(i == path.size() || path[i] == '/')
+                ::mkdir(path.substr(0, i).c_str(), 0755);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::detail::mapped_file
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::detail::mapped_file::mapped_file(char const* filename)
+    :   _data(nullptr), _size(0)
+{
+    int fd = ::open(filename, O_RDONLY);
+    if(fd == -1)
+        throw_malformed("can't open program cache");
+    
+    struct stat info;
+    if(::fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        ::close(fd);
+        throw_malformed("can't open program cache");
+    }
+    
+    void* data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED)
+        throw_malformed("can't map program cache");
+    
+    _data = data;
+    _size = info.st_size;
+}
+
+vanilla::detail::mapped_file::~mapped_file()
+{
+    ::munmap(_data, _size);
+}
+
+char const* vanilla::detail::mapped_file::data() const
+{
+    return static_cast<char const*>(_data);
+}
+
+std::size_t vanilla::detail::mapped_file::size() const
+{
+    return _size;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::cached_statement_node
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::cached_statement_node::cached_statement_node(
+            unsigned line,
+            unsigned pos,
+            std::shared_ptr<detail::mapped_file> file,
+            std::size_t offset,
+            std::size_t length,
+            std::uint64_t checksum )
+    :   statement_node(line, pos),
+        _file(std::move(file)),
+        _offset(offset),
+        _length(length),
+        _checksum(checksum),
+        _body()
+{ }
+
+bool vanilla::cached_statement_node::is_loaded() const
+{
+    return bool(_body);
+}
+
+vanilla::cstr_range vanilla::cached_statement_node::get_data() const
+{
+    assert(!is_loaded());
+    return cstr_range(_file->data() + _offset, _file->data() + _offset + _length);
+}
+
+std::uint64_t vanilla::cached_statement_node::get_checksum() const
+{
+    assert(!is_loaded());
+    return _checksum;
+}
+
+vanilla::statement_node* vanilla::cached_statement_node::get_body()
+{
+    if(!_body)
+    {
+        program_reader reader(_file, _offset, _length);
+        _body = reader.get_function_body(_checksum);
+        _file.reset();
+    }
+    
+    return _body.get();
+}
+
+void vanilla::cached_statement_node::eval(context& c)
+{
+    get_body()->eval(c);
+}
+
+void vanilla::cached_statement_node::accept(ast_visitor* v)
+{
+    get_body()->accept(v);
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::program_cache
+///////////////////////////////////////////////////////////////////////////
+
+std::string vanilla::program_cache::cache_filename(std::string const& source_path) const
+{
+    std::string path = source_path;
+    if(char* resolved = ::realpath(source_path.c_str(), nullptr))
+    {
+        path = resolved;
+        std::free(resolved);
+    }
+    
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.vnlc",
+        static_cast<unsigned long long>(hash_source(path.data(), path.size())));
+    return _directory + '/' + name;
+}
+
+vanilla::program_cache::program_cache(std::string directory)
+    :   _directory(std::move(directory))
+{ }
+
+std::string vanilla::program_cache::default_directory()
+{
+    if(char const* dir = std::getenv("VANILLA_CACHE_DIR"))
+        return dir;
+    if(char const* dir = std::getenv("XDG_CACHE_HOME"))
+        return std::string(dir) + "/vanilla";
+    if(char const* dir = std::getenv("HOME"))
+        return std::string(dir) + "/.cache/vanilla";
+    return std::string();
+}
+
+std::string const& vanilla::program_cache::directory() const
+{
+    return _directory;
+}
+
+vanilla::statement_node::ptr vanilla::program_cache::load(char const* filename)
+{
+    std::string text = read_file(filename);
+    std::uint64_t source_hash = hash_source(text.data(), text.size());
+    
+    if(_directory.empty())
+        return parse_source(std::move(text));
+    
+    std::string cache_name = cache_filename(filename);
+    try
+    {
+        return read_program(std::make_shared<detail::mapped_file>(cache_name.c_str()),
+            source_hash);
+    }
+    catch(error::program_cache_error&)
+    {
+        // Missing or stale - parse and refresh the entry below.
+    }
+    
+    statement_node::ptr program = parse_source(std::move(text));
+    
+    // Write to a temporary file first so that concurrent runs never see a
+    // partially written entry. Failing to store the entry is not an error.
+    create_directories(_directory);
+    std::string temp_name = cache_name + '.' + std::to_string(::getpid());
+    {
+        std::ofstream out(temp_name, std::ios::binary);
+        if(out)
+            write_program(program.get(), source_hash, out);
+        if(!out)
+        {
+            std::remove(temp_name.c_str());
+            return program;
+        }
+    }
+    
+    if(std::rename(temp_name.c_str(), cache_name.c_str()) != 0)
+        std::remove(temp_name.c_str());
+    return program;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// FREE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////
+
+std::uint64_t vanilla::hash_source(char const* data, std::size_t length)
+{
+    return fnv1a(FNV_OFFSET_BASIS, data, length);
+}
+
+void vanilla::write_program(statement_node* program, std::uint64_t source_hash, std::ostream& o)
+{
+    std::string buffer;
+    program_writer writer(buffer);
+    writer.put_header(source_hash);
+    writer.put_statement(program);
+    writer.finish();
+    o.write(buffer.data(), buffer.size());
+}
+
+vanilla::statement_node::ptr vanilla::read_program(
+    std::shared_ptr<detail::mapped_file> file, std::uint64_t source_hash)
+{
+    program_reader reader(file, 0, file->size());
+    std::uint64_t checksum = reader.check_header(source_hash);
+    statement_node::ptr program = reader.get_statement();
+    reader.check_end(checksum);
+    return program;
+}
@@ -0,0 +1,210 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <iterator>
+#include <vector>
+
+// Vanilla:
+#include <vanilla/reclaimer.hpp>
+#include <vanilla/object.hpp>
+
+namespace
+{
+    typedef std::vector<vanilla::object::ptr> reference_list;
+    
+    struct release_queue
+    {
+        reference_list containers;
+        bool draining;
+        bool background;
+        
+        release_queue()
+            : containers(), draining(false), background(false)
+        { }
+    };
+    
+    thread_local release_queue local_queue;
+    
+    std::size_t budget = 0;
+    
+    std::atomic<std::uint64_t> containers_queued(0);
+    std::atomic<std::uint64_t> containers_deferred(0);
+    std::atomic<std::uint64_t> batches_handed_off(0);
+    
+    // Never destroyed, containers may still die during static destruction.
+    struct background_state
+    {
+        std::mutex lock;
+        std::condition_variable wakeup;
+        std::deque<reference_list> batches;
+        std::thread worker;
+        bool running;
+        bool stopping;
+    };
+    
+    background_state& background()
+    {
+        static background_state* s = new background_state();
+        return *s;
+    }
+    
+    // Destroys queued containers until the queue is empty or the limit (0:
+    // none) is reached. Containers dying meanwhile are queued by release(),
+    // since the queue is draining.
+    void drain_queue(release_queue& q, std::size_t limit)
+    {
+        q.draining = true;
+        for(std::size_t n = 0; !q.containers.empty() && (limit == 0 || n < limit); ++n)
+        {
+            vanilla::object::ptr o = std::move(q.containers.back());
+            q.containers.pop_back();
+            o.reset();
+        }
+        q.draining = false;
+        
+        if(!q.background)
+        {
+            containers_deferred += q.containers.size() != 0;
+            vanilla::reclaimer::detail::deferred = !q.containers.empty();
+        }
+    }
+    
+    void run_background()
+    {
+        background_state& s = background();
+        local_queue.background = true;
+        
+        std::unique_lock<std::mutex> lock(s.lock);
+        for(;;)
+        {
+            s.wakeup.wait(lock, [&]() { return s.stopping || !s.batches.empty(); });
+            if(s.batches.empty())
+                break;
+            
+            reference_list batch = std::move(s.batches.front());
+            s.batches.pop_front();
+            lock.unlock();
+            vanilla::reclaimer::release(batch.data(), batch.size());
+            lock.lock();
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::reclaimer::detail
+///////////////////////////////////////////////////////////////////////////
+
+bool vanilla::reclaimer::detail::deferred = false;
+
+void vanilla::reclaimer::detail::drain()
+{
+    release_queue& q = local_queue;
+    if(!q.draining)
+        drain_queue(q, budget);
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// FREE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////
+
+void vanilla::reclaimer::release(object::ptr* references, std::size_t count)
+{
+    release_queue& q = local_queue;
+    
+    // Moving the references costs no reference count changes.
+    if(count >= BACKGROUND_THRESHOLD && !q.background && !alloc_stats::detail::active)
+    {
+        background_state& s = background();
+        std::lock_guard<std::mutex> lock(s.lock);
+        if(s.running)
+        {
+            s.batches.emplace_back(std::make_move_iterator(references),
+                std::make_move_iterator(references + count));
+            ++batches_handed_off;
+            s.wakeup.notify_one();
+            return;
+        }
+    }
+    
+    // Anything but a dying container is released right here, that doesn't
+    // recurse.
+    std::size_t queued = 0;
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        object::ptr& cur = references[i];
+        if(cur && cur.use_count() == 1 && cur->is_container())
+        {
+            q.containers.push_back(std::move(cur));
+            ++queued;
+        }
+        else
+            cur.reset();
+    }
+    containers_queued += queued;
+    
+    if(!q.draining && !q.containers.empty())
+        drain_queue(q, q.background ? 0 : budget);
+}
+
+void vanilla::reclaimer::set_budget(std::size_t containers_per_safepoint)
+{
+    budget = containers_per_safepoint;
+}
+
+void vanilla::reclaimer::start_background()
+{
+    background_state& s = background();
+    std::lock_guard<std::mutex> lock(s.lock);
+    if(s.running)
+        return;
+    s.stopping = false;
+    s.running = true;
+    s.worker = std::thread(run_background);
+}
+
+void vanilla::reclaimer::stop_background()
+{
+    background_state& s = background();
+    {
+        std::lock_guard<std::mutex> lock(s.lock);
+        if(!s.running)
+            return;
+        s.running = false;
+        s.stopping = true;
+        s.wakeup.notify_one();
+    }
+    s.worker.join();
+}
+
+vanilla::reclaimer::statistics vanilla::reclaimer::get_statistics()
+{
+    statistics result;
+    result.containers_queued = containers_queued;
+    result.containers_deferred = containers_deferred;
+    result.batches_handed_off = batches_handed_off;
+    return result;
+}
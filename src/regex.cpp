@@ -0,0 +1,1163 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Vanilla:
+#include <vanilla/regex.hpp>
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::detail::regex_program
+///////////////////////////////////////////////////////////////////////////
+
+namespace vanilla
+{
+    namespace detail
+    {
+        struct regex_program
+        {
+            enum class opcode : std::uint8_t
+            {
+                byte_class,     // Consumes a byte of classes[x], goes on at the next instruction.
+                split,          // Goes on at x, or with lower priority at y.
+                jump,           // Goes on at x.
+                assert_begin,
+                assert_end,
+                match
+            };
+            
+            struct instruction
+            {
+                opcode op;
+                unsigned x;
+                unsigned y;
+            };
+            
+            std::vector<instruction> code;
+            std::vector<std::bitset<256>> classes;
+            
+            // Bytes that no class tells apart share an equivalence class;
+            // DFA transitions are per equivalence class.
+            std::uint8_t equivalence_classes[256];
+            unsigned equivalence_class_count;
+            
+            // The unanchored entry skips any number of bytes, with lower
+            // priority than the body, before going on at the body.
+            unsigned unanchored_entry;
+            unsigned body;
+        };
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// UTILITY
+///////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    using vanilla::detail::regex_program;
+    typedef regex_program::opcode opcode;
+    typedef std::bitset<256> byte_set;
+    
+    // Code point ranges, not necessarily sorted or disjoint.
+    typedef std::vector<std::pair<char32_t, char32_t>> char_set;
+    
+    unsigned const UNBOUNDED = unsigned(-1);
+    char32_t const MAX_CHARACTER = 0x10FFFF;
+    char32_t const FIRST_SURROGATE = 0xD800;
+    char32_t const LAST_SURROGATE = 0xDFFF;
+    
+    [[noreturn]] void invalid_regex(vanilla::cstr_range pattern, char const* reason)
+    {
+        BOOST_THROW_EXCEPTION(vanilla::error::invalid_regex_error()
+            << vanilla::error::regex_pattern(std::string(pattern.begin(), pattern.end()))
+            << vanilla::error::error_string(reason));
+    }
+    
+    struct node
+    {
+        enum class kind
+        {
+            empty,
+            byte_class,
+            concatenation,
+            alternation,
+            repetition,
+            text_begin,
+            text_end
+        };
+        
+        kind k;
+        byte_set bytes;
+        std::vector<node> children;
+        unsigned min;
+        unsigned max;
+        bool greedy;
+        
+        explicit node(kind k)
+            : k(k), min(0), max(0), greedy(true)
+        { }
+    };
+    
+    byte_set range(unsigned char first, unsigned char last)
+    {
+        byte_set result;
+        for(unsigned c = first; c <= last; ++c)
+            result.set(c);
+        return result;
+    }
+    
+    char_set word_characters()
+    {
+        return char_set{ { 'a', 'z' }, { 'A', 'Z' }, { '0', '9' }, { '_', '_' } };
+    }
+    
+    char_set space_characters()
+    {
+        return char_set{ { '\t', '\r' }, { ' ', ' ' } };
+    }
+    
+    // Sorted, disjoint and not adjacent.
+    char_set normalized(char_set s)
+    {
+        std::sort(s.begin(), s.end());
+        char_set result;
+        for(auto const& r : s)
+        {
+            if(!result.empty() && r.first <= result.back().second + 1)
+                result.back().second = std::max(result.back().second, r.second);
+            else
+                result.push_back(r);
+        }
+        return result;
+    }
+    
+    // The characters that aren't in s; surrogates are no characters.
+    char_set negated(char_set s)
+    {
+        s.emplace_back(FIRST_SURROGATE, LAST_SURROGATE);
+        char_set result;
+        char32_t next = 0;
+        for(auto const& r : normalized(std::move(s)))
+        {
+            if(r.first > next)
+                result.emplace_back(next, r.first - 1);
+            next = r.second + 1;
+        }
+        if(next <= MAX_CHARACTER)
+            result.emplace_back(next, MAX_CHARACTER);
+        return result;
+    }
+    
+    unsigned encode(char32_t c, unsigned char* out)
+    {
+        if(c < 0x80)
+        {
+            out[0] = c;
+            return 1;
+        }
+        if(c < 0x800)
+        {
+            out[0] = 0xC0 | (c >> 6);
+            out[1] = 0x80 | (c & 0x3F);
+            return 2;
+        }
+        if(c < 0x10000)
+        {
+            out[0] = 0xE0 | (c >> 12);
+            out[1] = 0x80 | ((c >> 6) & 0x3F);
+            out[2] = 0x80 | (c & 0x3F);
+            return 3;
+        }
+        out[0] = 0xF0 | (c >> 18);
+        out[1] = 0x80 | ((c >> 12) & 0x3F);
+        out[2] = 0x80 | ((c >> 6) & 0x3F);
+        out[3] = 0x80 | (c & 0x3F);
+        return 4;
+    }
+    
+    // Appends the byte sequences of the UTF-8 encodings of first to last,
+    // which mustn't contain surrogates, as concatenations of byte classes.
+    // The range is split until the encodings of all its characters have
+    // the same length and each byte takes every value between those of
+    // first and last.
+    void append_sequences(char32_t first, char32_t last, std::vector<node>& out)
+    {
+        for(char32_t limit : { char32_t(0x7F), char32_t(0x7FF), char32_t(0xFFFF) })
+        {
+            if(first <= limit && last > limit)
+            {
+                append_sequences(first, limit, out);
+                append_sequences(limit + 1, last, out);
+                return;
+            }
+        }
+        
+        for(unsigned i = 1; i < 4; ++i)
+        {
+            char32_t low_bits = (char32_t(1) << (6 * i)) - 1;
+            if((first & ~low_bits) == (last & ~low_bits))
+                continue;
+            if((first & low_bits) != 0)
+            {
+                append_sequences(first, first | low_bits, out);
+                append_sequences((first | low_bits) + 1, last, out);
+                return;
+            }
+            if((last & low_bits) != low_bits)
+            {
+                append_sequences(first, (last & ~low_bits) - 1, out);
+                append_sequences(last & ~low_bits, last, out);
+                return;
+            }
+        }
+        
+        unsigned char low[4];
+        unsigned char high[4];
+        unsigned n = encode(first, low);
+        encode(last, high);
+        node sequence(node::kind::concatenation);
+        for(unsigned i = 0; i < n; ++i)
+        {
+            sequence.children.emplace_back(node::kind::byte_class);
+            sequence.children.back().bytes = range(low[i], high[i]);
+        }
+        out.push_back(n == 1 ? std::move(sequence.children.front()) : std::move(sequence));
+    }
+    
+    // A node that matches the UTF-8 encoding of any character of s. ASCII
+    // characters share a byte class.
+    node to_node(char_set const& s)
+    {
+        node ascii(node::kind::byte_class);
+        node result(node::kind::alternation);
+        for(auto r : normalized(s))
+        {
+            if(r.first < 0x80)
+            {
+                ascii.bytes |= range(r.first, std::min(r.second, char32_t(0x7F)));
+                if(r.second < 0x80)
+                    continue;
+                r.first = 0x80;
+            }
+            if(r.first < FIRST_SURROGATE && r.second > LAST_SURROGATE)
+            {
+                append_sequences(r.first, FIRST_SURROGATE - 1, result.children);
+                append_sequences(LAST_SURROGATE + 1, r.second, result.children);
+            }
+            else if(r.second < FIRST_SURROGATE || r.first > LAST_SURROGATE)
+                append_sequences(r.first, r.second, result.children);
+            else if(r.first < FIRST_SURROGATE)
+                append_sequences(r.first, FIRST_SURROGATE - 1, result.children);
+            else if(r.second > LAST_SURROGATE)
+                append_sequences(LAST_SURROGATE + 1, r.second, result.children);
+        }
+        
+        // The encodings of different characters don't begin with each
+        // other, so the order of the alternatives doesn't matter.
+        if(ascii.bytes.any() || result.children.empty())
+            result.children.insert(result.children.begin(), std::move(ascii));
+        if(result.children.size() == 1)
+            return std::move(result.children.front());
+        return result;
+    }
+    
+    // Recursive descent, nesting is bounded by MAX_NESTING.
+    class parser
+    {
+    private:
+        vanilla::cstr_range _pattern;
+        char const* _p;
+        std::size_t _depth;
+        
+        bool at_end() const
+        {
+            return _p == _pattern.end();
+        }
+        
+        [[noreturn]] void fail(char const* reason) const
+        {
+            invalid_regex(_pattern, reason);
+        }
+        
+        // Decodes the UTF-8 character at _p and moves past it.
+        char32_t character()
+        {
+            unsigned char c = *_p++;
+            if(c < 0x80)
+                return c;
+            
+            unsigned n = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+            char32_t result = c & (0x3F >> n);
+            if(n == 0 || std::size_t(_pattern.end() - _p) < n)
+                fail("invalid UTF-8");
+            for(unsigned i = 0; i < n; ++i, ++_p)
+            {
+                if((static_cast<unsigned char>(*_p) & 0xC0) != 0x80)
+                    fail("invalid UTF-8");
+                result = result << 6 | (*_p & 0x3F);
+            }
+            
+            // Overlong encodings, surrogates and values out of range.
+            static char32_t const min_value[] = { 0, 0x80, 0x800, 0x10000 };
+            if(result < min_value[n] || result > MAX_CHARACTER
+                || (result >= FIRST_SURROGATE && result <= LAST_SURROGATE))
+                fail("invalid UTF-8");
+            return result;
+        }
+        
+        // After the backslash; false if it isn't a class like \d, then
+        // characters holds the one escaped character.
+        bool class_escape(char_set& characters)
+        {
+            if(at_end())
+                fail("trailing backslash");
+            
+            char c = *_p;
+            switch(c)
+            {
+                case 'd': characters = char_set{ { '0', '9' } }; break;
+                case 'D': characters = negated(char_set{ { '0', '9' } }); break;
+                case 'w': characters = word_characters(); break;
+                case 'W': characters = negated(word_characters()); break;
+                case 's': characters = space_characters(); break;
+                case 'S': characters = negated(space_characters()); break;
+                default:
+                {
+                    char32_t escaped;
+                    switch(c)
+                    {
+                        case 'n': escaped = '\n'; ++_p; break;
+                        case 'r': escaped = '\r'; ++_p; break;
+                        case 't': escaped = '\t'; ++_p; break;
+                        case 'f': escaped = '\f'; ++_p; break;
+                        case 'v': escaped = '\v'; ++_p; break;
+                        case '0': escaped = '\0'; ++_p; break;
+                        default:
+                            // Letters and digits are reserved for escapes
+                            // that may come.
+                            if(std::isalnum(static_cast<unsigned char>(c)))
+                                fail("unknown escape");
+                            escaped = character();
+                            break;
+                    }
+                    characters = char_set{ { escaped, escaped } };
+                    return false;
+                }
+            }
+            ++_p;
+            return true;
+        }
+        
+        // A character or an escape in brackets; true if it's a class like
+        // \d, otherwise characters holds the one character.
+        bool class_item(char_set& characters)
+        {
+            if(*_p == '\\')
+            {
+                ++_p;
+                return class_escape(characters);
+            }
+            char32_t c = character();
+            characters = char_set{ { c, c } };
+            return false;
+        }
+        
+        node bracket_class()
+        {
+            char_set result;
+            bool negate = !at_end() && *_p == '^';
+            if(negate)
+                ++_p;
+            
+            // A ] right at the start is a literal.
+            for(bool first = true; first || at_end() || *_p != ']'; first = false)
+            {
+                if(at_end())
+                    fail("missing ]");
+                
+                char_set characters;
+                if(class_item(characters))
+                {
+                    result.insert(result.end(), characters.begin(), characters.end());
+                    continue;
+                }
+                
+                char32_t low = characters.front().first;
+                char32_t high = low;
+                if(_pattern.end() - _p >= 2 && *_p == '-' && _p[1] != ']')
+                {
+                    ++_p;
+                    if(class_item(characters))
+                        fail("class escape in a range");
+                    high = characters.front().first;
+                    if(high < low)
+                        fail("invalid range");
+                }
+                result.emplace_back(low, high);
+            }
+            
+            ++_p;
+            return to_node(negate ? negated(std::move(result)) : result);
+        }
+        
+        unsigned number()
+        {
+            if(at_end() || !std::isdigit(static_cast<unsigned char>(*_p)))
+                fail("invalid repeat");
+            
+            unsigned result = 0;
+            for(; !at_end() && std::isdigit(static_cast<unsigned char>(*_p)); ++_p)
+            {
+                result = result * 10 + (*_p - '0');
+                if(result > vanilla::regex::MAX_REPEAT)
+                    fail("repeat count too large");
+            }
+            return result;
+        }
+        
+        node atom()
+        {
+            char c = *_p++;
+            switch(c)
+            {
+                case '(':
+                {
+                    if(_pattern.end() - _p >= 2 && _p[0] == '?' && _p[1] == ':')
+                        _p += 2;
+                    node result = alternation();
+                    if(at_end() || *_p != ')')
+                        fail("missing )");
+                    ++_p;
+                    return result;
+                }
+                case '[':
+                    return bracket_class();
+                case '.':
+                    return to_node(negated(char_set{ { '\n', '\n' } }));
+                case '^':
+                    return node(node::kind::text_begin);
+                case '$':
+                    return node(node::kind::text_end);
+                case '*':
+                case '+':
+                case '?':
+                case '{':
+                    fail("nothing to repeat");
+                case '\\':
+                {
+                    char_set characters;
+                    class_escape(characters);
+                    return to_node(characters);
+                }
+                default:
+                {
+                    --_p;
+                    char32_t literal = character();
+                    return to_node(char_set{ { literal, literal } });
+                }
+            }
+        }
+        
+        node repetition()
+        {
+            node result = atom();
+            if(!at_end() && (*_p == '*' || *_p == '+' || *_p == '?' || *_p == '{'))
+            {
+                node r(node::kind::repetition);
+                char c = *_p++;
+                if(c == '*')
+                {
+                    r.min = 0, r.max = UNBOUNDED;
+                }
+                else if(c == '+')
+                {
+                    r.min = 1, r.max = UNBOUNDED;
+                }
+                else if(c == '?')
+                {
+                    r.min = 0, r.max = 1;
+                }
+                else
+                {
+                    r.min = r.max = number();
+                    if(!at_end() && *_p == ',')
+                    {
+                        ++_p;
+                        r.max = !at_end() && *_p == '}' ? UNBOUNDED : number();
+                    }
+                    if(at_end() || *_p != '}' || r.max < r.min)
+                        fail("invalid repeat");
+                    ++_p;
+                }
+                
+                if(!at_end() && *_p == '?')
+                {
+                    r.greedy = false;
+                    ++_p;
+                }
+                r.children.push_back(std::move(result));
+                result = std::move(r);
+                
+                // Stacked quantifiers would nest without bound.
+                if(!at_end() && (*_p == '*' || *_p == '+' || *_p == '?' || *_p == '{'))
+                    fail("multiple repeat");
+            }
+            return result;
+        }
+        
+        node concatenation()
+        {
+            node result(node::kind::concatenation);
+            while(!at_end() && *_p != '|' && *_p != ')')
+                result.children.push_back(repetition());
+            
+            if(result.children.empty())
+                return node(node::kind::empty);
+            if(result.children.size() == 1)
+                return std::move(result.children.front());
+            return result;
+        }
+        
+        node alternation()
+        {
+            if(++_depth > vanilla::regex::MAX_NESTING)
+                fail("too deeply nested");
+            
+            node result(node::kind::alternation);
+            result.children.push_back(concatenation());
+            while(!at_end() && *_p == '|')
+            {
+                ++_p;
+                result.children.push_back(concatenation());
+            }
+            
+            --_depth;
+            if(result.children.size() == 1)
+                return std::move(result.children.front());
+            return result;
+        }
+    
+    public:
+        explicit parser(vanilla::cstr_range pattern)
+            : _pattern(pattern), _p(pattern.begin()), _depth(0)
+        { }
+        
+        node parse()
+        {
+            node result = alternation();
+            if(!at_end())
+                fail("unbalanced )");
+            return result;
+        }
+    };
+    
+    // The reversed program matches the reversed texts, with the begin and
+    // end assertions swapped.
+    class compiler
+    {
+    private:
+        regex_program& _program;
+        vanilla::cstr_range _pattern;
+        bool _reverse;
+        
+        unsigned emit(opcode op, unsigned x = 0, unsigned y = 0)
+        {
+            if(_program.code.size() >= vanilla::regex::MAX_PROGRAM_SIZE)
+                invalid_regex(_pattern, "pattern too large");
+            _program.code.push_back(regex_program::instruction{ op, x, y });
+            return _program.code.size() - 1;
+        }
+        
+        unsigned size() const
+        {
+            return _program.code.size();
+        }
+        
+        void compile(node const& n)
+        {
+            switch(n.k)
+            {
+                case node::kind::empty:
+                    break;
+                case node::kind::byte_class:
+                    _program.classes.push_back(n.bytes);
+                    emit(opcode::byte_class, _program.classes.size() - 1);
+                    break;
+                case node::kind::concatenation:
+                    if(_reverse)
+                    {
+                        for(auto i = n.children.rbegin(); i != n.children.rend(); ++i)
+                            compile(*i);
+                    }
+                    else
+                    {
+                        for(node const& child : n.children)
+                            compile(child);
+                    }
+                    break;
+                case node::kind::alternation:
+                {
+                    std::vector<unsigned> jumps;
+                    for(std::size_t i = 0; i + 1 < n.children.size(); ++i)
+                    {
+                        unsigned split = emit(opcode::split, size() + 1);
+                        compile(n.children[i]);
+                        jumps.push_back(emit(opcode::jump));
+                        _program.code[split].y = size();
+                    }
+                    compile(n.children.back());
+                    for(unsigned jump : jumps)
+                        _program.code[jump].x = size();
+                    break;
+                }
+                case node::kind::repetition:
+                {
+                    for(unsigned i = 0; i < n.min; ++i)
+                        compile(n.children.front());
+                    
+                    if(n.max == UNBOUNDED)
+                    {
+                        unsigned split = emit(opcode::split);
+                        compile(n.children.front());
+                        emit(opcode::jump, split);
+                        set_branches(split, size(), n.greedy);
+                        break;
+                    }
+                    
+                    // Each optional copy skips the rest when it's skipped.
+                    std::vector<unsigned> splits;
+                    for(unsigned i = n.min; i < n.max; ++i)
+                    {
+                        splits.push_back(emit(opcode::split));
+                        compile(n.children.front());
+                    }
+                    for(unsigned split : splits)
+                        set_branches(split, size(), n.greedy);
+                    break;
+                }
+                case node::kind::text_begin:
+                    emit(_reverse ? opcode::assert_end : opcode::assert_begin);
+                    break;
+                case node::kind::text_end:
+                    emit(_reverse ? opcode::assert_begin : opcode::assert_end);
+                    break;
+            }
+        }
+        
+        // Into the instruction after the split, or past exit.
+        void set_branches(unsigned split, unsigned exit, bool greedy)
+        {
+            _program.code[split].x = greedy ? split + 1 : exit;
+            _program.code[split].y = greedy ? exit : split + 1;
+        }
+    
+    public:
+        compiler(regex_program& program, vanilla::cstr_range pattern, bool reverse)
+            : _program(program), _pattern(pattern), _reverse(reverse)
+        { }
+        
+        void compile_program(node const& n)
+        {
+            _program.unanchored_entry = 0;
+            if(!_reverse)
+            {
+                emit(opcode::split, 3, 1);
+                _program.classes.push_back(~byte_set());
+                emit(opcode::byte_class, _program.classes.size() - 1);
+                emit(opcode::jump, 0);
+            }
+            _program.body = size();
+            compile(n);
+            emit(opcode::match);
+            if(_reverse)
+                _program.unanchored_entry = _program.body;
+            
+            // Classes are split wherever a byte is in a class and the byte
+            // before it isn't, or the other way round.
+            unsigned count = 0;
+            _program.equivalence_classes[0] = 0;
+            for(unsigned c = 1; c < 256; ++c)
+            {
+                bool boundary = false;
+                for(std::size_t i = 0; i < _program.classes.size() && !boundary; ++i)
+                    boundary = _program.classes[i].test(c) != _program.classes[i].test(c - 1);
+                if(boundary)
+                    ++count;
+                _program.equivalence_classes[c] = count;
+            }
+            _program.equivalence_class_count = count + 1;
+        }
+    };
+    
+    struct threads_hash
+    {
+        std::size_t operator()(std::vector<unsigned> const& v) const
+        {
+            std::size_t h = v.size();
+            for(unsigned pc : v)
+                h = (h ^ pc) * 0x100000001B3ull;
+            return h;
+        }
+    };
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::detail::regex_dfa
+///////////////////////////////////////////////////////////////////////////
+
+namespace vanilla
+{
+    namespace detail
+    {
+        // A DFA state is the list of NFA threads, in priority order, that
+        // wait for the next byte (or for the end of the text), or that
+        // matched. Unless searching for the longest match, threads after a
+        // match are dropped, they could only find matches of lower priority.
+        class regex_dfa
+        {
+        private:
+            regex_program const& _program;
+            unsigned _entry;
+            bool _longest;
+            
+            std::vector<std::vector<unsigned>> _threads;
+            std::vector<bool> _matches;
+            std::vector<signed char> _end_matches;  // -1 until computed.
+            std::vector<int> _next;                 // A row per state, -1 until computed.
+            unsigned _stride;
+            std::unordered_map<std::vector<unsigned>, int, threads_hash> _ids;
+            int _starts[2];
+            std::size_t _flushes;
+            
+            // For closure.
+            std::vector<unsigned> _marks;
+            unsigned _generation;
+            std::vector<unsigned> _stack;
+            
+            // Follows the threads from seeds, in order, to the instructions
+            // that wait or match.
+            void closure(std::vector<unsigned> const& seeds, bool at_begin, bool at_end, std::vector<unsigned>& out)
+            {
+                if(++_generation == 0)
+                {
+                    std::fill(_marks.begin(), _marks.end(), 0);
+                    _generation = 1;
+                }
+                
+                _stack.assign(seeds.rbegin(), seeds.rend());
+                while(!_stack.empty())
+                {
+                    unsigned pc = _stack.back();
+                    _stack.pop_back();
+                    if(_marks[pc] == _generation)
+                        continue;
+                    _marks[pc] = _generation;
+                    
+                    regex_program::instruction const& i = _program.code[pc];
+                    switch(i.op)
+                    {
+                        case regex_program::opcode::jump:
+                            _stack.push_back(i.x);
+                            break;
+                        case regex_program::opcode::split:
+                            _stack.push_back(i.y);
+                            _stack.push_back(i.x);
+                            break;
+                        case regex_program::opcode::assert_begin:
+                            if(at_begin)
+                                _stack.push_back(pc + 1);
+                            break;
+                        case regex_program::opcode::assert_end:
+                            if(at_end)
+                                _stack.push_back(pc + 1);
+                            else
+                                out.push_back(pc);
+                            break;
+                        case regex_program::opcode::byte_class:
+                            out.push_back(pc);
+                            break;
+                        case regex_program::opcode::match:
+                            out.push_back(pc);
+                            if(!_longest)
+                                return;
+                            break;
+                    }
+                }
+            }
+            
+            void flush()
+            {
+                _threads.clear();
+                _matches.clear();
+                _end_matches.clear();
+                _next.clear();
+                _ids.clear();
+                _starts[0] = _starts[1] = -1;
+                ++_flushes;
+                
+                std::vector<unsigned> dead;
+                add(dead);
+            }
+            
+            int add(std::vector<unsigned>& threads)
+            {
+                int id = _threads.size();
+                bool match = false;
+                for(unsigned pc : threads)
+                    match = match || _program.code[pc].op == regex_program::opcode::match;
+                
+                _ids.emplace(threads, id);
+                _threads.push_back(std::move(threads));
+                _matches.push_back(match);
+                _end_matches.push_back(-1);
+                _next.resize(_next.size() + _stride, -1);
+                return id;
+            }
+            
+            // May start over, which invalidates every other state.
+            int get(std::vector<unsigned>& threads)
+            {
+                auto iter = _ids.find(threads);
+                if(iter != _ids.end())
+                    return iter->second;
+                if(_threads.size() >= regex::MAX_DFA_STATES)
+                    flush();
+                return add(threads);
+            }
+            
+            int compute_next(int state, unsigned char b)
+            {
+                std::vector<unsigned> seeds;
+                for(unsigned pc : _threads[state])
+                {
+                    regex_program::instruction const& i = _program.code[pc];
+                    if(i.op == regex_program::opcode::byte_class && _program.classes[i.x].test(b))
+                        seeds.push_back(pc + 1);
+                }
+                
+                std::vector<unsigned> threads;
+                closure(seeds, false, false, threads);
+                std::size_t flushes = _flushes;
+                int result = get(threads);
+                if(flushes == _flushes)
+                    _next[state * _stride + _program.equivalence_classes[b]] = result;
+                return result;
+            }
+        
+        public:
+            static int const DEAD = 0;
+            
+            regex_dfa(regex_program const& program, unsigned entry, bool longest)
+                : _program(program), _entry(entry), _longest(longest),
+                _stride(program.equivalence_class_count), _flushes(0),
+                _marks(program.code.size(), 0), _generation(0)
+            {
+                flush();
+                _flushes = 0;
+            }
+            
+            int start(bool at_begin)
+            {
+                if(_starts[at_begin] < 0)
+                {
+                    std::vector<unsigned> threads;
+                    closure(std::vector<unsigned>(1, _entry), at_begin, false, threads);
+                    int result = get(threads);
+                    _starts[at_begin] = result;
+                }
+                return _starts[at_begin];
+            }
+            
+            int next(int state, unsigned char b)
+            {
+                int result = _next[state * _stride + _program.equivalence_classes[b]];
+                return result >= 0 ? result : compute_next(state, b);
+            }
+            
+            bool is_match(int state) const
+            {
+                return _matches[state];
+            }
+            
+            // Whether a thread matches once the end of the text is reached.
+            bool is_end_match(int state)
+            {
+                if(_end_matches[state] < 0)
+                {
+                    std::vector<unsigned> seeds;
+                    for(unsigned pc : _threads[state])
+                    {
+                        if(_program.code[pc].op == regex_program::opcode::assert_end)
+                            seeds.push_back(pc + 1);
+                    }
+                    
+                    std::vector<unsigned> threads;
+                    closure(seeds, false, true, threads);
+                    bool match = false;
+                    for(unsigned pc : threads)
+                        match = match || _program.code[pc].op == regex_program::opcode::match;
+                    _end_matches[state] = match;
+                }
+                return _end_matches[state] > 0;
+            }
+            
+            std::size_t flushes() const
+            {
+                return _flushes;
+            }
+        };
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// UTILITY
+///////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    using vanilla::detail::regex_dfa;
+    
+    enum class outcome
+    {
+        match,
+        no_match,
+        gave_up     // The DFA started over too often.
+    };
+    
+    // Where the leftmost match beginning at or after from ends.
+    outcome scan_forward(regex_dfa& dfa, vanilla::cstr_range text, std::size_t from, std::size_t& end)
+    {
+        unsigned char const* p = reinterpret_cast<unsigned char const*>(text.begin());
+        std::size_t n = text.length();
+        std::size_t flushes = dfa.flushes();
+        std::size_t last = std::size_t(-1);
+        
+        int state = dfa.start(from == 0);
+        if(dfa.is_match(state))
+            last = from;
+        
+        std::size_t i = from;
+        for(; i < n && state != regex_dfa::DEAD; ++i)
+        {
+            state = dfa.next(state, p[i]);
+            if(dfa.flushes() - flushes > vanilla::regex::MAX_DFA_FLUSHES)
+                return outcome::gave_up;
+            if(dfa.is_match(state))
+                last = i + 1;
+        }
+        if(i == n && state != regex_dfa::DEAD && dfa.is_end_match(state))
+            last = n;
+        
+        if(last == std::size_t(-1))
+            return outcome::no_match;
+        end = last;
+        return outcome::match;
+    }
+    
+    // Where the longest match of the reversed program, from end back to at
+    // most from, begins.
+    outcome scan_backward(regex_dfa& dfa, vanilla::cstr_range text, std::size_t from, std::size_t end, std::size_t& begin)
+    {
+        unsigned char const* p = reinterpret_cast<unsigned char const*>(text.begin());
+        std::size_t flushes = dfa.flushes();
+        std::size_t last = std::size_t(-1);
+        
+        int state = dfa.start(end == text.length());
+        if(dfa.is_match(state))
+            last = end;
+        
+        std::size_t i = end;
+        for(; i > from && state != regex_dfa::DEAD; --i)
+        {
+            state = dfa.next(state, p[i - 1]);
+            if(dfa.flushes() - flushes > vanilla::regex::MAX_DFA_FLUSHES)
+                return outcome::gave_up;
+            if(dfa.is_match(state))
+                last = i - 1;
+        }
+        if(i == 0 && state != regex_dfa::DEAD && dfa.is_end_match(state))
+            last = 0;
+        
+        if(last == std::size_t(-1))
+            return outcome::no_match;
+        begin = last;
+        return outcome::match;
+    }
+    
+    // Simulates the NFA, threads in priority order along with where their
+    // match began. No memory beyond two thread lists.
+    class pike_vm
+    {
+    private:
+        struct thread
+        {
+            unsigned pc;
+            std::size_t begin;
+        };
+        
+        regex_program const& _program;
+        vanilla::cstr_range _text;
+        std::vector<unsigned> _marks;
+        unsigned _generation;
+        std::vector<thread> _stack;
+        
+        // Threads already added since the last new_step() aren't added again.
+        void add(std::vector<thread>& threads, unsigned pc, std::size_t begin, std::size_t position)
+        {
+            _stack.assign(1, thread{ pc, begin });
+            while(!_stack.empty())
+            {
+                thread t = _stack.back();
+                _stack.pop_back();
+                if(_marks[t.pc] == _generation)
+                    continue;
+                _marks[t.pc] = _generation;
+                
+                regex_program::instruction const& i = _program.code[t.pc];
+                switch(i.op)
+                {
+                    case opcode::jump:
+                        _stack.push_back(thread{ i.x, t.begin });
+                        break;
+                    case opcode::split:
+                    {
+                        // Leaving the unanchored entry for the body begins a match.
+                        bool is_entry = t.pc == _program.unanchored_entry && t.pc != _program.body;
+                        _stack.push_back(thread{ i.y, t.begin });
+                        _stack.push_back(thread{ i.x, is_entry ? position : t.begin });
+                        break;
+                    }
+                    case opcode::assert_begin:
+                        if(position == 0)
+                            _stack.push_back(thread{ t.pc + 1, t.begin });
+                        break;
+                    case opcode::assert_end:
+                        if(position == _text.length())
+                            _stack.push_back(thread{ t.pc + 1, t.begin });
+                        break;
+                    case opcode::byte_class:
+                    case opcode::match:
+                        threads.push_back(t);
+                        break;
+                }
+            }
+        }
+    
+    public:
+        void new_step()
+        {
+            ++_generation;
+        }
+        
+        pike_vm(regex_program const& program, vanilla::cstr_range text)
+            : _program(program), _text(text), _marks(program.code.size(), 0), _generation(0)
+        { }
+        
+        bool search(unsigned entry, std::size_t from, vanilla::regex::span& result)
+        {
+            unsigned char const* p = reinterpret_cast<unsigned char const*>(_text.begin());
+            std::vector<thread> current, next;
+            bool matched = false;
+            
+            new_step();
+            add(current, entry, from, from);
+            for(std::size_t position = from; !current.empty(); ++position)
+            {
+                next.clear();
+                new_step();
+                for(thread const& t : current)
+                {
+                    regex_program::instruction const& i = _program.code[t.pc];
+                    if(i.op == opcode::match)
+                    {
+                        result.begin = t.begin;
+                        result.end = position;
+                        matched = true;
+                        break;
+                    }
+                    if(position < _text.length() && _program.classes[i.x].test(p[position]))
+                        add(next, t.pc + 1, t.begin, position + 1);
+                }
+                if(position == _text.length())
+                    break;
+                current.swap(next);
+            }
+            return matched;
+        }
+    };
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::regex
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::regex::regex(cstr_range pattern)
+    : _forward(new detail::regex_program()), _reverse(new detail::regex_program())
+{
+    node n = parser(pattern).parse();
+    compiler(*_forward, pattern, false).compile_program(n);
+    compiler(*_reverse, pattern, true).compile_program(n);
+    
+    _unanchored_dfa.reset(new detail::regex_dfa(*_forward, _forward->unanchored_entry, false));
+    _anchored_dfa.reset(new detail::regex_dfa(*_forward, _forward->body, false));
+    _reverse_dfa.reset(new detail::regex_dfa(*_reverse, _reverse->body, true));
+}
+
+vanilla::regex::~regex()
+{ }
+
+bool vanilla::regex::search(cstr_range text, std::size_t from, bool anchored, span& result)
+{
+    if(from > text.length())
+        return false;
+    
+    // The DFA doesn't know that the end of an empty text is its begin too.
+    unsigned entry = anchored ? _forward->body : _forward->unanchored_entry;
+    if(text.length() == 0)
+        return pike_vm(*_forward, text).search(entry, from, result);
+    
+    std::size_t end = 0;
+    switch(scan_forward(anchored ? *_anchored_dfa : *_unanchored_dfa, text, from, end))
+    {
+        case outcome::no_match:
+            return false;
+        case outcome::gave_up:
+            return pike_vm(*_forward, text).search(entry, from, result);
+        case outcome::match:
+            break;
+    }
+    
+    std::size_t begin = from;
+    if(!anchored && scan_backward(*_reverse_dfa, text, from, end, begin) != outcome::match)
+        return pike_vm(*_forward, text).search(entry, from, result);
+    
+    result.begin = begin;
+    result.end = end;
+    return true;
+}
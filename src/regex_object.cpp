@@ -0,0 +1,309 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Boost:
+#include <boost/functional/hash.hpp>
+
+// Vanilla:
+#include <vanilla/regex_object.hpp>
+#include <vanilla/string_object.hpp>
+#include <vanilla/string_builder_object.hpp>
+#include <vanilla/array_object.hpp>
+#include <vanilla/int_object.hpp>
+#include <vanilla/none_object.hpp>
+#include <vanilla/function_object.hpp>
+#include <vanilla/utf8.hpp>
+
+///////////////////////////////////////////////////////////////////////////
+/////////// UTILITY
+///////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // A position given by a script, at most size.
+    std::size_t get_position(vanilla::object::ptr const& v, std::size_t size)
+    {
+        long position = vanilla::int_object_to_signed_long(v->to_int());
+        if(position < 0 || std::size_t(position) > size)
+            BOOST_THROW_EXCEPTION(vanilla::error::invalid_index_error());
+        return position;
+    }
+    
+    // The matches of at most max, in order.
+    std::vector<vanilla::regex::span> find_matches(vanilla::regex_object* r, vanilla::cstr_range text, std::size_t max)
+    {
+        std::vector<vanilla::regex::span> result;
+        vanilla::regex::span match;
+        for(std::size_t from = 0; result.size() < max && r->search(text, from, false, match); )
+        {
+            result.push_back(match);
+            from = match.end;
+            if(match.end == match.begin)
+            {
+                if(match.end == text.length())
+                    break;
+                from = vanilla::utf8::skip_characters(text, match.end, 1);
+            }
+        }
+        return result;
+    }
+    
+    vanilla::object::ptr match_or_none(vanilla::object::ptr const& text, bool found, vanilla::regex::span match)
+    {
+        if(!found)
+            return vanilla::allocate_object<vanilla::none_object>();
+        return static_cast<vanilla::string_object*>(text.get())->slice(match.begin, match.end);
+    }
+    
+    struct range_hash
+    {
+        std::size_t operator()(vanilla::cstr_range v) const
+        {
+            return boost::hash_range(v.begin(), v.end());
+        }
+    };
+    
+    struct range_equal
+    {
+        bool operator()(vanilla::cstr_range a, vanilla::cstr_range b) const
+        {
+            return a.length() == b.length() && std::equal(a.begin(), a.end(), b.begin());
+        }
+    };
+    
+    // Least recently used entries are evicted first; the index refers to
+    // the patterns of the entries.
+    class regex_cache
+    {
+    private:
+        typedef std::list<vanilla::object::ptr> entry_list;
+        
+        entry_list _entries;
+        std::unordered_map<vanilla::cstr_range, entry_list::iterator, range_hash, range_equal> _index;
+        std::mutex _lock;
+        
+        static vanilla::cstr_range pattern_of(vanilla::object::ptr const& r)
+        {
+            std::string const& pattern = static_cast<vanilla::regex_object*>(r.get())->pattern();
+            return vanilla::cstr_range(pattern.data(), pattern.data() + pattern.size());
+        }
+        
+    public:
+        vanilla::object::ptr get(vanilla::cstr_range pattern)
+        {
+            std::lock_guard<std::mutex> lock_guard(_lock);
+            auto iter = _index.find(pattern);
+            if(iter != _index.end())
+            {
+                _entries.splice(_entries.begin(), _entries, iter->second);
+                return _entries.front();
+            }
+            
+            _entries.push_front(vanilla::allocate_object<vanilla::regex_object>(pattern));
+            _index.emplace(pattern_of(_entries.front()), _entries.begin());
+            if(_entries.size() > vanilla::regex_object::CACHE_SIZE)
+            {
+                _index.erase(pattern_of(_entries.back()));
+                _entries.pop_back();
+            }
+            return _entries.front();
+        }
+    };
+    
+    // Never destroyed, like the interned strings.
+    regex_cache& cache()
+    {
+        static regex_cache* c = new regex_cache();
+        return *c;
+    }
+    
+    std::unordered_map
+    <
+        std::string,
+        vanilla::object::ptr (*)(vanilla::regex_object*)
+    > const regex_object_elements =
+    {
+        {
+            "match", [](vanilla::regex_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "match",
+                    { vanilla::function_argument("text") },
+                    [](vanilla::regex_object* r, vanilla::object::ptr* argv, unsigned)
+                    {
+                        vanilla::regex::span match;
+                        bool found = r->search(vanilla::string_object_to_range(argv[0]), 0, true, match);
+                        return match_or_none(argv[0], found, match);
+                    });
+            }
+        },
+        {
+            "search", [](vanilla::regex_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "search",
+                    { vanilla::function_argument("text"), vanilla::function_argument("start", vanilla::allocate_object<vanilla::int_object>(0ul)) },
+                    [](vanilla::regex_object* r, vanilla::object::ptr* argv, unsigned)
+                    {
+                        vanilla::cstr_range text = vanilla::string_object_to_range(argv[0]);
+                        vanilla::string_object* s = static_cast<vanilla::string_object*>(argv[0].get());
+                        std::size_t start = s->byte_offset(get_position(argv[1], s->length()));
+                        vanilla::regex::span match;
+                        bool found = r->search(text, start, false, match);
+                        return match_or_none(argv[0], found, match);
+                    });
+            }
+        },
+        {
+            "findall", [](vanilla::regex_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "findall",
+                    { vanilla::function_argument("text") },
+                    [](vanilla::regex_object* r, vanilla::object::ptr* argv, unsigned)
+                    {
+                        return r->find_all(argv[0]);
+                    });
+            }
+        },
+        {
+            "replace", [](vanilla::regex_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "replace",
+                    { vanilla::function_argument("text"), vanilla::function_argument("replacement"), vanilla::function_argument("count", vanilla::allocate_object<vanilla::none_object>()) },
+                    [](vanilla::regex_object* r, vanilla::object::ptr* argv, unsigned)
+                    {
+                        std::size_t max = std::size_t(-1);
+                        if(argv[2]->type_id() != vanilla::OBJECT_ID_NONE)
+                            max = get_position(argv[2], max);
+                        return r->replace(argv[0], vanilla::string_object_to_range(argv[1]), max);
+                    });
+            }
+        },
+        {
+            "pattern", [](vanilla::regex_object* obj) -> vanilla::object::ptr
+            {
+                return obj->to_string();
+            }
+        },
+    };
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::regex_object
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::regex_object::regex_object(cstr_range pattern)
+    : _pattern(pattern.begin(), pattern.end()), _regex(pattern)
+{ }
+
+vanilla::object::ptr vanilla::regex_object::find_all(object::ptr const& text)
+{
+    std::vector<regex::span> matches = find_matches(this, string_object_to_range(text), std::size_t(-1));
+    string_object* s = static_cast<string_object*>(text.get());
+    
+    object::ptr result = allocate_object<array_object>(matches.size());
+    array_object* slices = static_cast<array_object*>(result.get());
+    for(std::size_t i = 0; i < matches.size(); ++i)
+        slices->set(i, s->slice(matches[i].begin, matches[i].end));
+    return result;
+}
+
+vanilla::object::ptr vanilla::regex_object::replace(object::ptr const& text, cstr_range replacement, std::size_t max)
+{
+    cstr_range v = string_object_to_range(text);
+    std::vector<regex::span> matches = find_matches(this, v, max);
+    if(matches.empty())
+        return text;
+    
+    std::size_t size = v.length() + matches.size() * replacement.length();
+    for(regex::span const& match : matches)
+        size -= match.end - match.begin;
+    
+    // The builder's buffer becomes the string's.
+    object::ptr builder = allocate_object<string_builder_object>();
+    string_builder_object* b = static_cast<string_builder_object*>(builder.get());
+    char* out = b->reserve(size);
+    std::size_t begin = 0;
+    for(regex::span const& match : matches)
+    {
+        out = std::copy(v.begin() + begin, v.begin() + match.begin, out);
+        out = std::copy(replacement.begin(), replacement.end(), out);
+        begin = match.end;
+    }
+    out = std::copy(v.begin() + begin, v.end(), out);
+    b->commit(out);
+    return b->finish();
+}
+
+vanilla::object_type_id vanilla::regex_object::type_id() const
+{
+    return OBJECT_ID_REGEX;
+}
+
+vanilla::object::ptr vanilla::regex_object::type_name() const
+{
+    return allocate_object<string_object>("regex");
+}
+
+vanilla::object::ptr vanilla::regex_object::copy(bool) const
+{
+    return const_cast<regex_object*>(this)->shared_from_this();
+}
+
+vanilla::object::ptr vanilla::regex_object::to_string() const
+{
+    return allocate_object<string_object>(_pattern);
+}
+
+vanilla::object::ptr vanilla::regex_object::eget(std::string const& name)
+{
+    auto iter = regex_object_elements.find(name);
+    if(iter != regex_object_elements.end())
+        return iter->second(this);
+    return object::eget(name);
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// FREE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::object::ptr vanilla::get_regex(cstr_range pattern)
+{
+    return cache().get(pattern);
+}
+
+vanilla::object::ptr vanilla::make_regex_function()
+{
+    return allocate_object<function_object>(
+        "regex",
+        std::vector<function_argument>{ function_argument("pattern") },
+        [](context&, object::ptr* argv, unsigned)
+        {
+            return get_regex(string_object_to_range(argv[0]));
+        },
+        false);
+}
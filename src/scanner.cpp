@@ -641,8 +641,8 @@ int vanilla::scanner::read_token(token& t)
     return SCANNER_NOMATCH;
 }
 
-vanilla::scanner::scanner(cstr_range const& data)
-    : _data(data), _cur(_data.begin()), _line(1), _pos(1)
+vanilla::scanner::scanner(cstr_range const& data, unsigned line, unsigned pos)
+    : _data(data), _cur(_data.begin()), _line(line), _pos(pos)
 { }
 
 vanilla::token vanilla::scanner::get_token()
@@ -27,6 +27,10 @@
 #include <vanilla/object.hpp>
 #include <vanilla/bool_object.hpp>
 #include <vanilla/function_object.hpp>
+#include <vanilla/instrumentation.hpp>
+#include <vanilla/cycle_collector.hpp>
+#include <vanilla/reclaimer.hpp>
+#include <vanilla/profiler.hpp>
 
 ///////////////////////////////////////////////////////////////////////////
 /////////// vanilla::statement_node
@@ -57,6 +61,8 @@ vanilla::expression_node* vanilla::expression_statement_node::get_expression()
 
 void vanilla::expression_statement_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("expression_statement_node", this);
+    
     _expression->eval(c);
 }
 
@@ -85,8 +91,15 @@ vanilla::statement_sequence_node::get_code()
         
 void vanilla::statement_sequence_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("statement_sequence_node", this);
+    
     for(statement_node::ptr& cur : _code)
+    {
+        profiler::set_current_node(cur.get());
+        cycle_collector::safepoint();
+        reclaimer::safepoint();
         cur->eval(c);
+    }
 }
 
 void vanilla::statement_sequence_node::accept(ast_visitor* v)
@@ -113,6 +126,8 @@ vanilla::expression_node* vanilla::return_statement_node::get_expression()
 
 void vanilla::return_statement_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("return_statement_node", this);
+    
     object::ptr result = _expression->eval(c);
     throw detail::function_returned{ std::move(result) };
 }
@@ -149,6 +164,8 @@ vanilla::statement_node* vanilla::if_statement_node::get_else()
 
 void vanilla::if_statement_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("if_statement_node", this);
+    
     for(auto& if_ : _ifs)
     {
         if(bool_object_to_cpp_bool(if_.first->eval(c)->to_bool()))
@@ -193,6 +210,8 @@ vanilla::statement_node* vanilla::while_statement_node::get_code()
 
 void vanilla::while_statement_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("while_statement_node", this);
+    
     while(bool_object_to_cpp_bool(_condition->eval(c)->to_bool()))
         _code->eval(c);
 }
@@ -236,6 +255,8 @@ vanilla::statement_node* vanilla::function_definition_statement_node::get_body()
 
 void vanilla::function_definition_statement_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("function_definition_statement_node", this);
+    
     auto callable = [=](context& c_, object::ptr*, unsigned) -> object::ptr
     {
         try
@@ -293,14 +314,57 @@ vanilla::expression_node* vanilla::assignment_statement_node::get_right()
 
 void vanilla::assignment_statement_node::eval(context& c)
 {
+    instrumentation::policy::node_evaluated("assignment_statement_node", this);
+    
     // We need to inspect the left side argument first.
     variable_expression_node* var_node = dynamic_cast<variable_expression_node*>(_lhs.get());
     if(var_node)
     {
+        // x = x op y may update the value of x in place.
+        auto update_node = dynamic_cast<update_expression_node*>(_rhs.get());
+        if(update_node)
+        {
+            auto operand = dynamic_cast<variable_expression_node*>(update_node->get_left());
+            if(operand && operand->get_name() == var_node->get_name())
+            {
+                c.set_value(var_node->get_name(), update_node->eval_update(c, var_node->get_name()));
+                return;
+            }
+        }
+        
         c.set_value(var_node->get_name(), _rhs->eval(c));
         return;
     }
     
+    if(auto subscript_node = dynamic_cast<subscript_expression_node*>(_lhs.get()))
+    {
+        object::ptr target = subscript_node->get_expression()->eval(c);
+        object::ptr subscript = subscript_node->get_subscript()->eval(c);
+        object::ptr value = _rhs->eval(c);
+        try
+        {
+            target->sset(subscript, std::move(value));
+        }
+        catch(error::invalid_index_error& e)
+        {
+            e << error::line_info(subscript_node->get_line()) << error::pos_info(subscript_node->get_pos());
+            throw;
+        }
+        catch(error::bad_cast_error& e)
+        {
+            e << error::line_info(subscript_node->get_line()) << error::pos_info(subscript_node->get_pos());
+            throw;
+        }
+        return;
+    }
+    
+    if(auto element_node = dynamic_cast<element_selection_expression_node*>(_lhs.get()))
+    {
+        object::ptr target = element_node->get_left()->eval(c);
+        target->eset(element_node->get_element_name(), _rhs->eval(c));
+        return;
+    }
+    
     assert(false);
 }
 
@@ -0,0 +1,408 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// GMP:
+#include <gmp.h>
+
+// Vanilla:
+#include <vanilla/string_builder_object.hpp>
+#include <vanilla/string_object.hpp>
+#include <vanilla/int_object.hpp>
+#include <vanilla/float_object.hpp>
+#include <vanilla/function_object.hpp>
+#include <vanilla/utf8.hpp>
+
+///////////////////////////////////////////////////////////////////////////
+/////////// UTILITY
+///////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    std::unordered_map
+    <
+        std::string,
+        vanilla::object::ptr (*)(vanilla::string_builder_object*)
+    > const string_builder_object_elements =
+    {
+        {
+            "append", [](vanilla::string_builder_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "append", {},
+                    [](vanilla::string_builder_object* b, vanilla::object::ptr* argv, unsigned argc)
+                    {
+                        for(unsigned i = 0; i < argc; ++i)
+                            b->append(argv[i]);
+                        return b->shared_from_this();
+                    },
+                    true);
+            }
+        },
+        {
+            "format", [](vanilla::string_builder_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "format", { vanilla::function_argument("format") },
+                    [](vanilla::string_builder_object* b, vanilla::object::ptr* argv, unsigned argc)
+                    {
+                        b->append_format(vanilla::string_object_to_range(argv[0]), argv + 1, argc - 1);
+                        return b->shared_from_this();
+                    },
+                    true);
+            }
+        },
+        {
+            "finish", [](vanilla::string_builder_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "finish", {},
+                    [](vanilla::string_builder_object* b, vanilla::object::ptr*, unsigned)
+                    {
+                        return b->finish();
+                    });
+            }
+        },
+        {
+            "length", [](vanilla::string_builder_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::allocate_object<vanilla::int_object>(obj->size());
+            }
+        },
+        {
+            "string", [](vanilla::string_builder_object* obj) -> vanilla::object::ptr
+            {
+                return obj->to_string();
+            }
+        },
+    };
+    
+    // Larger widths and precisions are rejected, they would only serve to
+    // exhaust memory.
+    std::size_t const MAX_FORMAT_WIDTH = 1 << 16;
+    
+    struct format_spec
+    {
+        bool left;      // -
+        bool plus;      // +
+        bool zeros;     // 0
+        std::size_t width;
+        long precision; // -1: none.
+        char conversion;
+    };
+    
+    [[noreturn]] void throw_invalid_format(vanilla::cstr_range format)
+    {
+        BOOST_THROW_EXCEPTION(vanilla::error::invalid_format_error()
+            << vanilla::error::format_string(std::string(format.begin(), format.end())));
+    }
+    
+    // Parses the spec after a '%', returns the character after it.
+    char const* parse_format_spec(vanilla::cstr_range format, char const* p, format_spec& spec)
+    {
+        spec = format_spec{ false, false, false, 0, -1, 0 };
+        for(; p != format.end() && std::strchr("-+0", *p); ++p)
+        {
+            spec.left |= *p == '-';
+            spec.plus |= *p == '+';
+            spec.zeros |= *p == '0';
+        }
+        for(; p != format.end() && std::isdigit(*p); ++p)
+        {
+            spec.width = spec.width * 10 + (*p - '0');
+            if(spec.width > MAX_FORMAT_WIDTH)
+                throw_invalid_format(format);
+        }
+        if(p != format.end() && *p == '.')
+        {
+            spec.precision = 0;
+            for(++p; p != format.end() && std::isdigit(*p); ++p)
+            {
+                spec.precision = spec.precision * 10 + (*p - '0');
+                if(std::size_t(spec.precision) > MAX_FORMAT_WIDTH)
+                    throw_invalid_format(format);
+            }
+        }
+        if(p == format.end() || !std::strchr("dxXobfegs", *p))
+            throw_invalid_format(format);
+        spec.conversion = *p;
+        return p + 1;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::string_builder_object
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::string_builder_object::string_builder_object()
+    : _data(nullptr), _size(0), _capacity(0)
+{ }
+
+vanilla::string_builder_object::~string_builder_object()
+{
+    delete[] _data;
+}
+
+char* vanilla::string_builder_object::reserve(std::size_t n)
+{
+    if(_size + n > _capacity)
+    {
+        // One more for the zero finish() terminates with.
+        std::size_t capacity = std::max(_size + n, std::max<std::size_t>(64, _capacity * 2));
+        char* data = new char[capacity + 1];
+        if(_data)
+            std::memcpy(data, _data, _size);
+        delete[] _data;
+        _data = data;
+        _capacity = capacity;
+    }
+    return _data + _size;
+}
+
+void vanilla::string_builder_object::append(cstr_range v)
+{
+    // The characters may be our own, reserve can move them.
+    std::size_t n = v.length();
+    if(n == 0)
+        return;
+    bool is_own = _data && v.begin() >= _data && v.begin() < _data + _size;
+    std::size_t offset = is_own ? v.begin() - _data : 0;
+    char* out = reserve(n);
+    std::memcpy(out, is_own ? _data + offset : v.begin(), n);
+    _size += n;
+}
+
+void vanilla::string_builder_object::append(object::ptr const& v)
+{
+    switch(v->type_id())
+    {
+        case OBJECT_ID_STRING:
+        {
+            append(static_cast<string_object const*>(v.get())->value());
+            break;
+        }
+        
+        case OBJECT_ID_STRING_BUILDER:
+        {
+            append(static_cast<string_builder_object const*>(v.get())->value());
+            break;
+        }
+        
+        case OBJECT_ID_INT:
+        {
+            int_object const* i = static_cast<int_object const*>(v.get());
+            commit(i->to_chars(reserve(i->max_chars())));
+            break;
+        }
+        
+        case OBJECT_ID_FLOAT:
+        {
+            float_object const* f = static_cast<float_object const*>(v.get());
+            commit(f->to_chars(reserve(f->max_chars())));
+            break;
+        }
+        
+        default:
+        {
+            append(v->to_string());
+            break;
+        }
+    }
+}
+
+void vanilla::string_builder_object::append_format(cstr_range format, object::ptr const* argv, unsigned argc)
+{
+    unsigned next = 0;
+    char const* p = format.begin();
+    while(p != format.end())
+    {
+        char const* percent = static_cast<char const*>(std::memchr(p, '%', format.end() - p));
+        if(!percent)
+        {
+            append(cstr_range(p, format.end()));
+            break;
+        }
+        
+        append(cstr_range(p, percent));
+        p = percent + 1;
+        if(p != format.end() && *p == '%')
+        {
+            append(cstr_range(p, p + 1));
+            ++p;
+            continue;
+        }
+        
+        format_spec spec;
+        p = parse_format_spec(format, p, spec);
+        if(next == argc)
+            throw_invalid_format(format);
+        object::ptr const& v = argv[next++];
+        
+        std::size_t start = _size;
+        switch(spec.conversion)
+        {
+            case 'd': case 'x': case 'X': case 'o': case 'b':
+            {
+                if(v->type_id() != OBJECT_ID_INT)
+                    throw_invalid_format(format);
+                int_object const* i = static_cast<int_object const*>(v.get());
+                int base = spec.conversion == 'd' ? 10 : spec.conversion == 'o' ? 8 :
+                    spec.conversion == 'b' ? 2 : 16;
+                commit(i->to_chars(reserve(i->max_chars(base)), base));
+                if(spec.conversion == 'X')
+                    std::transform(_data + start, _data + _size, _data + start, ::toupper);
+                break;
+            }
+            
+            case 'f': case 'e': case 'g':
+            {
+                if(v->type_id() != OBJECT_ID_INT && v->type_id() != OBJECT_ID_FLOAT)
+                    throw_invalid_format(format);
+                object::ptr n = v->to_float();
+                float_object const* f = static_cast<float_object const*>(n.get());
+                char conversion[] = { '%', '.', '*', 'F', spec.conversion, '\0' };
+                int precision = spec.precision < 0 ? 6 : int(spec.precision);
+                int length = gmp_snprintf(nullptr, 0, conversion, precision, f->value().mpf());
+                if(length < 0)
+                    throw_invalid_format(format);
+                gmp_snprintf(reserve(length), length + 1, conversion, precision, f->value().mpf());
+                _size += length;
+                break;
+            }
+            
+            default:
+            {
+                append(v);
+                if(spec.precision >= 0)
+                    _size = utf8::skip_characters(cstr_range(_data + start, _data + _size), 0, spec.precision) + start;
+                break;
+            }
+        }
+        
+        // Sign and padding. Zeros go between the sign and the digits.
+        bool numeric = spec.conversion != 's';
+        std::size_t sign = numeric && _data[start] == '-';
+        if(numeric && spec.plus && !sign)
+        {
+            reserve(1);
+            std::memmove(_data + start + 1, _data + start, _size - start);
+            _data[start] = '+';
+            ++_size;
+            sign = 1;
+        }
+        
+        bool is_ascii;
+        std::size_t length = utf8::count_characters(cstr_range(_data + start, _data + _size), is_ascii);
+        if(spec.width > length)
+        {
+            std::size_t pad = spec.width - length;
+            reserve(pad);
+            if(spec.left)
+                std::memset(_data + _size, ' ', pad);
+            else
+            {
+                std::size_t at = start + (spec.zeros && numeric ? sign : 0);
+                std::memmove(_data + at + pad, _data + at, _size - at);
+                std::memset(_data + at, spec.zeros && numeric ? '0' : ' ', pad);
+            }
+            _size += pad;
+        }
+    }
+    
+    if(next != argc)
+        throw_invalid_format(format);
+}
+
+vanilla::object::ptr vanilla::string_builder_object::finish()
+{
+    if(!_data)
+        return allocate_object<string_object>("");
+    
+    _data[_size] = '\0';
+    object::ptr result = allocate_object<string_object>(
+        string_object::buffer_tag(), _data, _size, _capacity);
+    _data = nullptr;
+    _size = 0;
+    _capacity = 0;
+    return result;
+}
+
+vanilla::object_type_id vanilla::string_builder_object::type_id() const
+{
+    return OBJECT_ID_STRING_BUILDER;
+}
+
+vanilla::object::ptr vanilla::string_builder_object::type_name() const
+{
+    return allocate_object<string_object>("string_builder");
+}
+
+vanilla::object::ptr vanilla::string_builder_object::copy(bool) const
+{
+    object::ptr result = allocate_object<string_builder_object>();
+    static_cast<string_builder_object*>(result.get())->append(value());
+    return result;
+}
+
+vanilla::object::ptr vanilla::string_builder_object::to_string() const
+{
+    return allocate_object<string_object>(value());
+}
+
+vanilla::object::ptr vanilla::string_builder_object::eget(std::string const& name)
+{
+    auto iter = string_builder_object_elements.find(name);
+    if(iter != string_builder_object_elements.end())
+        return iter->second(this);
+    return object::eget(name);
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// FREE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////
+
+vanilla::object::ptr vanilla::make_string_builder_function()
+{
+    return allocate_object<function_object>(
+        "string_builder",
+        std::vector<function_argument>(),
+        [](context&, object::ptr*, unsigned) { return allocate_object<string_builder_object>(); },
+        false);
+}
+
+vanilla::object::ptr vanilla::make_format_function()
+{
+    return allocate_object<function_object>(
+        "format",
+        std::vector<function_argument>{ function_argument("format") },
+        [](context&, object::ptr* argv, unsigned argc)
+        {
+            object::ptr builder = allocate_object<string_builder_object>();
+            string_builder_object* b = static_cast<string_builder_object*>(builder.get());
+            b->append_format(string_object_to_range(argv[0]), argv + 1, argc - 1);
+            return b->finish();
+        },
+        false,
+        true);
+}
@@ -19,20 +19,422 @@
 //      3. This notice may not be removed or altered from any source
 //      distribution.
 
+// C++ Standard Library:
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
 // Vanilla:
 #include <vanilla/string_object.hpp>
+#include <vanilla/string_search.hpp>
+#include <vanilla/utf8.hpp>
+#include <vanilla/int_object.hpp>
+#include <vanilla/bool_object.hpp>
+#include <vanilla/none_object.hpp>
+#include <vanilla/array_object.hpp>
+#include <vanilla/function_object.hpp>
+#include <vanilla/reclaimer.hpp>
+
+///////////////////////////////////////////////////////////////////////////
+/////////// UTILITY
+///////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // A position given by a script, at most size.
+    std::size_t get_position(vanilla::object::ptr const& v, std::size_t size)
+    {
+        long position = vanilla::int_object_to_signed_long(v->to_int());
+        if(position < 0 || std::size_t(position) > size)
+            BOOST_THROW_EXCEPTION(vanilla::error::invalid_index_error());
+        return position;
+    }
+    
+    char const WHITESPACE[] = " \t\n\v\f\r";
+    
+    bool is_space(char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+    
+    // 8 bytes at a time; hashes aren't cached for nothing.
+    std::size_t hash_bytes(vanilla::cstr_range v)
+    {
+        std::uint64_t const multiplier = 0x9E3779B97F4A7C15ull;
+        std::uint64_t h = v.length() * multiplier;
+        char const* p = v.begin();
+        for(; v.end() - p >= 8; p += 8)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, p, 8);
+            h = (h ^ word) * multiplier;
+            h ^= h >> 29;
+        }
+        
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, p, v.end() - p);
+        h = (h ^ tail) * multiplier;
+        return std::size_t(h ^ (h >> 32));
+    }
+    
+    struct range_hash
+    {
+        std::size_t operator()(vanilla::cstr_range v) const
+        {
+            return hash_bytes(v);
+        }
+    };
+    
+    struct range_equal
+    {
+        bool operator()(vanilla::cstr_range a, vanilla::cstr_range b) const
+        {
+            return a.length() == b.length() && std::memcmp(a.begin(), b.begin(), a.length()) == 0;
+        }
+    };
+    
+    // Keyed by the characters of the interned strings themselves.
+    typedef std::unordered_map
+    <
+        vanilla::cstr_range,
+        vanilla::object::ptr,
+        range_hash,
+        range_equal
+    > interned_strings;
+    
+    // Never destroyed, interned strings may be used during static destruction.
+    interned_strings& interned()
+    {
+        static interned_strings* strings = new interned_strings();
+        return *strings;
+    }
+    
+    // Lengths and cached hashes are compared before the characters; equal
+    // interned strings are the same object.
+    bool equal(vanilla::string_object const& a, vanilla::object const& other)
+    {
+        vanilla::string_object const& b = static_cast<vanilla::string_object const&>(other);
+        if(&a == &b)
+            return true;
+        if(a.size() != b.size() || (a.is_interned() && b.is_interned()))
+            return false;
+        if(a.is_hashed() && b.is_hashed() && a.hash() != b.hash())
+            return false;
+        return std::memcmp(a.value().begin(), b.value().begin(), a.size()) == 0;
+    }
+    
+    int compare(vanilla::string_object const& a, vanilla::object::ptr const& other)
+    {
+        vanilla::string_object const& b = static_cast<vanilla::string_object const&>(*other);
+        if(&a == &b)
+            return 0;
+        return a.value().compare(b.value());
+    }
+    
+    std::unordered_map
+    <
+        std::string,
+        vanilla::object::ptr (*)(vanilla::string_object*)
+    > const string_object_elements =
+    {
+        {
+            "length", [](vanilla::string_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::allocate_object<vanilla::int_object>(static_cast<unsigned long>(obj->length()));
+            }
+        },
+        {
+            "slice", [](vanilla::string_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "slice",
+                    { vanilla::function_argument("begin"), vanilla::function_argument("end", vanilla::allocate_object<vanilla::none_object>()) },
+                    [](vanilla::string_object* s, vanilla::object::ptr* argv, unsigned)
+                    {
+                        std::size_t end = s->length();
+                        if(argv[1]->type_id() != vanilla::OBJECT_ID_NONE)
+                            end = get_position(argv[1], s->length());
+                        std::size_t begin = get_position(argv[0], end);
+                        return s->slice(s->byte_offset(begin), s->byte_offset(end));
+                    });
+            }
+        },
+        {
+            "find", [](vanilla::string_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "find",
+                    { vanilla::function_argument("needle"), vanilla::function_argument("start", vanilla::allocate_object<vanilla::int_object>(0ul)) },
+                    [](vanilla::string_object* s, vanilla::object::ptr* argv, unsigned) -> vanilla::object::ptr
+                    {
+                        std::size_t start = s->byte_offset(get_position(argv[1], s->length()));
+                        std::size_t position = vanilla::string_search::searcher(
+                            vanilla::string_object_to_range(argv[0])).find(s->value(), start);
+                        if(position == vanilla::string_search::npos)
+                            return vanilla::allocate_object<vanilla::int_object>(-1l);
+                        return vanilla::allocate_object<vanilla::int_object>(
+                            static_cast<unsigned long>(s->character_offset(position)));
+                    });
+            }
+        },
+        {
+            "count", [](vanilla::string_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "count",
+                    { vanilla::function_argument("needle") },
+                    [](vanilla::string_object* s, vanilla::object::ptr* argv, unsigned)
+                    {
+                        return vanilla::allocate_object<vanilla::int_object>(static_cast<unsigned long>(
+                            vanilla::string_search::count(s->value(), vanilla::string_object_to_range(argv[0]))));
+                    });
+            }
+        },
+        {
+            "split", [](vanilla::string_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "split",
+                    { vanilla::function_argument("separator", vanilla::allocate_object<vanilla::none_object>()) },
+                    [](vanilla::string_object* s, vanilla::object::ptr* argv, unsigned)
+                    {
+                        if(argv[0]->type_id() == vanilla::OBJECT_ID_NONE)
+                            return s->split_whitespace();
+                        return s->split(vanilla::string_object_to_range(argv[0]));
+                    });
+            }
+        },
+        {
+            "replace", [](vanilla::string_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "replace",
+                    { vanilla::function_argument("old"), vanilla::function_argument("new"), vanilla::function_argument("count", vanilla::allocate_object<vanilla::none_object>()) },
+                    [](vanilla::string_object* s, vanilla::object::ptr* argv, unsigned)
+                    {
+                        std::size_t max = vanilla::string_search::npos;
+                        if(argv[2]->type_id() != vanilla::OBJECT_ID_NONE)
+                            max = get_position(argv[2], max);
+                        return s->replace(vanilla::string_object_to_range(argv[0]),
+                            vanilla::string_object_to_range(argv[1]), max);
+                    });
+            }
+        },
+        {
+            "strip", [](vanilla::string_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "strip",
+                    { vanilla::function_argument("characters", vanilla::allocate_object<vanilla::none_object>()) },
+                    [](vanilla::string_object* s, vanilla::object::ptr* argv, unsigned)
+                    {
+                        if(argv[0]->type_id() == vanilla::OBJECT_ID_NONE)
+                            return s->strip(vanilla::cstr_range(WHITESPACE, WHITESPACE + sizeof(WHITESPACE) - 1));
+                        return s->strip(vanilla::string_object_to_range(argv[0]));
+                    });
+            }
+        },
+        {
+            "starts_with", [](vanilla::string_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "starts_with",
+                    { vanilla::function_argument("prefix") },
+                    [](vanilla::string_object* s, vanilla::object::ptr* argv, unsigned)
+                    {
+                        vanilla::cstr_range v = s->value();
+                        vanilla::cstr_range prefix = vanilla::string_object_to_range(argv[0]);
+                        return vanilla::allocate_object<vanilla::bool_object>(prefix.length() <= v.length()
+                            && std::memcmp(v.begin(), prefix.begin(), prefix.length()) == 0);
+                    });
+            }
+        },
+        {
+            "ends_with", [](vanilla::string_object* obj) -> vanilla::object::ptr
+            {
+                return vanilla::make_element_function(obj, "ends_with",
+                    { vanilla::function_argument("suffix") },
+                    [](vanilla::string_object* s, vanilla::object::ptr* argv, unsigned)
+                    {
+                        vanilla::cstr_range v = s->value();
+                        vanilla::cstr_range suffix = vanilla::string_object_to_range(argv[0]);
+                        return vanilla::allocate_object<vanilla::bool_object>(suffix.length() <= v.length()
+                            && std::memcmp(v.end() - suffix.length(), suffix.begin(), suffix.length()) == 0);
+                    });
+            }
+        },
+    };
+}
 
 ///////////////////////////////////////////////////////////////////////////
 /////////// vanilla::string_object
 ///////////////////////////////////////////////////////////////////////////
 
-vanilla::string_object::string_object(string_type v)
-    : _v(std::move(v))
+vanilla::string_object::string_object(cstr_range v)
+    : _size(v.length()), _capacity(_size), _data(storage()),
+    _hash(0), _representation(representation::flat), _interned(false),
+    _encoding(encoding::unknown), _length(0), _index(nullptr)
+{
+    std::memcpy(_data, v.begin(), _size);
+    _data[_size] = '\0';
+}
+
+vanilla::string_object::string_object(cstr_range first, cstr_range second)
+    : _size(first.length() + second.length()), _capacity(_size), _data(storage()),
+    _hash(0), _representation(representation::flat), _interned(false),
+    _encoding(encoding::unknown), _length(0), _index(nullptr)
+{
+    std::memcpy(_data, first.begin(), first.length());
+    std::memcpy(_data + first.length(), second.begin(), second.length());
+    _data[_size] = '\0';
+}
+
+vanilla::string_object::string_object(std::string const& v)
+    : string_object(cstr_range(v.data(), v.data() + v.size()))
+{ }
+
+vanilla::string_object::string_object(char const* v)
+    : string_object(cstr_range(v, v + std::strlen(v)))
+{ }
+
+vanilla::string_object::string_object(concatenation_tag, object::ptr first, object::ptr second)
+    : _size(static_cast<string_object const*>(first.get())->size()
+        + static_cast<string_object const*>(second.get())->size()),
+    _capacity(0), _data(nullptr),
+    _hash(0), _representation(representation::concatenation), _interned(false),
+    _encoding(encoding::unknown), _length(0), _index(nullptr)
+{
+    new(operands()) object::ptr(std::move(first));
+    new(operands() + 1) object::ptr(std::move(second));
+}
+
+vanilla::string_object::string_object(view_tag, object::ptr parent, std::size_t offset, std::size_t size)
+    : _size(size), _capacity(0),
+    _data(static_cast<string_object const*>(parent.get())->_data + offset),
+    _hash(0), _representation(representation::view), _interned(false),
+    _encoding(encoding::unknown), _length(0), _index(nullptr)
+{
+    new(operands()) object::ptr(std::move(parent));
+    new(operands() + 1) object::ptr();
+}
+
+vanilla::string_object::string_object(buffer_tag, char* data, std::size_t size, std::size_t capacity)
+    : _size(size), _capacity(capacity), _data(data),
+    _hash(0), _representation(representation::flat), _interned(false),
+    _encoding(encoding::unknown), _length(0), _index(nullptr)
 { }
 
-vanilla::string_object::string_type const& vanilla::string_object::value() const
+vanilla::string_object::string_object(uninitialized_tag, std::size_t size)
+    : _size(size), _capacity(size), _data(storage()),
+    _hash(0), _representation(representation::flat), _interned(false),
+    _encoding(encoding::unknown), _length(0), _index(nullptr)
+{
+    _data[_size] = '\0';
+}
+
+vanilla::string_object::~string_object()
 {
-    return _v;
+    if(_representation != representation::flat)
+    {
+        // Long chains of concatenations would otherwise be destroyed
+        // recursively.
+        reclaimer::release(operands(), 2);
+        operands()[0].~ptr();
+        operands()[1].~ptr();
+    }
+    
+    // Only a view's characters aren't its own.
+    if(_data && _data != storage() && _representation != representation::view)
+        delete[] _data;
+    delete[] _index;
+}
+
+void vanilla::string_object::flatten() const
+{
+    char* data = new char[_size + 1];
+    
+    // Concatenations are walked without recursion, left operands first.
+    char* p = data;
+    std::vector<string_object const*> pending(1, this);
+    while(!pending.empty())
+    {
+        string_object const* cur = pending.back();
+        pending.pop_back();
+        if(cur->_data)
+        {
+            std::memcpy(p, cur->_data, cur->_size);
+            p += cur->_size;
+            continue;
+        }
+        
+        pending.push_back(static_cast<string_object const*>(cur->operands()[1].get()));
+        pending.push_back(static_cast<string_object const*>(cur->operands()[0].get()));
+    }
+    *p = '\0';
+    
+    _data = data;
+    _capacity = _size;
+    _representation = representation::copied;
+    reclaimer::release(operands(), 2);
+}
+
+void vanilla::string_object::copy_view() const
+{
+    char* data = new char[_size + 1];
+    std::memcpy(data, _data, _size);
+    data[_size] = '\0';
+    
+    _data = data;
+    _capacity = _size;
+    _representation = representation::copied;
+    operands()[0].reset();
+}
+
+void vanilla::string_object::append(cstr_range v)
+{
+    std::size_t size = _size + v.length();
+    if(size > _capacity)
+    {
+        std::size_t capacity = std::max(size, _capacity * 2);
+        char* data = new char[capacity + 1];
+        std::memcpy(data, _data, _size);
+        if(_data != storage())
+            delete[] _data;
+        _data = data;
+        _capacity = capacity;
+    }
+    
+    std::memcpy(_data + _size, v.begin(), v.length());
+    _data[size] = '\0';
+    _size = size;
+    _hash = 0;
+    _encoding = encoding::unknown;
+    delete[] _index;
+    _index = nullptr;
+}
+
+void vanilla::string_object::count_characters() const
+{
+    bool is_ascii;
+    _length = utf8::count_characters(value(), is_ascii);
+    _encoding = is_ascii ? encoding::ascii : encoding::utf8;
+}
+
+void vanilla::string_object::build_index() const
+{
+    string_type v = value();
+    std::size_t length = this->length();
+    _index = new std::size_t[(length + INDEX_STRIDE - 1) / INDEX_STRIDE];
+    
+    std::size_t offset = 0;
+    for(std::size_t i = 0; i * INDEX_STRIDE < length; ++i)
+    {
+        _index[i] = offset;
+        offset = utf8::skip_characters(v, offset, INDEX_STRIDE);
+    }
+}
+
+vanilla::string_object::string_type vanilla::string_object::value() const
+{
+    if(!_data)
+        flatten();
+    return string_type(_data, _data + _size);
 }
         
 vanilla::object_type_id vanilla::string_object::type_id() const
@@ -47,7 +449,7 @@ vanilla::object::ptr vanilla::string_object::type_name() const
         
 vanilla::object::ptr vanilla::string_object::copy(bool) const
 {
-    return allocate_object<string_object>(_v);
+    return allocate_object<string_object>(value());
 }
 
 vanilla::object::ptr vanilla::string_object::to_string() const
@@ -57,15 +459,318 @@ vanilla::object::ptr vanilla::string_object::to_string() const
 
 vanilla::object::ptr vanilla::string_object::concat(object::ptr const& other)
 {
-    return allocate_object<string_object>(_v +
-        string_object_to_cpp_string(other->to_string()));
+    object::ptr right = other->to_string();
+    string_object const* rhs = static_cast<string_object const*>(right.get());
+    
+    if(reference_count() == 1)
+    {
+        if(_representation == representation::concatenation)
+            flatten();
+        else if(_representation == representation::view)
+            copy_view();
+        append(rhs->value());
+        return shared_from_this();
+    }
+    
+    // Both halves are copied straight into short results.
+    if(_size + rhs->size() < MIN_ROPE_SIZE)
+        return allocate_object<string_object>(value(), rhs->value());
+    return allocate_object<string_object>(concatenation_tag(), shared_from_this(), std::move(right));
+}
+
+vanilla::object::ptr vanilla::string_object::slice(std::size_t begin, std::size_t end) const
+{
+    string_type v = value();
+    std::size_t size = end - begin;
+    
+    // Views always refer to the string owning the characters.
+    object::ptr parent = _representation == representation::view ?
+        operands()[0] : const_cast<string_object*>(this)->shared_from_this();
+    string_object const* p = static_cast<string_object const*>(parent.get());
+    
+    if(size < MIN_VIEW_SIZE || (p->_size >= COMPACT_SIZE && size < p->_size / COMPACT_RATIO))
+        return allocate_object<string_object>(string_type(v.begin() + begin, v.begin() + end));
+    return allocate_object<string_object>(view_tag(), std::move(parent),
+        v.begin() + begin - p->_data, size);
+}
+
+// Both split the string twice, counting the slices first so that the
+// array is allocated once.
+vanilla::object::ptr vanilla::string_object::split(cstr_range separator) const
+{
+    string_type v = value();
+    
+    // An empty separator splits between the characters, like indexing.
+    if(separator.empty())
+    {
+        std::size_t size = std::max<std::size_t>(length(), 1);
+        object::ptr result = allocate_object<array_object>(size);
+        array_object* pieces = static_cast<array_object*>(result.get());
+        
+        std::size_t begin = 0;
+        for(std::size_t i = 0; i + 1 < size; ++i)
+        {
+            std::size_t end = utf8::skip_characters(v, begin, 1);
+            pieces->set(i, slice(begin, end));
+            begin = end;
+        }
+        pieces->set(size - 1, slice(begin, v.length()));
+        return result;
+    }
+    
+    string_search::searcher searcher(separator);
+    std::size_t size = searcher.count(v) + 1;
+    object::ptr result = allocate_object<array_object>(size);
+    array_object* pieces = static_cast<array_object*>(result.get());
+    
+    std::size_t begin = 0;
+    for(std::size_t i = 0; i + 1 < size; ++i)
+    {
+        std::size_t end = searcher.find(v, begin);
+        pieces->set(i, slice(begin, end));
+        begin = end + separator.length();
+    }
+    pieces->set(size - 1, slice(begin, v.length()));
+    return result;
+}
+
+vanilla::object::ptr vanilla::string_object::split_whitespace() const
+{
+    string_type v = value();
+    char const* p = v.begin();
+    std::size_t n = v.length();
+    
+    std::size_t size = 0;
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        if(!is_space(p[i]) && (i == 0 || is_space(p[i - 1])))
+            ++size;
+    }
+    
+    object::ptr result = allocate_object<array_object>(size);
+    array_object* pieces = static_cast<array_object*>(result.get());
+    std::size_t i = 0;
+    for(std::size_t k = 0; k < size; ++k)
+    {
+        while(is_space(p[i]))
+            ++i;
+        std::size_t begin = i;
+        while(i < n && !is_space(p[i]))
+            ++i;
+        pieces->set(k, slice(begin, i));
+    }
+    return result;
+}
+
+vanilla::object::ptr vanilla::string_object::replace(cstr_range old, cstr_range replacement, std::size_t max) const
+{
+    string_type v = value();
+    string_search::searcher searcher(old);
+    std::size_t count = searcher.count(v, max);
+    if(count == 0)
+        return const_cast<string_object*>(this)->shared_from_this();
+    
+    object::ptr result = allocate_object<string_object>(uninitialized_tag(),
+        v.length() - count * old.length() + count * replacement.length());
+    char* out = static_cast<string_object*>(result.get())->_data;
+    std::size_t begin = 0;
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        // An empty old is found before every character and at the end.
+        std::size_t end = !old.empty() ? searcher.find(v, begin)
+            : i == 0 ? 0 : utf8::skip_characters(v, begin, 1);
+        std::memcpy(out, v.begin() + begin, end - begin);
+        out += end - begin;
+        std::memcpy(out, replacement.begin(), replacement.length());
+        out += replacement.length();
+        begin = end + old.length();
+    }
+    std::memcpy(out, v.begin() + begin, v.length() - begin);
+    return result;
+}
+
+vanilla::object::ptr vanilla::string_object::strip(cstr_range characters) const
+{
+    string_type v = value();
+    auto is_stripped = [&](char c)
+    {
+        return std::memchr(characters.begin(), c, characters.length()) != nullptr;
+    };
+    
+    std::size_t begin = 0, end = v.length();
+    while(begin < end && is_stripped(v.begin()[begin]))
+        ++begin;
+    while(end > begin && is_stripped(v.begin()[end - 1]))
+        --end;
+    if(begin == 0 && end == v.length())
+        return const_cast<string_object*>(this)->shared_from_this();
+    return slice(begin, end);
+}
+
+std::size_t vanilla::string_object::byte_offset(std::size_t character) const
+{
+    if(length() == character)
+        return _size;
+    if(_encoding == encoding::ascii)
+        return character;
+    
+    if(!_index)
+        build_index();
+    return utf8::skip_characters(value(), _index[character / INDEX_STRIDE], character % INDEX_STRIDE);
+}
+
+std::size_t vanilla::string_object::character_offset(std::size_t byte) const
+{
+    if(length() == 0 || _encoding == encoding::ascii)
+        return byte;
+    
+    if(!_index)
+        build_index();
+    std::size_t entries = (_length + INDEX_STRIDE - 1) / INDEX_STRIDE;
+    std::size_t k = std::upper_bound(_index, _index + entries, byte) - _index - 1;
+    
+    // The character of the table entry, and those after it that begin
+    // before byte.
+    std::size_t result = k * INDEX_STRIDE;
+    if(byte == _index[k])
+        return result;
+    
+    string_type rest(value().begin() + _index[k] + 1, value().begin() + byte);
+    bool is_ascii;
+    std::size_t count = utf8::count_characters(rest, is_ascii);
+    if(!rest.empty() && utf8::is_continuation(rest.begin()[0]))
+        --count;
+    return result + 1 + count;
+}
+
+std::size_t vanilla::string_object::hash() const
+{
+    // 0 means not computed, the probe positions of dictionaries need all
+    // other bits.
+    if(_hash == 0)
+    {
+        std::size_t h = hash_bytes(value());
+        _hash = h ? h : 1;
+    }
+    return _hash;
+}
+
+bool vanilla::string_object::equals(object const& other) const
+{
+    return other.type_id() == OBJECT_ID_STRING && equal(*this, other);
+}
+
+vanilla::object::ptr vanilla::string_object::intern(cstr_range v)
+{
+    interned_strings& strings = interned();
+    auto iter = strings.find(v);
+    if(iter != strings.end())
+        return iter->second;
+    
+    object::ptr result = allocate_object<string_object>(v);
+    string_object* s = static_cast<string_object*>(result.get());
+    s->_interned = true;
+    strings.emplace(s->value(), result);
+    return result;
+}
+
+vanilla::object::ptr vanilla::string_object::lt(object::ptr const& other)
+{
+    if(other->type_id() != OBJECT_ID_STRING)
+        return object::lt(other);
+    return allocate_object<bool_object>(compare(*this, other) < 0);
+}
+
+vanilla::object::ptr vanilla::string_object::le(object::ptr const& other)
+{
+    if(other->type_id() != OBJECT_ID_STRING)
+        return object::le(other);
+    return allocate_object<bool_object>(compare(*this, other) <= 0);
+}
+
+vanilla::object::ptr vanilla::string_object::gt(object::ptr const& other)
+{
+    if(other->type_id() != OBJECT_ID_STRING)
+        return object::gt(other);
+    return allocate_object<bool_object>(compare(*this, other) > 0);
+}
+
+vanilla::object::ptr vanilla::string_object::ge(object::ptr const& other)
+{
+    if(other->type_id() != OBJECT_ID_STRING)
+        return object::ge(other);
+    return allocate_object<bool_object>(compare(*this, other) >= 0);
+}
+
+vanilla::object::ptr vanilla::string_object::eq(object::ptr const& other)
+{
+    if(other->type_id() != OBJECT_ID_STRING)
+        return object::eq(other);
+    return allocate_object<bool_object>(equal(*this, *other));
+}
+
+vanilla::object::ptr vanilla::string_object::neq(object::ptr const& other)
+{
+    if(other->type_id() != OBJECT_ID_STRING)
+        return object::neq(other);
+    return allocate_object<bool_object>(!equal(*this, *other));
+}
+
+vanilla::object::ptr vanilla::string_object::sget(object::ptr const& subscript)
+{
+    long index = int_object_to_signed_long(subscript->to_int());
+    if(index < 0 || std::size_t(index) >= length())
+        BOOST_THROW_EXCEPTION(error::invalid_index_error());
+    
+    return slice(byte_offset(index), byte_offset(index + 1));
+}
+
+vanilla::object::ptr vanilla::string_object::eget(std::string const& name)
+{
+    auto iter = string_object_elements.find(name);
+    if(iter != string_object_elements.end())
+        return iter->second(this);
+    return object::eget(name);
+}
+
+bool vanilla::string_object::is_container() const
+{
+    return _representation == representation::concatenation;
+}
+
+void vanilla::string_object::traverse(object_visitor& v) const
+{
+    if(_representation != representation::concatenation)
+        return;
+    v.visit(operands()[0]);
+    v.visit(operands()[1]);
+}
+
+void vanilla::string_object::release_references()
+{
+    if(_representation == representation::concatenation)
+        reclaimer::release(operands(), 2);
+}
+
+std::size_t vanilla::string_object::memory_size() const
+{
+    std::size_t result = sizeof(string_object);
+    if(_representation != representation::flat)
+        result += 2 * sizeof(object::ptr);
+    else if(_data == storage())
+        result += _size + 1;
+    if(_data && _data != storage() && _representation != representation::view)
+        result += _capacity + 1;
+    if(_index)
+        result += (_length + INDEX_STRIDE - 1) / INDEX_STRIDE * sizeof(std::size_t);
+    return result;
 }
 
 ///////////////////////////////////////////////////////////////////////////
 /////////// FREE FUNCTIONS
 ///////////////////////////////////////////////////////////////////////////
 
-std::string const& vanilla::string_object_to_cpp_string(object::ptr const& obj)
+vanilla::cstr_range vanilla::string_object_to_range(object::ptr const& obj)
 {
     if(obj->type_id() != OBJECT_ID_STRING)
     {
@@ -75,4 +780,10 @@ std::string const& vanilla::string_object_to_cpp_string(object::ptr const& obj)
     }
     
     return static_cast<string_object const*>(obj.get())->value();
-}
\ No newline at end of file
+}
+
+std::string vanilla::string_object_to_cpp_string(object::ptr const& obj)
+{
+    cstr_range s = string_object_to_range(obj);
+    return std::string(s.begin(), s.end());
+}
@@ -0,0 +1,265 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <algorithm>
+#include <cstring>
+
+// Intrinsics:
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Vanilla:
+#include <vanilla/string_search.hpp>
+#include <vanilla/utf8.hpp>
+
+///////////////////////////////////////////////////////////////////////////
+/////////// UTILITY
+///////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    typedef unsigned char byte;
+    
+#if defined(__AVX2__)
+    struct vector
+    {
+        typedef __m256i type;
+        static std::size_t const size = 32;
+        
+        static type broadcast(char c)
+        {
+            return _mm256_set1_epi8(c);
+        }
+        
+        // A bit per position where p equals first and q equals last.
+        static unsigned matches(char const* p, type first, char const* q, type last)
+        {
+            type a = _mm256_cmpeq_epi8(first, _mm256_loadu_si256(reinterpret_cast<type const*>(p)));
+            type b = _mm256_cmpeq_epi8(last, _mm256_loadu_si256(reinterpret_cast<type const*>(q)));
+            return _mm256_movemask_epi8(_mm256_and_si256(a, b));
+        }
+    };
+#elif defined(__SSE2__)
+    struct vector
+    {
+        typedef __m128i type;
+        static std::size_t const size = 16;
+        
+        static type broadcast(char c)
+        {
+            return _mm_set1_epi8(c);
+        }
+        
+        // A bit per position where p equals first and q equals last.
+        static unsigned matches(char const* p, type first, char const* q, type last)
+        {
+            type a = _mm_cmpeq_epi8(first, _mm_loadu_si128(reinterpret_cast<type const*>(p)));
+            type b = _mm_cmpeq_epi8(last, _mm_loadu_si128(reinterpret_cast<type const*>(q)));
+            return _mm_movemask_epi8(_mm_and_si128(a, b));
+        }
+    };
+#endif
+    
+    // Candidates are the positions of the first byte, found by memchr.
+    std::size_t find_scalar(char const* h, std::size_t n, char const* x, std::size_t m, std::size_t from)
+    {
+        char const* end = h + n - m + 1;
+        for(char const* p = h + from; p < end; ++p)
+        {
+            p = static_cast<char const*>(std::memchr(p, x[0], end - p));
+            if(!p)
+                break;
+            if(p[m - 1] == x[m - 1] && std::memcmp(p + 1, x + 1, m - 2) == 0)
+                return p - h;
+        }
+        return vanilla::string_search::npos;
+    }
+    
+    // For needles of at least 2 and at most MAX_FILTERED_NEEDLE bytes.
+    std::size_t find_filtered(char const* h, std::size_t n, char const* x, std::size_t m)
+    {
+        std::size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+        vector::type first = vector::broadcast(x[0]);
+        vector::type last = vector::broadcast(x[m - 1]);
+        for(; i + m - 1 + vector::size <= n; i += vector::size)
+        {
+            unsigned mask = vector::matches(h + i, first, h + i + m - 1, last);
+            for(; mask != 0; mask &= mask - 1)
+            {
+                std::size_t position = i + __builtin_ctz(mask);
+                if(std::memcmp(h + position + 1, x + 1, m - 2) == 0)
+                    return position;
+            }
+        }
+#endif
+        return find_scalar(h, n, x, m, i);
+    }
+    
+    // The position before the maximal suffix of x, under the byte order or
+    // its reverse, and the period of that suffix.
+    std::ptrdiff_t maximal_suffix(byte const* x, std::ptrdiff_t m, bool reverse, std::ptrdiff_t& period)
+    {
+        std::ptrdiff_t ms = -1, j = 0, k = 1;
+        period = 1;
+        while(j + k < m)
+        {
+            byte a = x[j + k];
+            byte b = x[ms + k];
+            if(reverse ? a > b : a < b)
+            {
+                j += k;
+                k = 1;
+                period = j - ms;
+            }
+            else if(a == b)
+            {
+                if(k != period)
+                {
+                    ++k;
+                }
+                else
+                {
+                    j += period;
+                    k = 1;
+                }
+            }
+            else
+            {
+                ms = j;
+                j = ms + 1;
+                k = period = 1;
+            }
+        }
+        return ms;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::string_search::searcher
+///////////////////////////////////////////////////////////////////////////
+
+// Long needles use Crochemore and Perrin's two-way algorithm. The needle
+// is split at a critical factorization x = u v; v is compared left to
+// right, then u right to left, and the shifts never skip an occurrence.
+vanilla::string_search::searcher::searcher(cstr_range needle)
+    : _needle(needle), _ell(0), _period(0), _is_periodic(false)
+{
+    if(needle.length() <= MAX_FILTERED_NEEDLE)
+        return;
+    
+    byte const* x = reinterpret_cast<byte const*>(needle.begin());
+    std::ptrdiff_t m = needle.length();
+    std::ptrdiff_t p, q;
+    std::ptrdiff_t i = maximal_suffix(x, m, false, p);
+    std::ptrdiff_t j = maximal_suffix(x, m, true, q);
+    _ell = std::max(i, j);
+    _period = i > j ? p : q;
+    _is_periodic = std::memcmp(x, x + _period, _ell + 1) == 0;
+    if(!_is_periodic)
+        _period = std::max(_ell + 1, m - _ell - 1) + 1;
+}
+
+std::size_t vanilla::string_search::searcher::find_long(char const* haystack, std::size_t n) const
+{
+    byte const* x = reinterpret_cast<byte const*>(_needle.begin());
+    byte const* y = reinterpret_cast<byte const*>(haystack);
+    std::ptrdiff_t m = _needle.length();
+    std::ptrdiff_t last = std::ptrdiff_t(n) - m;
+    
+    // The prefix of u known to match after a shift by a periodic needle's
+    // period.
+    std::ptrdiff_t memory = -1;
+    for(std::ptrdiff_t j = 0; j <= last; )
+    {
+        std::ptrdiff_t i = std::max(_ell, memory) + 1;
+        while(i < m && x[i] == y[i + j])
+            ++i;
+        if(i < m)
+        {
+            j += i - _ell;
+            memory = -1;
+            continue;
+        }
+        
+        i = _ell;
+        while(i > memory && x[i] == y[i + j])
+            --i;
+        if(i <= memory)
+            return j;
+        j += _period;
+        if(_is_periodic)
+            memory = m - _period - 1;
+    }
+    return npos;
+}
+
+std::size_t vanilla::string_search::searcher::find(cstr_range haystack, std::size_t from) const
+{
+    if(from > haystack.length())
+        return npos;
+    char const* h = haystack.begin() + from;
+    std::size_t n = haystack.length() - from;
+    std::size_t m = _needle.length();
+    if(m > n)
+        return npos;
+    
+    std::size_t position;
+    if(m == 0)
+    {
+        position = 0;
+    }
+    else if(m == 1)
+    {
+        void const* p = std::memchr(h, _needle.begin()[0], n);
+        position = p ? static_cast<char const*>(p) - h : npos;
+    }
+    else if(m <= MAX_FILTERED_NEEDLE)
+    {
+        position = find_filtered(h, n, _needle.begin(), m);
+    }
+    else
+    {
+        position = find_long(h, n);
+    }
+    return position == npos ? npos : from + position;
+}
+
+std::size_t vanilla::string_search::searcher::count(cstr_range haystack, std::size_t max) const
+{
+    if(_needle.empty())
+    {
+        bool is_ascii;
+        return std::min(utf8::count_characters(haystack, is_ascii) + 1, max);
+    }
+    
+    std::size_t result = 0;
+    for(std::size_t position = find(haystack); position != npos && result < max;
+        position = find(haystack, position + _needle.length()))
+    {
+        ++result;
+    }
+    return result;
+}
@@ -0,0 +1,181 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// C++ Standard Library:
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unordered_set>
+#include <cstdio>
+
+// System:
+#include <unistd.h>
+
+// Vanilla:
+#include <vanilla/tracing.hpp>
+
+namespace
+{
+    using vanilla::tracing::detail::event;
+    
+    // Written by its thread only; head is published with release semantics
+    // so a concurrent writer never exposes a half written event.
+    struct ring_buffer
+    {
+        std::unique_ptr<event[]> events;
+        std::size_t capacity;
+        std::atomic<std::uint64_t> head;
+        unsigned thread_id;
+    };
+    
+    std::mutex registry_lock;
+    std::vector<std::unique_ptr<ring_buffer>> buffers;
+    std::unordered_set<std::string> interned_names;
+    std::size_t buffer_capacity = 1 << 20;
+    std::chrono::steady_clock::time_point epoch;
+    
+    thread_local ring_buffer* local_buffer = nullptr;
+    
+    ring_buffer* register_thread()
+    {
+        std::lock_guard<std::mutex> lock(registry_lock);
+        std::unique_ptr<ring_buffer> fresh(new ring_buffer());
+        fresh->events.reset(new event[buffer_capacity]);
+        fresh->capacity = buffer_capacity;
+        fresh->head = 0;
+        fresh->thread_id = buffers.size() + 1;
+        buffers.push_back(std::move(fresh));
+        return buffers.back().get();
+    }
+    
+    void write_string(std::ostream& o, char const* s)
+    {
+        o << '"';
+        for(; *s; ++s)
+        {
+            if(*s == '"' || *s == '\\')
+                o << '\\' << *s;
+            else if(static_cast<unsigned char>(*s) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(*s));
+                o << escaped;
+            }
+            else
+                o << *s;
+        }
+        o << '"';
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// vanilla::tracing::detail
+///////////////////////////////////////////////////////////////////////////
+
+bool vanilla::tracing::detail::active = false;
+
+void vanilla::tracing::detail::record(char phase, char const* name, char const* category)
+{
+    ring_buffer* buffer = local_buffer;
+    if(!buffer)
+        buffer = local_buffer = register_thread();
+    
+    std::uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    event& e = buffer->events[head % buffer->capacity];
+    e.name = name;
+    e.category = category;
+    e.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count();
+    e.phase = phase;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+char const* vanilla::tracing::detail::intern(std::string const& name)
+{
+    std::lock_guard<std::mutex> lock(registry_lock);
+    return interned_names.insert(name.empty() ? "<anonymous>" : name).first->c_str();
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// FREE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////
+
+void vanilla::tracing::start(std::size_t events_per_thread)
+{
+    std::lock_guard<std::mutex> lock(registry_lock);
+    buffer_capacity = events_per_thread;
+    for(std::unique_ptr<ring_buffer>& cur : buffers)
+        cur->head = 0;
+    epoch = std::chrono::steady_clock::now();
+    detail::active = true;
+}
+
+void vanilla::tracing::stop()
+{
+    detail::active = false;
+}
+
+bool vanilla::tracing::is_running()
+{
+    return detail::active;
+}
+
+void vanilla::tracing::write_chrome_json(std::ostream& o)
+{
+    std::lock_guard<std::mutex> lock(registry_lock);
+    
+    long pid = ::getpid();
+    o << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    char const* separator = "\n";
+    for(std::unique_ptr<ring_buffer> const& buffer : buffers)
+    {
+        std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+        std::uint64_t first = head > buffer->capacity ? head - buffer->capacity : 0;
+        
+        // After a wrap the oldest end events lost their begin events.
+        std::size_t depth = 0;
+        for(std::uint64_t i = first; i < head; ++i)
+        {
+            event const& e = buffer->events[i % buffer->capacity];
+            if(e.phase == 'E')
+            {
+                if(depth == 0)
+                    continue;
+                --depth;
+            }
+            else
+                ++depth;
+            
+            char timestamp[32];
+            std::snprintf(timestamp, sizeof(timestamp), "%.3f", e.timestamp / 1000.0);
+            
+            o << separator << "{\"name\":";
+            write_string(o, e.name);
+            o   << ",\"cat\":\"" << e.category << "\",\"ph\":\"" << e.phase
+                << "\",\"ts\":" << timestamp << ",\"pid\":" << pid
+                << ",\"tid\":" << buffer->thread_id << '}';
+            separator = ",\n";
+        }
+    }
+    o << "\n]}\n";
+}
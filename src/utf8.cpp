@@ -0,0 +1,130 @@
+//  Copyright (c) <2013> <Florian Erler>
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty. In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not be
+//      misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source
+//      distribution.
+
+// Intrinsics:
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Vanilla:
+#include <vanilla/utf8.hpp>
+
+///////////////////////////////////////////////////////////////////////////
+/////////// UTILITY
+///////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+#if defined(__AVX2__)
+    struct vector
+    {
+        typedef __m256i type;
+        static std::size_t const size = 32;
+        
+        static type load(char const* p)
+        {
+            return _mm256_loadu_si256(reinterpret_cast<type const*>(p));
+        }
+        
+        // A bit per byte with the high bit set.
+        static unsigned non_ascii(type v)
+        {
+            return _mm256_movemask_epi8(v);
+        }
+        
+        // A bit per byte from 0x80 to 0xBF, which are below -64 as signed.
+        static unsigned continuations(type v)
+        {
+            return _mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(-64), v));
+        }
+    };
+#elif defined(__SSE2__)
+    struct vector
+    {
+        typedef __m128i type;
+        static std::size_t const size = 16;
+        
+        static type load(char const* p)
+        {
+            return _mm_loadu_si128(reinterpret_cast<type const*>(p));
+        }
+        
+        // A bit per byte with the high bit set.
+        static unsigned non_ascii(type v)
+        {
+            return _mm_movemask_epi8(v);
+        }
+        
+        // A bit per byte from 0x80 to 0xBF, which are below -64 as signed.
+        static unsigned continuations(type v)
+        {
+            return _mm_movemask_epi8(_mm_cmplt_epi8(v, _mm_set1_epi8(-64)));
+        }
+    };
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////
+/////////// FREE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////
+
+std::size_t vanilla::utf8::count_characters(cstr_range v, bool& is_ascii)
+{
+    char const* p = v.begin();
+    std::size_t n = v.length();
+    std::size_t continuations = 0;
+    unsigned non_ascii = 0;
+    
+    std::size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    for(; i + vector::size <= n; i += vector::size)
+    {
+        vector::type bytes = vector::load(p + i);
+        non_ascii |= vector::non_ascii(bytes);
+        continuations += __builtin_popcount(vector::continuations(bytes));
+    }
+#endif
+    for(; i < n; ++i)
+    {
+        non_ascii |= static_cast<unsigned char>(p[i]) & 0x80;
+        continuations += is_continuation(p[i]);
+    }
+    
+    is_ascii = non_ascii == 0;
+    if(n != 0 && is_continuation(p[0]))
+        --continuations;
+    return n - continuations;
+}
+
+std::size_t vanilla::utf8::skip_characters(cstr_range v, std::size_t offset, std::size_t count)
+{
+    char const* p = v.begin();
+    std::size_t n = v.length();
+    for(; count != 0 && offset < n; --count)
+    {
+        ++offset;
+        while(offset < n && is_continuation(p[offset]))
+            ++offset;
+    }
+    return offset;
+}
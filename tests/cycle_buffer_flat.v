@@ -0,0 +1,38 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+function live_objects()
+{
+    stats = alloc_stats();
+    total = 0;
+    i = 0;
+    while i < stats.length
+    {
+        total = total + stats[i][1];
+        i = i + 1;
+    }
+    return total;
+}
+
+s = "x";
+i = 0;
+while i < 12
+{
+    s = s ~ "," ~ s;
+    i = i + 1;
+}
+
+r = 0;
+while r < 100
+{
+    parts = s.split(",");
+    parts[0] = [r];
+    parts = 0;
+    if r == 10
+    {
+        before = live_objects();
+    }
+    r = r + 1;
+}
+after = live_objects();
+puts("pieces " ~ s.split(",").length);
+puts("flat " ~ (after - before < 100));
@@ -0,0 +1,16 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+function make(flag)
+{
+    d = {"a": 1, "nested": {"b": 2}, 3: flag ? "yes" : "no",};
+    e = {};
+    return [d, e];
+}
+
+pair = make(true);
+d = pair[0];
+puts("length " ~ d.length);
+puts("a " ~ d["a"]);
+puts("nested b " ~ d["nested"]["b"]);
+puts("3 " ~ d[3]);
+puts("empty " ~ pair[1].length);
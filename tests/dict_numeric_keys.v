@@ -0,0 +1,20 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+puts("1 == 1.0 " ~ (1 == 1.0));
+puts("1.0 == 1 " ~ (1.0 == 1));
+puts("1.5 != 1 " ~ (1.5 != 1));
+puts("1.5 == 1.5 " ~ (1.5 == 1.5));
+
+d = {1: "one", 2.5: "two and a half"};
+puts("d[1.0] " ~ d[1.0]);
+puts("d[2.5] " ~ d[2.5]);
+d[1.0] = "replaced";
+puts("length " ~ d.length);
+puts("d[1] " ~ d[1]);
+
+big = 1267650600228229401496703205376;
+e = {1267650600228229401496703205376.0: "float"};
+puts("2^100 == 2^100.0 " ~ (big == 1267650600228229401496703205376.0));
+puts("contains 2^100 " ~ e.contains(big));
+puts("2^100 + 1 == 2^100.0 " ~ (big + 1 == 1267650600228229401496703205376.0));
+puts("contains 2^100 + 1 " ~ e.contains(big + 1));
@@ -0,0 +1,4 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+x = [0.0, 1000.0, 1.0, 1.5, 0.001, 123.456];
+puts("literals " ~ x.length);
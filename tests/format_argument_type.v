@@ -0,0 +1,5 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+puts(format("%d|%5x|%-4o|%b", 42, 255, 8, 5));
+puts(format("%.2f|%e", 2, 1.5));
+puts(format("%d", 2.5));
@@ -0,0 +1,10 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+puts("[" ~ format("%.1s", "éa") ~ "]");
+puts("[" ~ format("%.2s", "日本語") ~ "]");
+puts("[" ~ format("%5s", "é") ~ "]");
+puts("[" ~ format("%-5s", "日本") ~ "]");
+puts("[" ~ format("%3.1s", "éé") ~ "]");
+puts("[" ~ format("%.0s", "é") ~ "]");
+puts("[" ~ format("%.9s", "é") ~ "]");
+puts("[" ~ format("%4d", 42) ~ "]");
@@ -0,0 +1,5 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+puts(format("%.3f", 1.5));
+puts(format("[%8d]", 7).length);
+puts(format("%.2147483648f", 1.5));
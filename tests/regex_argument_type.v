@@ -0,0 +1,5 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+r = regex("b+");
+puts(r.search("abbc"));
+puts(r.search(5));
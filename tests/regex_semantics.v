@@ -0,0 +1,40 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+function show(name, found)
+{
+    puts(name ~ " [" ~ found ~ "]");
+}
+
+show("alternation", regex("a|ab").search("xab"));
+show("alternation", regex("ab|a").search("xab"));
+show("alternation", regex("(?:b|bc|bcd)d").search("abcdd"));
+show("alternation", regex("foo|foobar").findall("foobar foo").length.string);
+show("lazy", regex("a+?").search("aaa"));
+show("lazy", regex("a*?b").search("aaab"));
+show("lazy", regex("<.+?>").search("<a><b>"));
+show("lazy", regex("<.+>").search("<a><b>"));
+show("lazy", regex("a{2,4}?").search("aaaaa"));
+show("lazy", regex("(?:ab)??ab").search("abab"));
+show("anchored", regex("b|ab").match("abc"));
+show("empty", regex("a*").findall("baab").length.string);
+
+x = 3;
+i = 0;
+while i < 16
+{
+    x = x * x;
+    i = i + 1;
+}
+text = x.string;
+i = 0;
+while i < 10
+{
+    text = text.replace(i.string, "aaaaabbbbb".slice(i, i + 1));
+    i = i + 1;
+}
+
+show("dfa flush", regex("a(?:a|b){13}b").findall(text).length.string);
+show("pike vm", regex("(?:a|b)*a(?:a|b){14}bbbb").search(text).length.string);
+show("pike vm anchored", regex("(?:a|b)*a(?:a|b){14}a").match(text).length.string);
+show("pike vm reverse", regex("(?:a|b){14}a(?:a|b)*").search(text, 3).length.string);
+show("dfa lazy", regex("(?:a|b)*?a(?:a|b){14}bb").search(text).length.string);
@@ -0,0 +1,15 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+puts("dot " ~ regex(".").search("é"));
+puts("class " ~ regex("[é]").findall("é").length);
+puts("negated " ~ regex("[^a]").search("aé"));
+puts("range " ~ regex("[à-ÿ]+").search("xàéÿz"));
+puts("repeat " ~ regex("é+").search("aééb"));
+puts("not digit " ~ regex("\\D").findall("1日2本").length);
+puts("not word " ~ regex("\\W+").search("ab日本cd"));
+puts("four bytes " ~ regex("[😀-😂]").search("a😁b"));
+puts("start " ~ regex(".").search("日本語", 1));
+puts("after start " ~ regex("語").search("日本語", 2));
+puts("empty " ~ regex("x*").findall("日本").length);
+puts("replace " ~ regex("").replace("日本", "-"));
+puts("any " ~ regex("a.c").findall("abc aéc a日c a😀c").length);
@@ -0,0 +1,50 @@
+# Runs a test script and compares its output with the expected one:
+#
+#   cmake -DINTERPRETER=<vanilla> -DSCRIPT=<name.v> -DEXPECTED=<name.out>
+#         [-DDUMP=xml|json -DEXPECTED_DUMP=<file>] [-DARGS="<options>"]
+#         [-DEXPECTED_ERRORS=<name.err>] -DWORK_DIR=<dir> -P run_script.cmake
+#
+# The script is copied to WORK_DIR first, so the AST dump is written there
+# and not next to the source. Fails if the interpreter exits with an error,
+# or with EXPECTED_ERRORS, if it doesn't exit with 1 and exactly those
+# errors.
+
+get_filename_component(name ${SCRIPT} NAME)
+file(MAKE_DIRECTORY ${WORK_DIR})
+configure_file(${SCRIPT} ${WORK_DIR}/${name} COPYONLY)
+
+separate_arguments(ARGS)
+set(arguments --no-cache ${ARGS})
+if(DUMP)
+    list(APPEND arguments --dump-ast=${DUMP})
+endif()
+
+execute_process(
+    COMMAND ${INTERPRETER} ${arguments} ${WORK_DIR}/${name}
+    WORKING_DIRECTORY ${WORK_DIR}
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE errors
+)
+
+if(EXPECTED_ERRORS)
+    file(READ ${EXPECTED_ERRORS} expected_errors)
+    if(NOT result EQUAL 1 OR NOT errors STREQUAL expected_errors)
+        message(FATAL_ERROR "${name} exited with ${result}:\n${errors}\nexpected 1:\n${expected_errors}")
+    endif()
+elseif(NOT result EQUAL 0)
+    message(FATAL_ERROR "${name} exited with ${result}:\n${errors}")
+endif()
+
+file(READ ${EXPECTED} expected)
+if(NOT output STREQUAL expected)
+    message(FATAL_ERROR "${name} printed:\n${output}\nexpected:\n${expected}")
+endif()
+
+if(DUMP)
+    file(READ ${WORK_DIR}/${name}.${DUMP} dump)
+    file(READ ${EXPECTED_DUMP} expected_dump)
+    if(NOT dump STREQUAL expected_dump)
+        message(FATAL_ERROR "${name}.${DUMP} is:\n${dump}\nexpected:\n${expected_dump}")
+    endif()
+endif()
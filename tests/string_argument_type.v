@@ -0,0 +1,5 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+puts("find " ~ "abc".find("c"));
+puts("parts " ~ "a,b".split(",").length);
+puts("find " ~ "abc".find(1));
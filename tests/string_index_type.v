@@ -0,0 +1,5 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+s = "abc";
+puts(s[1] ~ s.slice(0, 2));
+puts(s["x"]);
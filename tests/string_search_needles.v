@@ -0,0 +1,46 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+function repeat(s, n)
+{
+    result = "";
+    while n > 0
+    {
+        result = result ~ s;
+        n = n - 1;
+    }
+    return result;
+}
+
+alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789+/";
+sizes = [1, 16, 32, 33, 64];
+offsets = [0, 1, 15, 16, 31, 32, 63, 64, 95];
+i = 0;
+while i < sizes.length
+{
+    needle = alphabet.slice(0, sizes[i]);
+    miss = needle.slice(0, sizes[i] - 1) ~ "#";
+    line = "size " ~ sizes[i].string ~ ":";
+    j = 0;
+    while j < offsets.length
+    {
+        haystack = repeat("-", offsets[j]) ~ needle;
+        line = line ~ " " ~ haystack.find(needle).string ~ "/" ~ haystack.count(needle).string;
+        haystack = repeat(".", offsets[j]) ~ miss ~ needle;
+        line = line ~ " " ~ haystack.find(needle).string ~ "/" ~ haystack.count(needle).string;
+        j = j + 1;
+    }
+    puts(line);
+    i = i + 1;
+}
+
+periodic = repeat("ab", 16) ~ "a";
+puts("periodic " ~ repeat("ab", 40).find(periodic).string ~ " " ~ repeat("ab", 40).count(periodic).string
+    ~ " " ~ (repeat("ab", 10) ~ "b" ~ repeat("ab", 20)).find(periodic).string);
+puts("repeated " ~ repeat("x", 100).count(repeat("x", 33)).string ~ " " ~ repeat("x", 100).find(repeat("x", 64), 36).string ~ " " ~ repeat("x", 100).find(repeat("x", 64), 37).string);
+
+puts("overlap " ~ "aaaa".count("aa").string ~ " " ~ "aaa".count("aa").string ~ " " ~ "abababa".count("aba").string);
+puts("overlap " ~ "aaa".replace("aa", "b") ~ " " ~ "abababa".replace("aba", "X") ~ " " ~ "aaaaa".replace("aa", "b", 1));
+
+puts("empty " ~ "ab".count("").string ~ " " ~ "日本".count("").string ~ " " ~ "".count("").string);
+puts("empty " ~ "ab".replace("", "-") ~ " " ~ "日本".replace("", "-") ~ " " ~ "".replace("", "-") ~ " " ~ "abc".replace("", "-", 2));
+puts("empty " ~ "ab".find("").string ~ " " ~ "ab".find("", 2).string);
@@ -0,0 +1,14 @@
+puts = native "puts" from "libc.so.6" declared "int" ("string8");
+
+pieces = "héé".split("");
+puts("pieces " ~ pieces.length);
+i = 0;
+while i < pieces.length
+{
+    puts("[" ~ pieces[i] ~ "]");
+    i = i + 1;
+}
+puts("ascii " ~ "abc".split("").length);
+puts("empty " ~ "".split("").length);
+puts("separator " ~ "a,é,,b".split(",").length);
+puts("mixed " ~ "日本語".split("")[1]);